@@ -30,6 +30,7 @@
 #   include "tests/itemtagstests.h"
 #endif
 
+#include <QAbstractItemModel>
 #include <QBoxLayout>
 #include <QColorDialog>
 #include <QLabel>
@@ -41,6 +42,8 @@
 #include <QtPlugin>
 #include <QUrl>
 
+#include <algorithm>
+
 Q_DECLARE_METATYPE(ItemTags::Tag)
 
 namespace {
@@ -49,6 +52,8 @@ const char mimeTags[] = "application/x-copyq-tags";
 
 const char configTags[] = "tags";
 
+const char tagFilterPrefix[] = "tag:";
+
 const char propertyColor[] = "CopyQ_color";
 
 namespace tagsTableColumns {
@@ -153,6 +158,11 @@ QStringList tags(const QVariantMap &itemData)
     return tags( itemData.value(mimeTags) );
 }
 
+QStringList tags(const QModelIndex &index)
+{
+    return tags( index.data(contentType::data).toMap() );
+}
+
 QString toScriptString(const QString &text)
 {
     return "decodeURIComponent('" + QUrl::toPercentEncoding(text) + "')";
@@ -560,6 +570,18 @@ bool ItemTagsScriptable::hasTag()
     return tags(row).contains(tagName);
 }
 
+QVariantList ItemTagsScriptable::rowsWithTag()
+{
+    const auto args = currentArguments();
+    const auto tagName = args.value(0).toString();
+    return queryTab("rowsWithTag", QVariantList() << tagName).toList();
+}
+
+QVariantMap ItemTagsScriptable::tagCounts()
+{
+    return queryTab("tagCounts").toMap();
+}
+
 QString ItemTagsScriptable::askTagName(const QString &dialogTitle, const QStringList &tags)
 {
     const auto value = call( "dialog", QVariantList()
@@ -625,6 +647,194 @@ bool ItemTagsScriptable::removeTag(const QString &tagName, QStringList *tags)
     return true;
 }
 
+void ItemTagsIndex::reset(const QAbstractItemModel &model)
+{
+    m_rowTags.clear();
+    m_tagCounts.clear();
+    m_tagRowsValid = false;
+    insertRows( model, 0, model.rowCount() - 1 );
+}
+
+void ItemTagsIndex::insertRows(const QAbstractItemModel &model, int start, int end)
+{
+    if (end < start)
+        return;
+
+    m_rowTags.insert( start, end - start + 1, QStringList() );
+    for (int row = start; row <= end; ++row) {
+        auto &rowTags = m_rowTags[row];
+        rowTags = tagsForRow(model, row);
+        addTagCounts(rowTags, 1);
+    }
+
+    m_tagRowsValid = false;
+}
+
+void ItemTagsIndex::removeRows(int start, int end)
+{
+    end = qMin(end, m_rowTags.size() - 1);
+    if (end < start)
+        return;
+
+    for (int row = start; row <= end; ++row)
+        addTagCounts(m_rowTags[row], -1);
+
+    m_rowTags.remove( start, end - start + 1 );
+    m_tagRowsValid = false;
+}
+
+void ItemTagsIndex::moveRows(int start, int end, int destinationRow)
+{
+    const int count = end - start + 1;
+    if ( count <= 0 || end >= m_rowTags.size() )
+        return;
+
+    const auto movedRows = m_rowTags.mid(start, count);
+    m_rowTags.remove(start, count);
+
+    // Destination row is position before the rows were removed.
+    const int targetRow = destinationRow > start ? destinationRow - count : destinationRow;
+    for (int i = 0; i < count; ++i)
+        m_rowTags.insert( targetRow + i, movedRows[i] );
+
+    m_tagRowsValid = false;
+}
+
+void ItemTagsIndex::updateRows(const QAbstractItemModel &model, int start, int end)
+{
+    end = qMin(end, m_rowTags.size() - 1);
+    for (int row = start; row <= end; ++row) {
+        auto rowTags = tagsForRow(model, row);
+        if (rowTags == m_rowTags[row])
+            continue;
+
+        addTagCounts(m_rowTags[row], -1);
+        addTagCounts(rowTags, 1);
+        m_rowTags[row] = rowTags;
+        m_tagRowsValid = false;
+    }
+}
+
+bool ItemTagsIndex::hasMatchingTag(int row, const QRegExp &re) const
+{
+    for ( const auto &tag : tags(row) ) {
+        if ( re.exactMatch(tag) )
+            return true;
+    }
+
+    return false;
+}
+
+QList<int> ItemTagsIndex::rowsWithTag(const QString &tagName) const
+{
+    if ( !m_tagCounts.contains(tagName) )
+        return QList<int>();
+
+    if (!m_tagRowsValid) {
+        m_tagRows.clear();
+        for (int row = 0; row < m_rowTags.size(); ++row) {
+            for ( const auto &tag : m_rowTags[row] )
+                m_tagRows[tag].append(row);
+        }
+        m_tagRowsValid = true;
+    }
+
+    return m_tagRows.value(tagName);
+}
+
+QStringList ItemTagsIndex::tagsForRow(const QAbstractItemModel &model, int row)
+{
+    return ::tags( model.index(row, 0) );
+}
+
+void ItemTagsIndex::addTagCounts(const QStringList &tags, int delta)
+{
+    for (const auto &tag : tags) {
+        auto it = m_tagCounts.find(tag);
+        if ( it == m_tagCounts.end() ) {
+            if (delta > 0)
+                m_tagCounts.insert(tag, delta);
+        } else {
+            it.value() += delta;
+            if (it.value() <= 0)
+                m_tagCounts.erase(it);
+        }
+    }
+}
+
+ItemTagsSaver::ItemTagsSaver(QAbstractItemModel *model, const ItemSaverPtr &saver)
+    : m_model(model)
+    , m_saver(saver)
+{
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             SLOT(onRowsInserted(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             SLOT(onRowsRemoved(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             SLOT(onRowsMoved(QModelIndex,int,int,QModelIndex,int)) );
+    connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             SLOT(onDataChanged(QModelIndex,QModelIndex)) );
+    connect( model, SIGNAL(modelReset()),
+             SLOT(onModelReset()) );
+    connect( model, SIGNAL(layoutChanged()),
+             SLOT(onModelReset()) );
+
+    m_index.reset(*model);
+}
+
+bool ItemTagsSaver::saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file)
+{
+    return m_saver->saveItems(tabName, model, file);
+}
+
+bool ItemTagsSaver::canRemoveItems(const QList<QModelIndex> &indexList, QString *error)
+{
+    return m_saver->canRemoveItems(indexList, error);
+}
+
+bool ItemTagsSaver::canMoveItems(const QList<QModelIndex> &indexList)
+{
+    return m_saver->canMoveItems(indexList);
+}
+
+void ItemTagsSaver::itemsRemovedByUser(const QList<QModelIndex> &indexList)
+{
+    m_saver->itemsRemovedByUser(indexList);
+}
+
+QVariantMap ItemTagsSaver::copyItem(const QAbstractItemModel &model, const QVariantMap &itemData)
+{
+    return m_saver->copyItem(model, itemData);
+}
+
+void ItemTagsSaver::onRowsInserted(const QModelIndex &, int start, int end)
+{
+    if (m_model)
+        m_index.insertRows(*m_model, start, end);
+}
+
+void ItemTagsSaver::onRowsRemoved(const QModelIndex &, int start, int end)
+{
+    m_index.removeRows(start, end);
+}
+
+void ItemTagsSaver::onRowsMoved(const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow)
+{
+    m_index.moveRows(start, end, destinationRow);
+}
+
+void ItemTagsSaver::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (m_model)
+        m_index.updateRows( *m_model, topLeft.row(), bottomRight.row() );
+}
+
+void ItemTagsSaver::onModelReset()
+{
+    if (m_model)
+        m_index.reset(*m_model);
+}
+
 ItemTagsLoader::ItemTagsLoader()
     : m_blockDataChange(false)
 {
@@ -703,12 +913,75 @@ ItemWidget *ItemTagsLoader::transform(ItemWidget *itemWidget, const QVariantMap
     return new ItemTags(itemWidget, tags);
 }
 
+ItemSaverPtr ItemTagsLoader::transformSaver(const ItemSaverPtr &saver, QAbstractItemModel *model)
+{
+    // Drop entries for removed tabs.
+    for (auto it = m_tagsSavers.begin(); it != m_tagsSavers.end(); ) {
+        if ( it.value().isNull() )
+            it = m_tagsSavers.erase(it);
+        else
+            ++it;
+    }
+
+    const auto tagsSaver = std::make_shared<ItemTagsSaver>(model, saver);
+    m_tagsSavers.insert(model, tagsSaver.get());
+    return tagsSaver;
+}
+
 bool ItemTagsLoader::matches(const QModelIndex &index, const QRegExp &re) const
 {
-    const QByteArray tagsData =
-            index.data(contentType::data).toMap().value(mimeTags).toByteArray();
-    const auto tags = getTextData(tagsData);
-    return re.indexIn(tags) != -1;
+    const auto tagsIndex = this->tagsIndex( index.model() );
+
+    // Filter "tag:NAME" matches items with tag NAME.
+    const auto pattern = re.pattern();
+    if ( pattern.startsWith(tagFilterPrefix) ) {
+        const QRegExp tagRe(
+                    pattern.mid( static_cast<int>(sizeof(tagFilterPrefix)) - 1 ),
+                    re.caseSensitivity(), re.patternSyntax() );
+
+        if (tagsIndex)
+            return tagsIndex->hasMatchingTag( index.row(), tagRe );
+
+        for ( const auto &tag : ::tags(index) ) {
+            if ( tagRe.exactMatch(tag) )
+                return true;
+        }
+        return false;
+    }
+
+    const auto tags = tagsIndex
+            ? tagsIndex->tags( index.row() ).join(",")
+            : ::tags(index).join(",");
+    return !tags.isEmpty() && re.indexIn(tags) != -1;
+}
+
+QVariant ItemTagsLoader::queryTab(
+        const QAbstractItemModel &model, const QString &query, const QVariantList &arguments) const
+{
+    // Index is missing only if the tab was loaded before enabling the plugin.
+    ItemTagsIndex newIndex;
+    auto index = tagsIndex(&model);
+    if (!index) {
+        newIndex.reset(model);
+        index = &newIndex;
+    }
+
+    if (query == "rowsWithTag") {
+        QVariantList rows;
+        for ( int row : index->rowsWithTag(arguments.value(0).toString()) )
+            rows.append(row);
+        return rows;
+    }
+
+    if (query == "tagCounts") {
+        QVariantMap counts;
+        const auto &tagCounts = index->tagCounts();
+        for (auto it = tagCounts.constBegin(); it != tagCounts.constEnd(); ++it)
+            counts.insert( it.key(), it.value() );
+        return counts;
+    }
+
+    return QVariant();
 }
 
 QObject *ItemTagsLoader::tests(const TestInterfacePtr &test) const
@@ -744,7 +1017,27 @@ QVector<Command> ItemTagsLoader::commands() const
     QVector<Command> commands;
 
     if (m_tags.isEmpty()) {
-        addTagCommands(tr("Important", "Tag name for example command"), QString(), &commands);
+        // Offer commands for tags already used in tabs (most used first).
+        QHash<QString, int> tagCounts;
+        for (const auto &saver : m_tagsSavers) {
+            if (!saver)
+                continue;
+            const auto &counts = saver->index().tagCounts();
+            for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+                tagCounts[it.key()] += it.value();
+        }
+
+        auto usedTags = tagCounts.keys();
+        std::sort( usedTags.begin(), usedTags.end(), [&](const QString &lhs, const QString &rhs) {
+            return tagCounts.value(lhs) > tagCounts.value(rhs);
+        });
+
+        if ( usedTags.isEmpty() )
+            usedTags.append( tr("Important", "Tag name for example command") );
+
+        const int maxTagCommands = 10;
+        for ( const auto &tagName : usedTags.mid(0, maxTagCommands) )
+            addTagCommands(tagName, QString(), &commands);
     } else {
         for (const auto &tag : m_tags)
             addTagCommands(tag.name, tag.match, &commands);
@@ -902,6 +1195,12 @@ void ItemTagsLoader::addTagToSettingsTable(const ItemTagsLoader::Tag &tag)
     onTableWidgetItemChanged(t->item(row, 0));
 }
 
+const ItemTagsIndex *ItemTagsLoader::tagsIndex(const QAbstractItemModel *model) const
+{
+    const auto saver = m_tagsSavers.value(model);
+    return saver && saver->model() == model ? &saver->index() : nullptr;
+}
+
 ItemTagsLoader::Tag ItemTagsLoader::tagFromTable(int row)
 {
     QTableWidget *t = ui->tableWidget;
@@ -23,6 +23,8 @@
 #include "gui/icons.h"
 #include "item/itemwidget.h"
 
+#include <QHash>
+#include <QPointer>
 #include <QVariant>
 #include <QVector>
 #include <QWidget>
@@ -103,6 +105,8 @@ public slots:
     void untag();
     void clearTags();
     bool hasTag();
+    QVariantList rowsWithTag();
+    QVariantMap tagCounts();
 
 private:
     QString askTagName(const QString &dialogTitle, const QStringList &tags);
@@ -116,6 +120,78 @@ private:
     QStringList m_userTags;
 };
 
+/**
+ * Tags of items in a model.
+ *
+ * Keeps tags for each row and number of items for each tag so that items can be
+ * filtered and counted by tag without reading and decoding item data again.
+ */
+class ItemTagsIndex
+{
+public:
+    void reset(const QAbstractItemModel &model);
+
+    void insertRows(const QAbstractItemModel &model, int start, int end);
+    void removeRows(int start, int end);
+    void moveRows(int start, int end, int destinationRow);
+    void updateRows(const QAbstractItemModel &model, int start, int end);
+
+    QStringList tags(int row) const { return m_rowTags.value(row); }
+
+    /** Return true if any tag for row matches @a re exactly. */
+    bool hasMatchingTag(int row, const QRegExp &re) const;
+
+    QList<int> rowsWithTag(const QString &tagName) const;
+
+    const QHash<QString, int> &tagCounts() const { return m_tagCounts; }
+
+private:
+    static QStringList tagsForRow(const QAbstractItemModel &model, int row);
+
+    void addTagCounts(const QStringList &tags, int delta);
+
+    QVector<QStringList> m_rowTags;
+    QHash<QString, int> m_tagCounts;
+
+    // Rows for tags, rebuilt on first query after rows change.
+    mutable QHash<QString, QList<int>> m_tagRows;
+    mutable bool m_tagRowsValid = false;
+};
+
+class ItemTagsSaver : public QObject, public ItemSaverInterface
+{
+    Q_OBJECT
+
+public:
+    ItemTagsSaver(QAbstractItemModel *model, const ItemSaverPtr &saver);
+
+    bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file) override;
+
+    bool canRemoveItems(const QList<QModelIndex> &indexList, QString *error) override;
+
+    bool canMoveItems(const QList<QModelIndex> &indexList) override;
+
+    void itemsRemovedByUser(const QList<QModelIndex> &indexList) override;
+
+    QVariantMap copyItem(const QAbstractItemModel &model, const QVariantMap &itemData) override;
+
+    const QAbstractItemModel *model() const { return m_model; }
+
+    const ItemTagsIndex &index() const { return m_index; }
+
+private slots:
+    void onRowsInserted(const QModelIndex &parent, int start, int end);
+    void onRowsRemoved(const QModelIndex &parent, int start, int end);
+    void onRowsMoved(const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onModelReset();
+
+private:
+    QPointer<QAbstractItemModel> m_model;
+    ItemSaverPtr m_saver;
+    ItemTagsIndex m_index;
+};
+
 class ItemTagsLoader : public QObject, public ItemLoaderInterface
 {
     Q_OBJECT
@@ -142,8 +218,13 @@ public:
 
     ItemWidget *transform(ItemWidget *itemWidget, const QVariantMap &data) override;
 
+    ItemSaverPtr transformSaver(const ItemSaverPtr &saver, QAbstractItemModel *model) override;
+
     bool matches(const QModelIndex &index, const QRegExp &re) const override;
 
+    QVariant queryTab(
+            const QAbstractItemModel &model, const QString &query, const QVariantList &arguments) const override;
+
     QObject *tests(const TestInterfacePtr &test) const override;
 
     const QObject *signaler() const override { return this; }
@@ -172,11 +253,15 @@ private:
 
     Tag tagFromTable(int row);
 
+    const ItemTagsIndex *tagsIndex(const QAbstractItemModel *model) const;
+
     QVariantMap m_settings;
     Tags m_tags;
     std::unique_ptr<Ui::ItemTagsSettings> ui;
 
     bool m_blockDataChange;
+
+    QHash<const QAbstractItemModel*, QPointer<ItemTagsSaver>> m_tagsSavers;
 };
 
 #endif // ITEMTAGS_H
@@ -215,6 +215,39 @@ void ItemTagsTests::searchTags()
     RUN(args << "testSelected", tab1 + " 2 2\n");
 }
 
+void ItemTagsTests::searchTagFilter()
+{
+    const QString tab1 = testTab(1);
+    const Args args = Args() << "tab" << tab1;
+    RUN(args << "add" << "A" << "tag1" << "C", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('tag1', 0)", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('tag12', 2)", "");
+
+    RUN(args << "keys" << "RIGHT", "");
+    RUN(args << "keys" << ":tag:tag1", "");
+    RUN(args << "keys" << "TAB" << "CTRL+A", "");
+    RUN(args << "testSelected", tab1 + " 0 0\n");
+}
+
+void ItemTagsTests::rowsWithTag()
+{
+    const QString tab1 = testTab(1);
+    const Args args = Args() << "tab" << tab1;
+    RUN(args << "-e" << "plugins.itemtags.rowsWithTag('x')", "");
+    RUN(args << "add" << "A" << "B" << "C" << "D", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('x', 0, 2)", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('y', 1, 2, 3)", "");
+    RUN(args << "-e" << "plugins.itemtags.rowsWithTag('x')", "0\n2\n");
+    RUN(args << "-e" << "plugins.itemtags.rowsWithTag('y')", "1\n2\n3\n");
+    RUN(args << "-e" << "plugins.itemtags.rowsWithTag('z')", "");
+
+    RUN(args << "-e" << "var c = plugins.itemtags.tagCounts(); print(c.x + ',' + c.y)", "2,3");
+
+    RUN(args << "remove" << "0", "");
+    RUN(args << "-e" << "plugins.itemtags.rowsWithTag('x')", "1\n");
+    RUN(args << "-e" << "plugins.itemtags.tagCounts().x", "1\n");
+}
+
 void ItemTagsTests::tagSelected()
 {
     const auto script = R"(
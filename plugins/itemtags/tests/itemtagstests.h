@@ -43,6 +43,8 @@ private slots:
     void untag();
     void clearTags();
     void searchTags();
+    void searchTagFilter();
+    void rowsWithTag();
 
     void tagSelected();
     void untagSelected();
@@ -18,11 +18,16 @@
 */
 
 #include "itemtext.h"
+#include "textpreview.h"
 #include "ui_itemtextsettings.h"
 
 #include "common/mimetypes.h"
 #include "common/textdata.h"
 
+#ifdef HAS_TESTS
+#   include "tests/itemtexttests.h"
+#endif
+
 #include <QAbstractTextDocumentLayout>
 #include <QCoreApplication>
 #include <QContextMenuEvent>
@@ -35,6 +40,8 @@
 #include <QTextDocument>
 #include <QtPlugin>
 
+#include <cstring>
+
 namespace {
 
 // Limit number of characters for performance reasons.
@@ -48,6 +55,9 @@ const int maxLineLengthInPreview = 16 * maxLineLength;
 const int maxLineCount = 4 * 1024;
 const int maxLineCountInPreview = 16 * maxLineCount;
 
+// Longer HTML entities are not expected when truncating HTML.
+const int maxHtmlEntitySize = 10;
+
 const char optionUseRichText[] = "use_rich_text";
 const char optionMaximumLines[] = "max_lines";
 const char optionMaximumHeight[] = "max_height";
@@ -62,34 +72,36 @@ void removeTrailingNull(QString *text)
         text->chop(1);
 }
 
-bool getRichText(const QVariantMap &dataMap, QString *text)
+int sizeWithoutTrailingNull(const QByteArray &bytes)
 {
-    if ( dataMap.contains(mimeHtml) ) {
-        *text = getTextData(dataMap, mimeHtml);
-        return true;
-    }
+    return bytes.endsWith('\0') ? bytes.size() - 1 : bytes.size();
+}
 
-    if ( dataMap.contains(mimeRichText) ) {
-        *text = getTextData(dataMap, mimeRichText);
-        return true;
-    }
+QByteArray getRichTextData(const QVariantMap &dataMap)
+{
+    if ( dataMap.contains(mimeHtml) )
+        return dataMap.value(mimeHtml).toByteArray();
 
-    return false;
+    return dataMap.value(mimeRichText).toByteArray();
 }
 
-bool getText(const QVariantMap &dataMap, QString *text)
+bool hasRichText(const QVariantMap &dataMap)
 {
-    if ( dataMap.contains(mimeText) ) {
-        *text = getTextData(dataMap, mimeText);
-        return true;
-    }
+    return dataMap.contains(mimeHtml) || dataMap.contains(mimeRichText);
+}
 
-    if ( dataMap.contains(mimeUriList) ) {
-        *text = getTextData(dataMap, mimeUriList);
-        return true;
-    }
+QByteArray getPlainTextData(const QVariantMap &dataMap, bool *ok)
+{
+    *ok = true;
+
+    if ( dataMap.contains(mimeText) )
+        return dataMap.value(mimeText).toByteArray();
+
+    if ( dataMap.contains(mimeUriList) )
+        return dataMap.value(mimeUriList).toByteArray();
 
-    return false;
+    *ok = false;
+    return QByteArray();
 }
 
 QString normalizeText(QString text)
@@ -98,6 +110,39 @@ QString normalizeText(QString text)
     return text.left(maxCharacters);
 }
 
+bool isUtf8ContinuationByte(char c)
+{
+    return (static_cast<uchar>(c) & 0xC0) == 0x80;
+}
+
+bool isVoidHtmlElement(const QByteArray &name)
+{
+    static const QList<QByteArray> voidElements = QList<QByteArray>()
+            << "area" << "base" << "br" << "col" << "embed" << "hr" << "img"
+            << "input" << "link" << "meta" << "param" << "source" << "track"
+            << "wbr";
+    return voidElements.contains(name);
+}
+
+/// Returns index of '>' closing tag starting at @a start (skips quoted attribute values).
+int htmlTagEnd(const QByteArray &html, int start, int maxSize)
+{
+    char quote = '\0';
+    for (int i = start + 1; i < maxSize; ++i) {
+        const char c = html.at(i);
+        if (quote != '\0') {
+            if (c == quote)
+                quote = '\0';
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
 void insertEllipsis(QTextCursor *tc)
 {
     tc->insertHtml( " &nbsp;"
@@ -108,10 +153,110 @@ void insertEllipsis(QTextCursor *tc)
 
 } // namespace
 
-ItemText::ItemText(const QString &text, const QString &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent)
+QByteArray truncatedHtml(const QByteArray &html, int maxSize, bool *truncated)
+{
+    const int size = sizeWithoutTrailingNull(html);
+    *truncated = size > maxSize;
+    if (!*truncated)
+        return html.left(size);
+
+    QList<QByteArray> openElements;
+    int safeEnd = 0;
+    int i = 0;
+
+    while (i < maxSize) {
+        const char c = html.at(i);
+        if (c == '<') {
+            if ( html.mid(i, 4) == "<!--" ) {
+                const int commentEnd = html.indexOf("-->", i + 4);
+                if (commentEnd == -1 || commentEnd + 3 > maxSize)
+                    break;
+                i = commentEnd + 3;
+            } else {
+                const int tagEnd = htmlTagEnd(html, i, maxSize);
+                if (tagEnd == -1)
+                    break;
+
+                const bool isClosing = html.at(i + 1) == '/';
+                int nameEnd = i + (isClosing ? 2 : 1);
+                while ( nameEnd < tagEnd && QChar::fromLatin1(html.at(nameEnd)).isLetterOrNumber() )
+                    ++nameEnd;
+                const int nameStart = i + (isClosing ? 2 : 1);
+                const QByteArray name = html.mid(nameStart, nameEnd - nameStart).toLower();
+
+                if ( name.isEmpty() ) {
+                    // Doctype or processing instruction.
+                } else if (isClosing) {
+                    const int j = openElements.lastIndexOf(name);
+                    if (j != -1)
+                        openElements.erase( openElements.begin() + j, openElements.end() );
+                } else if ( html.at(tagEnd - 1) != '/' && !isVoidHtmlElement(name) ) {
+                    openElements.append(name);
+                }
+
+                i = tagEnd + 1;
+            }
+            safeEnd = i;
+        } else if (c == '&') {
+            int entityEnd = i + 1;
+            while ( entityEnd < maxSize && entityEnd - i <= maxHtmlEntitySize && html.at(entityEnd) != ';' )
+                ++entityEnd;
+            if (entityEnd >= maxSize)
+                break;
+            i = html.at(entityEnd) == ';' ? entityEnd + 1 : i + 1;
+            safeEnd = i;
+        } else {
+            ++i;
+            if ( !isUtf8ContinuationByte(html.at(i)) )
+                safeEnd = i;
+        }
+    }
+
+    QByteArray result = html.left(safeEnd);
+    for (int j = openElements.size() - 1; j >= 0; --j)
+        result.append("</" + openElements[j] + ">");
+
+    return result;
+}
+
+QString textPreview(const QByteArray &bytes, int maxLines, int lineLength, bool *truncated)
+{
+    const char *data = bytes.constData();
+    const int size = sizeWithoutTrailingNull(bytes);
+    const int maxLineBytes = lineLength > 0 ? 4 * (lineLength + 1) : size;
+
+    QString text;
+    int start = 0;
+    for (int line = 0; start < size; ++line) {
+        if ( (maxLines > 0 && line > maxLines) || text.size() >= maxCharacters )
+            break;
+
+        const auto lineEnd = static_cast<const char*>(
+                    std::memchr(data + start, '\n', static_cast<size_t>(size - start)) );
+        const int end = lineEnd ? static_cast<int>(lineEnd - data) + 1 : size;
+
+        if (end - start > maxLineBytes) {
+            // Decode only beginning of long line.
+            text.append( QString::fromUtf8(data + start, maxLineBytes).left(lineLength + 1) );
+            if (lineEnd)
+                text.append('\n');
+        } else {
+            text.append( QString::fromUtf8(data + start, end - start) );
+        }
+
+        start = end;
+    }
+
+    *truncated = start < size;
+    return text.left(maxCharacters);
+}
+
+ItemText::ItemText(const QByteArray &text, const QByteArray &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent)
     : QTextEdit(parent)
     , ItemWidget(this)
     , m_textDocument()
+    , m_textData(text)
+    , m_richTextData(richText)
     , m_maximumHeight(maximumHeight)
 {
     m_textDocument.setDefaultFont(font());
@@ -126,14 +271,20 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
 
     setContextMenuPolicy(Qt::NoContextMenu);
 
+    // Parse and lay out only the part of the text which can be visible.
     if ( !richText.isEmpty() ) {
-        m_textDocument.setHtml(richText);
+        const int maxHtmlSize = maxLines > 0 && lineLength > 0
+                ? static_cast<int>( qMin<qint64>(maxCharacters, 4LL * maxLines * lineLength) )
+                : maxCharacters;
+        m_textDocument.setHtml( getTextData(truncatedHtml(richText, maxHtmlSize, &m_isTruncated)) );
         // Use plain text instead if rendering HTML fails or result is empty.
         m_isRichText = !m_textDocument.isEmpty();
     }
 
-    if (!m_isRichText)
-        m_textDocument.setPlainText(text);
+    if (!m_isRichText) {
+        m_richTextData.clear();
+        m_textDocument.setPlainText( textPreview(text, maxLines, lineLength, &m_isTruncated) );
+    }
 
     m_textDocument.setDocumentMargin(0);
 
@@ -144,7 +295,8 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
             tc.setPosition(block.position() - 1);
             tc.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
 
-            m_elidedFragment = tc.selection();
+            if (!m_isTruncated)
+                m_elidedFragment = tc.selection();
             tc.removeSelectedText();
 
             m_ellipsisPosition = tc.position();
@@ -152,13 +304,26 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
         }
     }
 
+    if (m_isTruncated && m_ellipsisPosition == -1) {
+        QTextCursor tc(&m_textDocument);
+        tc.movePosition(QTextCursor::End);
+        m_ellipsisPosition = tc.position();
+        insertEllipsis(&tc);
+    }
+
     if (lineLength > 0) {
         for ( auto block = m_textDocument.begin(); block.isValid(); block = block.next() ) {
             if ( block.length() > lineLength ) {
+                const int start = block.position() + lineLength;
+                const int end = block.position() + block.length() - 1;
                 QTextCursor tc(&m_textDocument);
-                tc.setPosition(block.position() + lineLength);
-                tc.setPosition(block.position() + block.length() - 1, QTextCursor::KeepAnchor);
+                tc.setPosition(start);
+                tc.setPosition(end, QTextCursor::KeepAnchor);
                 insertEllipsis(&tc);
+
+                // Keep position of the expandable ellipsis if it was replaced or moved.
+                if (m_ellipsisPosition > start)
+                    m_ellipsisPosition = m_ellipsisPosition <= end ? start : m_ellipsisPosition + tc.position() - end;
             }
         }
     }
@@ -265,6 +430,11 @@ void ItemText::onSelectionChanged()
     if ( m_ellipsisPosition == -1 || textCursor().selectionEnd() <= m_ellipsisPosition )
         return;
 
+    if (m_isTruncated) {
+        loadFullText();
+        return;
+    }
+
     QTextCursor tc(&m_textDocument);
     tc.setPosition(m_ellipsisPosition);
     m_ellipsisPosition = -1;
@@ -274,6 +444,30 @@ void ItemText::onSelectionChanged()
     m_elidedFragment = QTextDocumentFragment();
 }
 
+void ItemText::loadFullText()
+{
+    const auto oldCursor = textCursor();
+    const int anchor = oldCursor.anchor();
+    const int position = oldCursor.position();
+
+    m_isTruncated = false;
+    m_ellipsisPosition = -1;
+    m_elidedFragment = QTextDocumentFragment();
+
+    if (m_isRichText) {
+        bool truncated;
+        m_textDocument.setHtml( getTextData(truncatedHtml(m_richTextData, maxCharacters, &truncated)) );
+    } else {
+        m_textDocument.setPlainText( normalizeText(getTextData(m_textData)) );
+    }
+
+    // Keep selection which was all in the preview part of the text.
+    QTextCursor tc(&m_textDocument);
+    tc.setPosition(anchor);
+    tc.setPosition(position, QTextCursor::KeepAnchor);
+    setTextCursor(tc);
+}
+
 ItemTextLoader::ItemTextLoader()
 {
 }
@@ -285,19 +479,17 @@ ItemWidget *ItemTextLoader::create(const QVariantMap &data, QWidget *parent, boo
     if ( data.value(mimeHidden).toBool() )
         return nullptr;
 
-    QString richText;
+    // Text is decoded in ItemText only as far as needed.
     const bool isRichText = m_settings.value(optionUseRichText, true).toBool()
-            && getRichText(data, &richText);
+            && hasRichText(data);
+    const QByteArray richText = isRichText ? getRichTextData(data) : QByteArray();
 
-    QString text;
-    const bool isPlainText = getText(data, &text);
+    bool isPlainText;
+    const QByteArray text = getPlainTextData(data, &isPlainText);
 
     if (!isRichText && !isPlainText)
         return nullptr;
 
-    richText = normalizeText(richText);
-    text = normalizeText(text);
-
     ItemText *item = nullptr;
     // Always limit text size for performance reasons.
     if (preview) {
@@ -340,4 +532,15 @@ QWidget *ItemTextLoader::createSettingsWidget(QWidget *parent)
     return w;
 }
 
+QObject *ItemTextLoader::tests(const TestInterfacePtr &test) const
+{
+#ifdef HAS_TESTS
+    QObject *tests = new ItemTextTests(test);
+    return tests;
+#else
+    Q_UNUSED(test);
+    return nullptr;
+#endif
+}
+
 Q_EXPORT_PLUGIN2(itemtext, ItemTextLoader)
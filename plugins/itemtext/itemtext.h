@@ -38,7 +38,12 @@ class ItemText : public QTextEdit, public ItemWidget
     Q_OBJECT
 
 public:
-    ItemText(const QString &text, const QString &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent);
+    /**
+     * Shows preview of UTF-8 encoded plain text or HTML.
+     *
+     * Whole text is parsed only when the ellipsis at the end is selected.
+     */
+    ItemText(const QByteArray &text, const QByteArray &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent);
 
 protected:
     void highlight(const QRegExp &re, const QFont &highlightFont,
@@ -54,11 +59,17 @@ private slots:
     void onSelectionChanged();
 
 private:
+    void loadFullText();
+
     QTextDocument m_textDocument;
     QTextDocumentFragment m_elidedFragment;
+    QByteArray m_textData;
+    QByteArray m_richTextData;
     int m_ellipsisPosition = -1;
     int m_maximumHeight;
     bool m_isRichText = false;
+    /// Only beginning of the text was loaded.
+    bool m_isTruncated = false;
 };
 
 class ItemTextLoader : public QObject, public ItemLoaderInterface
@@ -87,6 +98,8 @@ public:
 
     QWidget *createSettingsWidget(QWidget *parent) override;
 
+    QObject *tests(const TestInterfacePtr &test) const override;
+
 private:
     QVariantMap m_settings;
     std::unique_ptr<Ui::ItemTextSettings> ui;
@@ -1,9 +1,14 @@
 include(../plugins_common.pri)
 
-HEADERS += itemtext.h
+HEADERS += itemtext.h \
+    textpreview.h
 SOURCES += itemtext.cpp \
     ../../src/common/mimetypes.cpp \
     ../../src/common/textdata.cpp
 FORMS   += itemtextsettings.ui
 TARGET   = $$qtLibraryTarget(itemtext)
 
+CONFIG(debug, debug|release) {
+    SOURCES += tests/itemtexttests.cpp
+    HEADERS += tests/itemtexttests.h
+}
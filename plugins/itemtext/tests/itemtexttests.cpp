@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemtexttests.h"
+
+#include "itemtext.h"
+#include "textpreview.h"
+
+#include "tests/test_utils.h"
+
+namespace {
+
+QByteArray truncated(const QByteArray &html, int maxSize)
+{
+    bool isTruncated;
+    const QByteArray result = truncatedHtml(html, maxSize, &isTruncated);
+    return isTruncated ? result : "NOT TRUNCATED: " + result;
+}
+
+QString preview(const QByteArray &text, int maxLines, int lineLength)
+{
+    bool isTruncated;
+    const QString result = textPreview(text, maxLines, lineLength, &isTruncated);
+    return isTruncated ? result + "[TRUNCATED]" : result;
+}
+
+/// Selecting the ellipsis loads whole text.
+QString expandedText(ItemText *item)
+{
+    item->selectAll();
+    return item->toPlainText();
+}
+
+} // namespace
+
+ItemTextTests::ItemTextTests(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+void ItemTextTests::initTestCase()
+{
+    TEST(m_test->initTestCase());
+}
+
+void ItemTextTests::cleanupTestCase()
+{
+    TEST(m_test->cleanupTestCase());
+}
+
+void ItemTextTests::init()
+{
+    TEST(m_test->init());
+}
+
+void ItemTextTests::cleanup()
+{
+    TEST( m_test->cleanup() );
+}
+
+void ItemTextTests::truncateHtmlShort()
+{
+    QCOMPARE( truncated("<b>abc</b>", 10), QByteArray("NOT TRUNCATED: <b>abc</b>") );
+    QCOMPARE( truncated(QByteArray("abc\0", 4), 3), QByteArray("NOT TRUNCATED: abc") );
+}
+
+void ItemTextTests::truncateHtmlAtTag()
+{
+    const QByteArray html = "<b>bold</b> text";
+    QCOMPARE( truncated(html, 1), QByteArray() );
+    QCOMPARE( truncated(html, 5), QByteArray("<b>bo</b>") );
+    QCOMPARE( truncated(html, 9), QByteArray("<b>bold</b>") );
+    QCOMPARE( truncated(html, 12), QByteArray("<b>bold</b> ") );
+
+    // Void elements are not closed.
+    QCOMPARE( truncated("<div><p>a<br>b</p><p>c</p></div>", 14),
+              QByteArray("<div><p>a<br>b</p></div>") );
+    QCOMPARE( truncated("<p>a<img src=x/><hr/>b</p>", 22),
+              QByteArray("<p>a<img src=x/><hr/>b</p>") );
+}
+
+void ItemTextTests::truncateHtmlAtEntity()
+{
+    const QByteArray html = "a &amp; b";
+    QCOMPARE( truncated(html, 4), QByteArray("a ") );
+    QCOMPARE( truncated(html, 6), QByteArray("a ") );
+    QCOMPARE( truncated(html, 7), QByteArray("a &amp;") );
+
+    // Ampersand without semicolon is not an entity.
+    QCOMPARE( truncated("a & b c d e f g h i j", 20), QByteArray("a & b c d e f g h i ") );
+}
+
+void ItemTextTests::truncateHtmlAtComment()
+{
+    const QByteArray html = "<!-- <b> a > b -->text";
+    QCOMPARE( truncated(html, 10), QByteArray() );
+    QCOMPARE( truncated(html, 17), QByteArray() );
+    QCOMPARE( truncated(html, 20), QByteArray("<!-- <b> a > b -->te") );
+}
+
+void ItemTextTests::truncateHtmlAttributeWithGreaterThan()
+{
+    const QByteArray html = "<a title=\"x > y\">link</a> more";
+    QCOMPARE( truncated(html, 14), QByteArray() );
+    QCOMPARE( truncated(html, 20), QByteArray("<a title=\"x > y\">lin</a>") );
+
+    QCOMPARE( truncated("<a title='>'>x</a>!", 11), QByteArray() );
+    QCOMPARE( truncated("<a title='>'>x</a>!", 14), QByteArray("<a title='>'>x</a>") );
+}
+
+void ItemTextTests::truncateHtmlAtMultiByteCharacter()
+{
+    // "<p>á€</p>"
+    const QByteArray html = "<p>\xc3\xa1\xe2\x82\xac</p>";
+    QCOMPARE( truncated(html, 4), QByteArray("<p></p>") );
+    QCOMPARE( truncated(html, 5), QByteArray("<p>\xc3\xa1</p>") );
+    QCOMPARE( truncated(html, 7), QByteArray("<p>\xc3\xa1</p>") );
+    QCOMPARE( truncated(html, 8), QByteArray("<p>\xc3\xa1\xe2\x82\xac</p>") );
+}
+
+void ItemTextTests::previewLines()
+{
+    QCOMPARE( preview("a\nb", 2, 0), QString("a\nb") );
+    QCOMPARE( preview("a\nb\nc", 2, 0), QString("a\nb\nc") );
+    QCOMPARE( preview("a\nb\nc\nd", 2, 0), QString("a\nb\nc\n[TRUNCATED]") );
+    QCOMPARE( preview(QByteArray("a\nb\0", 4), 2, 0), QString("a\nb") );
+}
+
+void ItemTextTests::previewLongLines()
+{
+    QCOMPARE( preview("abcdefghij\nxyz", 0, 1), QString("ab\nxyz") );
+    QCOMPARE( preview("xyz\nabcdefghij", 0, 1), QString("xyz\nab") );
+}
+
+void ItemTextTests::previewMultiByteCharacterAtCut()
+{
+    // Only first 8 bytes of the line are decoded.
+    const QByteArray text = "\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac";
+    QCOMPARE( preview(text, 0, 1), QString::fromUtf8("\xe2\x82\xac\xe2\x82\xac") );
+    QCOMPARE( preview(text, 0, 2), QString::fromUtf8(text) );
+}
+
+void ItemTextTests::expandPlainText()
+{
+    ItemText item("1\n2\n3\n4\n5", QByteArray(), 2, 0, 0, nullptr);
+    QVERIFY( !item.toPlainText().contains('3') );
+    QVERIFY( item.toPlainText().contains(QChar(0x2026)) );
+    QCOMPARE( expandedText(&item), QString("1\n2\n3\n4\n5") );
+}
+
+void ItemTextTests::expandElidedLines()
+{
+    // Whole text is decoded but only two lines are shown.
+    ItemText item("1\n2\n3", QByteArray(), 2, 0, 0, nullptr);
+    QVERIFY( !item.toPlainText().contains('3') );
+    QCOMPARE( expandedText(&item), QString("1\n2\n3") );
+}
+
+void ItemTextTests::expandRichText()
+{
+    const QByteArray text(1000, 'a');
+    ItemText item(text, "<p>" + text + "</p>", 1, 100, 0, nullptr);
+    QVERIFY( item.toPlainText().size() < 200 );
+    QVERIFY( item.toPlainText().contains(QChar(0x2026)) );
+    QCOMPARE( expandedText(&item), QString(text) );
+}
@@ -0,0 +1,43 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXTPREVIEW_H
+#define TEXTPREVIEW_H
+
+class QByteArray;
+class QString;
+
+/**
+ * Returns at most @a maxSize bytes from beginning of HTML (plus closing tags).
+ *
+ * Tags, comments, entities and UTF-8 sequences are not split and elements
+ * left open are closed.
+ */
+QByteArray truncatedHtml(const QByteArray &html, int maxSize, bool *truncated);
+
+/**
+ * Decodes only lines and characters from the beginning of text
+ * which are needed for preview.
+ *
+ * Returns one extra line and one extra character per line if the text is
+ * longer so that ellipsis can be shown.
+ */
+QString textPreview(const QByteArray &bytes, int maxLines, int lineLength, bool *truncated);
+
+#endif // TEXTPREVIEW_H
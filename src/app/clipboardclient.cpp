@@ -19,15 +19,18 @@
 
 #include "clipboardclient.h"
 
+#include "common/builtincommand.h"
 #include "common/client_server.h"
 #include "common/commandstatus.h"
 #include "common/commandstore.h"
 #include "common/log.h"
+#include "common/textdata.h"
 #include "platform/platformnativeinterface.h"
 #include "scriptable/scriptable.h"
 #include "scriptable/scriptableproxy.h"
 
 #include <QApplication>
+#include <QDir>
 #include <QFile>
 #include <QScriptEngine>
 #include <QSettings>
@@ -50,11 +53,17 @@ QString messageCodeToString(int code)
         return "CommandPrint";
     case CommandFunctionCallReturnValue:
         return "CommandFunctionCallReturnValue";
+    case CommandBuiltInCallRejected:
+        return "CommandBuiltInCallRejected";
+    case CommandReadInput:
+        return "CommandReadInput";
     default:
         return QString("Unknown(%1)").arg(code);
     }
 }
 
+const qint64 inputChunkSize = 512 * 1024;
+
 void printClientStdout(const QByteArray &output)
 {
     QFile f;
@@ -101,6 +110,20 @@ ClipboardClient::ClipboardClient(int &argc, char **argv, const QStringList &argu
     , App("Client", createClientApplication(argc, argv, arguments), sessionName)
     , m_inputReaderThread(nullptr)
 {
+    // Standard input is streamed to server by script (see startInputStream()).
+    const QStringList builtInCallArguments = QStringList("copyq") + arguments;
+    if ( !arguments.contains("-") && isBuiltInCommand(builtInCallArguments) ) {
+        startClientSocket(clipboardServerName());
+        startBuiltInCall(builtInCallArguments);
+        return;
+    }
+
+    if ( arguments.value(0) == "--in-server" ) {
+        startClientSocket(clipboardServerName());
+        startScriptCall( arguments.mid(1) );
+        return;
+    }
+
     restoreSettings();
 
     startClientSocket(clipboardServerName());
@@ -144,6 +167,19 @@ void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
         emit functionCallResultReceived(data);
         break;
 
+    case CommandBuiltInCallRejected:
+        if ( !m_builtInCallArguments.isEmpty() ) {
+            const auto arguments = m_builtInCallArguments.mid(1);
+            m_builtInCallArguments.clear();
+            restoreSettings();
+            start(arguments);
+        }
+        break;
+
+    case CommandReadInput:
+        startInputReader();
+        break;
+
     default:
         log( "Unhandled message: " + messageCodeToString(messageCode), LogError );
         break;
@@ -177,7 +213,12 @@ void ClipboardClient::setInput(const QByteArray &input)
 
 void ClipboardClient::sendInput()
 {
-    if ( !wasClosed() )
+    if ( wasClosed() )
+        return;
+
+    if (m_scriptInServer)
+        sendMessage(m_input, CommandInput);
+    else
         emit inputReceived(m_input);
 }
 
@@ -188,9 +229,9 @@ void ClipboardClient::exit(int exitCode)
     App::exit(exitCode);
 }
 
-void ClipboardClient::sendFunctionCall(const QByteArray &bytes)
+void ClipboardClient::sendFunctionCall(const QByteArray &bytes, int messageCode)
 {
-    sendMessage(bytes, CommandFunctionCall);
+    sendMessage(bytes, messageCode);
 
     QEventLoop loop;
     connect(this, SIGNAL(functionCallResultReceived(QByteArray)), &loop, SLOT(quit()));
@@ -217,6 +258,22 @@ void ClipboardClient::startInputReader()
     m_inputReaderThread->start();
 }
 
+void ClipboardClient::startInputStream()
+{
+    if ( wasClosed() || m_inputReaderThread )
+        return;
+
+    // Only single chunk is kept in memory; sending waits for server to process it.
+    QFile in;
+    in.open(stdin, QIODevice::ReadOnly);
+    while ( !wasClosed() ) {
+        const QByteArray chunk = in.read(inputChunkSize);
+        if ( chunk.isEmpty() )
+            break;
+        emit inputChunkReceived(chunk);
+    }
+}
+
 void ClipboardClient::abortInputReader()
 {
     if (m_inputReaderThread) {
@@ -233,6 +290,45 @@ bool ClipboardClient::isInputReaderFinished() const
     return m_inputReaderThread && m_inputReaderThread->isFinished();
 }
 
+void ClipboardClient::startBuiltInCall(const QStringList &arguments)
+{
+    if ( wasClosed() )
+        return;
+
+    m_builtInCallArguments = arguments;
+
+    bool hasActionId;
+    const qint32 actionId = qgetenv("COPYQ_ACTION_ID").toInt(&hasActionId);
+
+    QByteArray message;
+    {
+        QDataStream out(&message, QIODevice::WriteOnly);
+        out << arguments << (hasActionId ? actionId : -1);
+    }
+
+    sendMessage(message, CommandBuiltInCall);
+}
+
+void ClipboardClient::startScriptCall(const QStringList &arguments)
+{
+    if ( wasClosed() )
+        return;
+
+    m_scriptInServer = true;
+
+    bool hasActionId;
+    const qint32 actionId = qgetenv("COPYQ_ACTION_ID").toInt(&hasActionId);
+    const QString actionName = getTextData( qgetenv("COPYQ_ACTION_NAME") );
+
+    QByteArray message;
+    {
+        QDataStream out(&message, QIODevice::WriteOnly);
+        out << arguments << (hasActionId ? actionId : -1) << actionName << QDir::currentPath();
+    }
+
+    sendMessage(message, CommandScriptCall);
+}
+
 void ClipboardClient::start(const QStringList &arguments)
 {
     QScriptEngine engine;
@@ -243,13 +339,18 @@ void ClipboardClient::start(const QStringList &arguments)
              this, SLOT(onMessageReceived(QByteArray,int)) );
     connect( &scriptable, SIGNAL(readInput()),
              this, SLOT(startInputReader()) );
-    connect( &scriptableProxy, SIGNAL(sendFunctionCall(QByteArray)),
-             this, SLOT(sendFunctionCall(QByteArray)) );
+    connect( &scriptableProxy, SIGNAL(sendFunctionCall(QByteArray,int)),
+             this, SLOT(sendFunctionCall(QByteArray,int)) );
 
     connect( this, SIGNAL(inputReceived(QByteArray)),
              &scriptable, SLOT(setInput(QByteArray)) );
     connect( this, SIGNAL(functionCallResultReceived(QByteArray)),
              &scriptableProxy, SLOT(setReturnValue(QByteArray)) );
 
+    connect( &scriptable, SIGNAL(streamInput()),
+             this, SLOT(startInputStream()) );
+    connect( this, SIGNAL(inputChunkReceived(QByteArray)),
+             &scriptableProxy, SLOT(appendStreamedInput(QByteArray)) );
+
     scriptable.executeArguments(arguments);
 }
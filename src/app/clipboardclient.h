@@ -65,21 +65,42 @@ private slots:
 
     void exit(int exitCode) override;
 
-    void sendFunctionCall(const QByteArray &bytes);
+    void sendFunctionCall(const QByteArray &bytes, int messageCode);
 
     void startInputReader();
 
+    /// Pass standard input to server in chunks (see ScriptableProxy::appendStreamedInput()).
+    void startInputStream();
+
 signals:
     void functionCallResultReceived(const QByteArray &returnValue);
     void inputReceived(const QByteArray &input);
+    void inputChunkReceived(const QByteArray &chunk);
 
 private:
     void abortInputReader();
     bool isInputReaderFinished() const;
     void start(const QStringList &arguments);
 
+    /**
+     * Ask server to run simple built-in command directly.
+     *
+     * Skips loading settings and creating script engine. If server rejects
+     * the command, start() is called.
+     */
+    void startBuiltInCall(const QStringList &arguments);
+
+    /**
+     * Ask server to run script (option "--in-server").
+     *
+     * Server requests standard input only if script needs it.
+     */
+    void startScriptCall(const QStringList &arguments);
+
     QThread *m_inputReaderThread;
     QByteArray m_input;
+    QStringList m_builtInCallArguments;
+    bool m_scriptInServer = false;
 };
 
 #endif // CLIPBOARDCLIENT_H
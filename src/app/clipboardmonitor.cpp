@@ -54,6 +54,12 @@ bool hasSameData(const QVariantMap &data, const QVariantMap &lastData)
         }
     }
 
+    // Compare big data by hash or stored file (see clipboard_data_limits option).
+    for (const auto format : {mimeDataHashes, mimeDataFiles}) {
+        if ( data.value(format) != lastData.value(format) )
+            return false;
+    }
+
     return true;
 }
 
@@ -19,26 +19,33 @@
 
 #include "clipboardserver.h"
 
+#include "serverscriptrunner.h"
+
 #include "common/action.h"
+#include "common/appconfig.h"
 #include "common/clientsocket.h"
 #include "common/client_server.h"
 #include "common/commandstatus.h"
+#include "common/commandstore.h"
 #include "common/display.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/shortcuts.h"
 #include "common/sleeptimer.h"
+#include "gui/builtincommandrunner.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/commanddialog.h"
 #include "gui/configtabshortcuts.h"
 #include "gui/iconfactory.h"
 #include "gui/mainwindow.h"
+#include "item/blobstore.h"
 #include "item/itemfactory.h"
 #include "item/serialize.h"
 #include "scriptable/scriptableproxy.h"
 
 #include <QAction>
 #include <QApplication>
+#include <QDataStream>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QMessageBox>
@@ -72,12 +79,17 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     , m_shortcutActions()
     , m_ignoreKeysTimer()
 {
+    m_startupTimer.start();
+
     const QString serverName = clipboardServerName();
-    auto server = new Server(serverName, this);
+    m_server = new Server(serverName, this);
 
-    if ( server->isListening() ) {
+    if ( m_server->isListening() ) {
         ::createSessionMutex();
+        removeClipboardMessageFiles();
         restoreSettings(true);
+        // Data stored for items which were not saved in last session are not needed.
+        BlobStore::instance()->removeUnsavedReferences();
         COPYQ_LOG("Server \"" + serverName + "\" started.");
     } else {
         restoreSettings(false);
@@ -93,18 +105,14 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
 
     QApplication::setQuitOnLastWindowClosed(false);
 
+    startupPhaseFinished("Socket");
+
     m_itemFactory = new ItemFactory(this);
     m_wnd = new MainWindow(m_itemFactory);
 
-    m_itemFactory->loadPlugins();
-    if ( !m_itemFactory->hasLoaders() )
-        log("No plugins loaded", LogNote);
+    startupPhaseFinished("Main window");
 
-    m_wnd->loadSettings();
-    m_wnd->setCurrentTab(0);
-    m_wnd->enterBrowseMode();
-
-    connect( server, SIGNAL(newConnection(ClientSocketPtr)),
+    connect( m_server, SIGNAL(newConnection(ClientSocketPtr)),
              this, SLOT(onClientNewConnection(ClientSocketPtr)) );
 
     connect( qApp, SIGNAL(aboutToQuit()),
@@ -121,26 +129,29 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     connect( m_wnd, SIGNAL(disableClipboardStoringRequest(bool)),
              this, SLOT(onDisableClipboardStoringRequest(bool)) );
 
-    loadSettings();
-
     // notify window if configuration changes
     connect( m_wnd, SIGNAL(configurationChanged()),
              this, SLOT(loadSettings()) );
 
     connect( m_wnd, SIGNAL(commandsSaved()),
              this, SLOT(onCommandsSaved()) );
-    onCommandsSaved();
-
-    // run clipboard monitor
-    startMonitoring();
 
     qApp->installEventFilter(this);
 
-    server->start();
-
     // Ignore global shortcut key presses in any widget.
     m_ignoreKeysTimer.setInterval(100);
     m_ignoreKeysTimer.setSingleShot(true);
+
+    if ( AppConfig().option<Config::defer_startup>() ) {
+        // Monitor process starts in parallel with loading rest of the
+        // server. Its connection waits until the server is fully loaded
+        // so no clipboard changes are lost.
+        startMonitoring();
+        startupPhaseFinished("Monitor");
+        QTimer::singleShot( 0, this, SLOT(finishStartup()) );
+    } else {
+        finishStartup();
+    }
 }
 
 ClipboardServer::~ClipboardServer()
@@ -198,29 +209,48 @@ void ClipboardServer::removeGlobalShortcuts()
 void ClipboardServer::onCommandsSaved()
 {
     const auto commands = loadEnabledCommands();
+    updateGlobalShortcuts(commands);
 
-#ifndef NO_GLOBAL_SHORTCUTS
-    removeGlobalShortcuts();
+    if ( m_monitor && hasScriptCommand(commands) ) {
+        stopMonitoring();
+        startMonitoring();
+    }
+}
 
-    QList<QKeySequence> usedShortcuts;
+void ClipboardServer::finishStartup()
+{
+    m_itemFactory->loadPlugins();
+    if ( !m_itemFactory->hasLoaders() )
+        log("No plugins loaded", LogNote);
 
-    for (const auto &command : commands) {
-        if (command.type() & CommandType::GlobalShortcut) {
-            for (const auto &shortcutText : command.globalShortcuts) {
-                QKeySequence shortcut(shortcutText, QKeySequence::PortableText);
-                if ( !shortcut.isEmpty() && !usedShortcuts.contains(shortcut) ) {
-                    usedShortcuts.append(shortcut);
-                    createGlobalShortcut(shortcut, command);
-                }
-            }
-        }
-    }
-#endif
+    startupPhaseFinished("Plugins");
 
-    if ( m_monitor && hasScriptCommand(commands) ) {
-        stopMonitoring();
+    // Only current tab is loaded, other tabs are loaded when needed.
+    m_wnd->loadSettings();
+    m_wnd->setCurrentTab(0);
+    m_wnd->enterBrowseMode();
+
+    startupPhaseFinished("Settings and tabs");
+
+    // Monitor started earlier already uses current commands.
+    updateGlobalShortcuts( loadEnabledCommands() );
+
+    startupPhaseFinished("Commands");
+
+    if (!m_monitor) {
         startMonitoring();
+        startupPhaseFinished("Monitor");
     }
+
+    m_server->start();
+
+    startupPhaseFinished("Clients");
+
+    const auto total = m_startupTimer.elapsed();
+    m_startupProfile.append( QString("Total: %1 ms").arg(total) );
+    log( QString("Server started in %1 ms").arg(total), LogNote );
+
+    qApp->setProperty( "CopyQ_startup_profile", m_startupProfile.join(", ") );
 }
 
 void ClipboardServer::onAboutToQuit()
@@ -357,6 +387,54 @@ void ClipboardServer::onClientMessageReceived(
         client->sendMessage(result, CommandFunctionCallReturnValue);
         break;
     }
+    case CommandTypedFunctionCall: {
+        auto proxy = m_clients.value(client).proxy;
+        if (!proxy)
+            return;
+        QByteArray result;
+        if ( !proxy->callTypedFunction(message, &result) ) {
+            client->sendMessage("Invalid function call\n", CommandBadSyntax);
+            break;
+        }
+        client->sendMessage(result, CommandFunctionCallReturnValue);
+        break;
+    }
+    case CommandBuiltInCall: {
+        QStringList arguments;
+        qint32 actionId;
+        QDataStream stream(message);
+        stream >> arguments >> actionId;
+
+        BuiltInCommandRunner runner(m_wnd);
+        if ( stream.status() != QDataStream::Ok || !runner.canRunInternally(arguments) ) {
+            client->sendMessage(QByteArray(), CommandBuiltInCallRejected);
+            break;
+        }
+
+        QByteArray output;
+        QString errorOutput;
+        const int exitCode = runner.runInternally(arguments, actionId, QByteArray(), &output, &errorOutput);
+        client->sendMessage( exitCode == CommandFinished ? output : errorOutput.toUtf8(), exitCode );
+        break;
+    }
+    case CommandScriptCall: {
+        auto it = m_clients.find(client);
+        if ( it == m_clients.end() || it.value().scriptRunner )
+            return;
+
+        auto runner = new ServerScriptRunner(it.value().proxy, it.value().client, m_itemFactory, this);
+        it.value().scriptRunner = runner;
+        connect( runner, SIGNAL(finished(ServerScriptRunner*)),
+                 this, SLOT(onScriptRunnerFinished(ServerScriptRunner*)) );
+        runner->start(message);
+        break;
+    }
+    case CommandInput: {
+        auto scriptRunner = m_clients.value(client).scriptRunner;
+        if (scriptRunner)
+            scriptRunner->setInput(message);
+        break;
+    }
     default:
         log(QString("Unhandled command status: %1").arg(messageCode));
         break;
@@ -365,6 +443,12 @@ void ClipboardServer::onClientMessageReceived(
 
 void ClipboardServer::onClientDisconnected(ClientSocket *client)
 {
+    const auto clientData = m_clients.value(client);
+    if (clientData.proxy)
+        clientData.proxy->clearStreamedInput();
+    if (clientData.scriptRunner)
+        clientData.scriptRunner->abort();
+
     m_clients.remove(client);
 }
 
@@ -374,6 +458,16 @@ void ClipboardServer::onClientConnectionFailed(ClientSocket *client)
     m_clients.remove(client);
 }
 
+void ClipboardServer::onScriptRunnerFinished(ServerScriptRunner *runner)
+{
+    for (auto &clientData : m_clients) {
+        if (clientData.scriptRunner == runner)
+            clientData.scriptRunner = nullptr;
+    }
+
+    runner->deleteLater();
+}
+
 void ClipboardServer::onMonitorFinished()
 {
     COPYQ_LOG("Monitor finished");
@@ -469,3 +563,37 @@ void ClipboardServer::shortcutActivated(QxtGlobalShortcut *shortcut)
     }
 #endif
 }
+
+void ClipboardServer::updateGlobalShortcuts(const QVector<Command> &commands)
+{
+#ifdef NO_GLOBAL_SHORTCUTS
+    Q_UNUSED(commands);
+#else
+    removeGlobalShortcuts();
+
+    QList<QKeySequence> usedShortcuts;
+
+    for (const auto &command : commands) {
+        if (command.type() & CommandType::GlobalShortcut) {
+            for (const auto &shortcutText : command.globalShortcuts) {
+                QKeySequence shortcut(shortcutText, QKeySequence::PortableText);
+                if ( !shortcut.isEmpty() && !usedShortcuts.contains(shortcut) ) {
+                    usedShortcuts.append(shortcut);
+                    createGlobalShortcut(shortcut, command);
+                }
+            }
+        }
+    }
+#endif
+}
+
+void ClipboardServer::startupPhaseFinished(const QString &phaseName)
+{
+    const auto elapsed = m_startupTimer.elapsed();
+    const auto phaseMs = elapsed - m_lastStartupPhaseMs;
+    m_lastStartupPhaseMs = elapsed;
+
+    const auto text = QString("%1: %2 ms").arg(phaseName).arg(phaseMs);
+    m_startupProfile.append(text);
+    COPYQ_LOG("Startup phase finished - " + text);
+}
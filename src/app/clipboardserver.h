@@ -24,14 +24,17 @@
 #include "common/clipboardmode.h"
 #include "common/server.h"
 
+#include <QElapsedTimer>
 #include <QMap>
 #include <QPointer>
+#include <QStringList>
 #include <QTimer>
 
 class Action;
 class ItemFactory;
 class MainWindow;
 class ScriptableProxy;
+class ServerScriptRunner;
 class QxtGlobalShortcut;
 class QApplication;
 class QSessionManager;
@@ -80,6 +83,7 @@ private slots:
     void onClientMessageReceived(const QByteArray &message, int messageCode, ClientSocket *client);
     void onClientDisconnected(ClientSocket *client);
     void onClientConnectionFailed(ClientSocket *client);
+    void onScriptRunnerFinished(ServerScriptRunner *runner);
 
     /** An error occurred on monitor connection. */
     void onMonitorFinished();
@@ -92,6 +96,15 @@ private slots:
     /** Called when new commands are available. */
     void onCommandsSaved();
 
+    /**
+     * Load plugins, tabs and commands and start accepting client connections.
+     *
+     * With "defer_startup" option this is called after monitor is started
+     * and event loop is running. Clients (including the monitor) can connect
+     * earlier but their connections are processed only after this finishes.
+     */
+    void finishStartup();
+
     /** Clean up before quitting. */
     void onAboutToQuit();
 
@@ -117,11 +130,21 @@ private:
 
     bool hasRunningCommands() const;
 
+    void updateGlobalShortcuts(const QVector<Command> &commands);
+
+    /// Log time spent in startup phase since previous one.
+    void startupPhaseFinished(const QString &phaseName);
+
     MainWindow* m_wnd;
     QPointer<Action> m_monitor;
     QMap<QxtGlobalShortcut*, Command> m_shortcutActions;
     QTimer m_ignoreKeysTimer;
     ItemFactory *m_itemFactory;
+    Server *m_server = nullptr;
+
+    QElapsedTimer m_startupTimer;
+    qint64 m_lastStartupPhaseMs = 0;
+    QStringList m_startupProfile;
 
     struct ClientData {
         ClientData() = default;
@@ -132,6 +155,8 @@ private:
         }
         ClientSocketPtr client;
         ScriptableProxy *proxy = nullptr;
+        /// Script running in server for the client (option "--in-server").
+        ServerScriptRunner *scriptRunner = nullptr;
     };
     QMap<ClientSocket*, ClientData> m_clients;
 };
@@ -0,0 +1,261 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "serverscriptrunner.h"
+
+#include "common/appconfig.h"
+#include "common/clientsocket.h"
+#include "common/commandstatus.h"
+#include "common/common.h"
+#include "common/log.h"
+#include "item/itemfactory.h"
+#include "item/itemwidget.h"
+#include "scriptable/scriptable.h"
+#include "scriptable/scriptableproxy.h"
+
+#include <QDataStream>
+#include <QEventLoop>
+#include <QScriptEngine>
+#include <QThread>
+
+namespace {
+
+/// How often script engine processes events (e.g. request to abort the script).
+const int processEventsIntervalMs = 100;
+
+} // namespace
+
+/**
+ * Evaluates script in worker thread.
+ *
+ * API calls are passed to the main thread as function objects.
+ */
+class ServerScriptWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ServerScriptWorker(const QByteArray &message, const QList<ItemScriptable*> &pluginScriptables)
+        : m_message(message)
+        , m_pluginScriptables(pluginScriptables)
+    {
+    }
+
+    ~ServerScriptWorker()
+    {
+        qDeleteAll(m_pluginScriptables);
+    }
+
+public slots:
+    void run()
+    {
+        QStringList arguments;
+        qint32 actionId;
+        QString actionName;
+        QString currentPath;
+        QDataStream stream(m_message);
+        stream >> arguments >> actionId >> actionName >> currentPath;
+        if ( stream.status() != QDataStream::Ok ) {
+            log("Failed to parse script call from client", LogError);
+            emit sendMessage("Failed to parse script call", CommandBadSyntax);
+            emit finished();
+            return;
+        }
+
+        QScriptEngine engine;
+        engine.setProcessEventsInterval(processEventsIntervalMs);
+        ScriptableProxy proxy(nullptr, nullptr);
+        proxy.setCallFunctionsInMainThread();
+        Scriptable scriptable(&engine, &proxy);
+        scriptable.setSandboxed(true);
+        scriptable.setAction(actionId, actionName);
+        scriptable.setCurrentPath(currentPath);
+        scriptable.setPluginScriptables(m_pluginScriptables);
+        m_pluginScriptables.clear();
+
+        connect( &scriptable, SIGNAL(sendMessage(QByteArray,int)),
+                 this, SIGNAL(sendMessage(QByteArray,int)) );
+        connect( &scriptable, SIGNAL(readInput()),
+                 this, SIGNAL(readInput()) );
+        connect( &proxy, SIGNAL(callInMainThread(ScriptableProxyCall)),
+                 this, SLOT(callFunction(ScriptableProxyCall)), Qt::DirectConnection );
+        connect( this, SIGNAL(inputReceived(QByteArray)),
+                 &scriptable, SLOT(setInput(QByteArray)) );
+        connect( this, SIGNAL(abortRequested()),
+                 &scriptable, SLOT(onDisconnected()) );
+
+        if (!m_aborted)
+            scriptable.executeArguments(arguments);
+
+        emit finished();
+    }
+
+    void abort()
+    {
+        m_aborted = true;
+        emit abortRequested();
+    }
+
+signals:
+    void functionCall(const ScriptableProxyCall &call);
+    void sendMessage(const QByteArray &message, int messageCode);
+    void readInput();
+    void finished();
+
+    void inputReceived(const QByteArray &input);
+    void functionCallFinished();
+    void abortRequested();
+
+private slots:
+    /**
+     * Calls function in main thread and waits for it to finish.
+     *
+     * Arguments and result are owned by the function object so it's safe
+     * to stop waiting if the script is aborted.
+     */
+    void callFunction(const ScriptableProxyCall &call)
+    {
+        if (m_aborted)
+            return;
+
+        emit functionCall(call);
+
+        QEventLoop loop;
+        connect( this, SIGNAL(functionCallFinished()), &loop, SLOT(quit()) );
+        connect( this, SIGNAL(abortRequested()), &loop, SLOT(quit()) );
+        loop.exec();
+    }
+
+private:
+    QByteArray m_message;
+    QList<ItemScriptable*> m_pluginScriptables;
+    bool m_aborted = false;
+};
+
+ServerScriptRunner::ServerScriptRunner(
+        ScriptableProxy *proxy, const ClientSocketPtr &client,
+        const ItemFactory *itemFactory, QObject *parent)
+    : QObject(parent)
+    , m_proxy(proxy)
+    , m_client(client)
+    , m_itemFactory(itemFactory)
+{
+    qRegisterMetaType<ScriptableProxyCall>("ScriptableProxyCall");
+
+    const int timeoutSeconds = AppConfig().option<Config::in_server_script_timeout>();
+    initSingleShotTimer( &m_timerTimeout, 1000 * timeoutSeconds, this, SLOT(onTimeout()) );
+}
+
+ServerScriptRunner::~ServerScriptRunner()
+{
+    if ( m_thread && m_thread->isRunning() ) {
+        emit abortRequested();
+        m_thread->wait();
+    }
+}
+
+void ServerScriptRunner::start(const QByteArray &message)
+{
+    Q_ASSERT(!m_thread);
+    m_thread = new QThread(this);
+
+    // Plugins cannot be loaded again in server, use script objects from loaded ones.
+    auto pluginScriptables = m_itemFactory ? m_itemFactory->scriptableObjects() : QList<ItemScriptable*>();
+    for (auto obj : pluginScriptables)
+        obj->moveToThread(m_thread);
+
+    auto worker = new ServerScriptWorker(message, pluginScriptables);
+    worker->moveToThread(m_thread);
+
+    connect( m_thread, SIGNAL(started()), worker, SLOT(run()) );
+    connect( worker, SIGNAL(finished()), m_thread, SLOT(quit()) );
+    connect( m_thread, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    connect( m_thread, SIGNAL(finished()), this, SLOT(onThreadFinished()) );
+
+    connect( worker, SIGNAL(functionCall(ScriptableProxyCall)),
+             this, SLOT(onFunctionCall(ScriptableProxyCall)) );
+    connect( worker, SIGNAL(sendMessage(QByteArray,int)),
+             this, SLOT(onSendMessage(QByteArray,int)) );
+    connect( worker, SIGNAL(readInput()),
+             this, SLOT(onReadInput()) );
+
+    connect( this, SIGNAL(inputReceived(QByteArray)),
+             worker, SIGNAL(inputReceived(QByteArray)) );
+    connect( this, SIGNAL(functionCallFinished()),
+             worker, SIGNAL(functionCallFinished()) );
+    connect( this, SIGNAL(abortRequested()),
+             worker, SLOT(abort()) );
+
+    if ( m_timerTimeout.interval() > 0 )
+        m_timerTimeout.start();
+    m_thread->start();
+}
+
+void ServerScriptRunner::abort()
+{
+    emit abortRequested();
+}
+
+void ServerScriptRunner::setInput(const QByteArray &input)
+{
+    emit inputReceived(input);
+}
+
+void ServerScriptRunner::onFunctionCall(const ScriptableProxyCall &call)
+{
+    // Runner can be deleted in nested event loop (e.g. while dialog is open).
+    const QPointer<ServerScriptRunner> self(this);
+
+    if (m_proxy)
+        call(m_proxy);
+
+    if (self)
+        emit functionCallFinished();
+}
+
+void ServerScriptRunner::onSendMessage(const QByteArray &message, int messageCode)
+{
+    if (m_timedOut && messageCode == CommandFinished) {
+        m_client->sendMessage("ScriptError: Script in server timed out\n", CommandException);
+        return;
+    }
+
+    m_client->sendMessage(message, messageCode);
+}
+
+void ServerScriptRunner::onReadInput()
+{
+    m_client->sendMessage(QByteArray(), CommandReadInput);
+}
+
+void ServerScriptRunner::onTimeout()
+{
+    log( QString("Aborting script in server after %1 seconds").arg(m_timerTimeout.interval() / 1000), LogWarning );
+    m_timedOut = true;
+    emit abortRequested();
+}
+
+void ServerScriptRunner::onThreadFinished()
+{
+    m_timerTimeout.stop();
+    emit finished(this);
+}
+
+#include "serverscriptrunner.moc"
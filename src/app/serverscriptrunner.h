@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SERVERSCRIPTRUNNER_H
+#define SERVERSCRIPTRUNNER_H
+
+#include "common/server.h"
+#include "scriptable/scriptableproxy.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class ItemFactory;
+class QByteArray;
+class QThread;
+
+/**
+ * Runs script sent by client with "--in-server" option in server process.
+ *
+ * This avoids creating script engine in client and sending each API call
+ * over the socket. Only functions which don't change the server process
+ * itself are available (see Scriptable::setSandboxed()).
+ *
+ * Script is evaluated in a separate thread so it does not block the GUI
+ * (e.g. with sleep() or long computation). API calls are passed to the
+ * client's ScriptableProxy in the main thread directly (without serializing
+ * them). Script is aborted if it runs too long (see option
+ * in_server_script_timeout) or if the client disconnects.
+ */
+class ServerScriptRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    ServerScriptRunner(
+            ScriptableProxy *proxy, const ClientSocketPtr &client,
+            const ItemFactory *itemFactory, QObject *parent = nullptr);
+
+    /// Aborts the script and waits for the thread to finish.
+    ~ServerScriptRunner();
+
+    /**
+     * Start script from message (CommandScriptCall).
+     *
+     * Emits finished() after the result is sent to the client.
+     */
+    void start(const QByteArray &message);
+
+    /// Abort running script.
+    void abort();
+
+public slots:
+    /// Pass standard input received from client (CommandInput) to the script.
+    void setInput(const QByteArray &input);
+
+signals:
+    void finished(ServerScriptRunner *runner);
+
+    void inputReceived(const QByteArray &input);
+    void functionCallFinished();
+    void abortRequested();
+
+private slots:
+    void onFunctionCall(const ScriptableProxyCall &call);
+    void onSendMessage(const QByteArray &message, int messageCode);
+    void onReadInput();
+    void onTimeout();
+    void onThreadFinished();
+
+private:
+    QPointer<ScriptableProxy> m_proxy;
+    ClientSocketPtr m_client;
+    const ItemFactory *m_itemFactory;
+    QThread *m_thread = nullptr;
+    QTimer m_timerTimeout;
+    bool m_timedOut = false;
+};
+
+#endif // SERVERSCRIPTRUNNER_H
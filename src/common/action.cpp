@@ -33,6 +33,10 @@
 
 #include <cstring>
 
+#ifdef Q_OS_LINUX
+#   include <sys/resource.h>
+#endif
+
 namespace {
 
 void startProcess(QProcess *process, const QStringList &args, QIODevice::OpenModeFlag mode)
@@ -166,6 +170,50 @@ QList< QList<QStringList> > parseCommands(const QString &cmd, const QStringList
     return lines;
 }
 
+#ifdef Q_OS_LINUX
+qint64 toMs(const timeval &time)
+{
+    return static_cast<qint64>(time.tv_sec) * 1000 + time.tv_usec / 1000;
+}
+
+/// Usage of finished child processes already accounted to some action.
+struct ChildrenUsage {
+    qint64 cpuTimeMs = 0;
+    qint64 maxRssKiB = 0;
+};
+
+ChildrenUsage &accountedChildrenUsage()
+{
+    static ChildrenUsage usage;
+    return usage;
+}
+
+/**
+ * Adds usage of child processes finished since last call.
+ *
+ * Peak memory is known only if the processes used more memory than any
+ * previously finished child process.
+ */
+void addFinishedChildrenUsage(ActionResourceUsage *usage)
+{
+    rusage childrenUsage;
+    if ( getrusage(RUSAGE_CHILDREN, &childrenUsage) != 0 )
+        return;
+
+    ChildrenUsage &accounted = accountedChildrenUsage();
+
+    const qint64 cpuTimeMs = toMs(childrenUsage.ru_utime) + toMs(childrenUsage.ru_stime);
+    usage->cpuTimeMs = qMax(Q_INT64_C(0), usage->cpuTimeMs) + cpuTimeMs - accounted.cpuTimeMs;
+    accounted.cpuTimeMs = cpuTimeMs;
+
+    const qint64 maxRssKiB = childrenUsage.ru_maxrss;
+    if (maxRssKiB > accounted.maxRssKiB) {
+        usage->peakRssKiB = qMax(usage->peakRssKiB, maxRssKiB);
+        accounted.maxRssKiB = maxRssKiB;
+    }
+}
+#endif
+
 } // namespace
 
 Action::Action(QObject *parent)
@@ -178,6 +226,9 @@ Action::Action(QObject *parent)
 
 Action::~Action()
 {
+    // Runner can be already destroyed.
+    m_internalCommandRunner = nullptr;
+    m_stagesRunning = false;
     closeSubCommands();
 }
 
@@ -219,6 +270,13 @@ void Action::setInput(const QVariantMap &data, const QString &inputFormat)
 
 void Action::start()
 {
+    if ( !m_wallTimer.isValid() ) {
+        m_wallTimer.start();
+        // Only input of the first command and output of the last command
+        // in a pipe are counted (not data passed between the commands).
+        m_resourceUsage.bytesIn = m_input.size();
+    }
+
     closeSubCommands();
 
     if ( m_currentLine + 1 >= m_cmds.size() ) {
@@ -231,30 +289,19 @@ void Action::start()
 
     Q_ASSERT( !cmds.isEmpty() );
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (m_id != -1)
-        env.insert("COPYQ_ACTION_ID", QString::number(m_id));
-    if ( !m_name.isEmpty() )
-        env.insert("COPYQ_ACTION_NAME", m_name);
-
-    for (int i = 0; i < cmds.size(); ++i) {
-        auto process = new QProcess(this);
-        m_processes.append(process);
-        process->setProcessEnvironment(env);
-        if ( !m_workingDirectoryPath.isEmpty() )
-            process->setWorkingDirectory(m_workingDirectoryPath);
-
-#if QT_VERSION < 0x050600
-        connect( process, SIGNAL(error(QProcess::ProcessError)),
-                 SLOT(onSubProcessError(QProcess::ProcessError)) );
-#else
-        connect( process, SIGNAL(errorOccurred(QProcess::ProcessError)),
-                 SLOT(onSubProcessError(QProcess::ProcessError)) );
-#endif
-        connect( process, SIGNAL(readyReadStandardError()),
-                 SLOT(onSubProcessErrorOutput()) );
+    // Run commands one after another and pass data between them in memory
+    // if all can run in-process (external programs need to stream data).
+    if ( hasOnlyInternalCommands(cmds) ) {
+        m_stagesRunning = true;
+        m_stage = -1;
+        m_stageData = m_input;
+        QMetaObject::invokeMethod(this, "runNextStage", Qt::QueuedConnection);
+        return;
     }
 
+    for (int i = 0; i < cmds.size(); ++i)
+        createProcess();
+
     for (int i = 1; i < m_processes.size(); ++i) {
         m_processes[i - 1]->setStandardOutputProcess(m_processes[i]);
         connect( m_processes[i], SIGNAL(finished(int)),
@@ -292,6 +339,9 @@ void Action::start()
 
 bool Action::waitForStarted(int msecs)
 {
+    if (m_stagesRunning)
+        return true;
+
     return !m_processes.isEmpty() && m_processes.last()->waitForStarted(msecs);
 }
 
@@ -303,7 +353,9 @@ bool Action::waitForFinished(int msecs)
     QPointer<QObject> self(this);
     QEventLoop loop;
     QTimer t;
-    connect(m_processes.last(), SIGNAL(finished(int)), &loop, SLOT(quit()));
+    if ( !m_processes.isEmpty() )
+        connect(m_processes.last(), SIGNAL(finished(int)), &loop, SLOT(quit()));
+    connect(this, SIGNAL(actionFinished(Action*)), &loop, SLOT(quit()));
     connect(&t, SIGNAL(timeout()), &loop, SLOT(quit()));
     t.start(msecs);
     loop.exec(QEventLoop::ExcludeUserInputEvents);
@@ -313,7 +365,8 @@ bool Action::waitForFinished(int msecs)
 
 bool Action::isRunning() const
 {
-    return !m_processes.isEmpty() && m_processes.last()->state() != QProcess::NotRunning;
+    return m_stagesRunning
+            || (!m_processes.isEmpty() && m_processes.last()->state() != QProcess::NotRunning);
 }
 
 void Action::setData(const QVariantMap &data)
@@ -327,6 +380,13 @@ const QVariantMap &Action::data() const
     return m_data;
 }
 
+ActionResourceUsage Action::resourceUsage() const
+{
+    ActionResourceUsage usage = m_resourceUsage;
+    usage.wallTimeMs = m_wallTimer.isValid() ? m_wallTimer.elapsed() : m_wallTimeMs;
+    return usage;
+}
+
 void Action::onSubProcessError(QProcess::ProcessError error)
 {
     QProcess *p = qobject_cast<QProcess*>(sender());
@@ -369,6 +429,7 @@ void Action::onSubProcessOutput()
     if ( output.isEmpty() )
         return;
 
+    m_resourceUsage.bytesOut += output.size();
     emit actionOutput(output);
 }
 
@@ -377,8 +438,10 @@ void Action::onSubProcessErrorOutput()
     QProcess *p = qobject_cast<QProcess*>(sender());
     Q_ASSERT(p);
 
-    if ( p->isReadable() )
-        m_errorOutput.append( getTextData(p->readAllStandardError()) );
+    if ( p->isReadable() ) {
+        const auto errorOutput = p->readAllStandardError();
+        m_errorOutput.append( getTextData(errorOutput) );
+    }
 }
 
 void Action::writeInput()
@@ -388,10 +451,11 @@ void Action::writeInput()
 
     QProcess *p = m_processes.first();
 
-    if (m_input.isEmpty())
+    if (m_input.isEmpty()) {
         p->closeWriteChannel();
-    else
+    } else {
         p->write(m_input);
+    }
 }
 
 void Action::onBytesWritten()
@@ -400,8 +464,53 @@ void Action::onBytesWritten()
         m_processes.first()->closeWriteChannel();
 }
 
+void Action::runNextStage()
+{
+    if (!m_stagesRunning)
+        return;
+
+    if (m_stage == -1 && m_currentLine == 0)
+        emit actionStarted(this);
+
+    ++m_stage;
+    const QList<QStringList> &cmds = m_cmds[m_currentLine];
+
+    if ( m_stage >= cmds.size() ) {
+        m_stagesRunning = false;
+        if ( m_readOutput && !m_stageData.isEmpty() ) {
+            m_resourceUsage.bytesOut += m_stageData.size();
+            emit actionOutput(m_stageData);
+        }
+        m_stageData.clear();
+        start();
+        return;
+    }
+
+    if (!m_internalCommandRunner) {
+        terminate();
+        return;
+    }
+
+    QByteArray output;
+    QString errorOutput;
+    m_exitCode = m_internalCommandRunner->runInternally(
+                cmds[m_stage], m_id, m_stageData, &output, &errorOutput);
+    m_errorOutput.append(errorOutput);
+    m_stageData = output;
+    QMetaObject::invokeMethod(this, "runNextStage", Qt::QueuedConnection);
+}
+
 void Action::terminate()
 {
+    // Skip remaining commands and lines running in-process.
+    if (m_stagesRunning) {
+        m_stagesRunning = false;
+        m_stageData.clear();
+        m_failed = true;
+        actionFinished();
+        return;
+    }
+
     if (m_processes.isEmpty())
         return;
 
@@ -410,7 +519,7 @@ void Action::terminate()
         p->terminate();
 
     // if process still running: kill it
-    if ( !waitForFinished(5000) )
+    if ( !waitForFinished(5000) && !m_processes.isEmpty() )
         terminateProcess( m_processes.last() );
 }
 
@@ -421,6 +530,11 @@ void Action::closeSubCommands()
     if (m_processes.isEmpty())
         return;
 
+#ifdef Q_OS_LINUX
+    // Usage is collected once processes finish (no sampling while running).
+    addFinishedChildrenUsage(&m_resourceUsage);
+#endif
+
     m_exitCode = m_processes.last()->exitCode();
     m_failed = m_failed || m_processes.last()->exitStatus() != QProcess::NormalExit;
 
@@ -433,5 +547,51 @@ void Action::closeSubCommands()
 void Action::actionFinished()
 {
     closeSubCommands();
+
+    if ( m_wallTimer.isValid() ) {
+        m_wallTimeMs = m_wallTimer.elapsed();
+        m_wallTimer.invalidate();
+    }
+
     emit actionFinished(this);
 }
+
+bool Action::hasOnlyInternalCommands(const QList<QStringList> &cmds) const
+{
+    if (!m_internalCommandRunner)
+        return false;
+
+    for (const auto &args : cmds) {
+        if ( !m_internalCommandRunner->canRunInternally(args) )
+            return false;
+    }
+
+    return true;
+}
+
+QProcess *Action::createProcess()
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    if (m_id != -1)
+        env.insert("COPYQ_ACTION_ID", QString::number(m_id));
+    if ( !m_name.isEmpty() )
+        env.insert("COPYQ_ACTION_NAME", m_name);
+
+    auto process = new QProcess(this);
+    m_processes.append(process);
+    process->setProcessEnvironment(env);
+    if ( !m_workingDirectoryPath.isEmpty() )
+        process->setWorkingDirectory(m_workingDirectoryPath);
+
+#if QT_VERSION < 0x050600
+    connect( process, SIGNAL(error(QProcess::ProcessError)),
+             SLOT(onSubProcessError(QProcess::ProcessError)) );
+#else
+    connect( process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+             SLOT(onSubProcessError(QProcess::ProcessError)) );
+#endif
+    connect( process, SIGNAL(readyReadStandardError()),
+             SLOT(onSubProcessErrorOutput()) );
+
+    return process;
+}
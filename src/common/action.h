@@ -20,6 +20,7 @@
 #ifndef ACTION_H
 #define ACTION_H
 
+#include <QElapsedTimer>
 #include <QModelIndex>
 #include <QProcess>
 #include <QStringList>
@@ -28,6 +29,44 @@
 
 class QAction;
 
+/**
+ * Runs some commands from pipeline in-process instead of starting new process.
+ */
+class InternalCommandRunner
+{
+public:
+    virtual ~InternalCommandRunner() = default;
+
+    /** Return true only if command with given arguments can be run in-process. */
+    virtual bool canRunInternally(const QStringList &args) const = 0;
+
+    /**
+     * Run command with given arguments.
+     *
+     * @return exit code
+     */
+    virtual int runInternally(
+            const QStringList &args, int actionId, const QByteArray &input,
+            QByteArray *output, QString *errorOutput) = 0;
+};
+
+/**
+ * Resources consumed by an action.
+ *
+ * CPU time and peak memory are collected from finished child processes
+ * and are -1 if unavailable (not supported on the platform, no process was
+ * started or peak memory didn't exceed peak of earlier child processes).
+ *
+ * Usage of processes finished at the same time can be accounted to either action.
+ */
+struct ActionResourceUsage {
+    qint64 wallTimeMs = 0;
+    qint64 cpuTimeMs = -1;
+    qint64 peakRssKiB = -1;
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+};
+
 /**
  * Execute external program and emits signals
  * to create or change items from the program's stdout.
@@ -95,6 +134,17 @@ public:
 
     void setReadOutput(bool read) { m_readOutput = read; }
 
+    /** Return resources used by the action so far. */
+    ActionResourceUsage resourceUsage() const;
+
+    /**
+     * Set runner for commands which don't need to start a new process.
+     *
+     * Pipeline consisting only of such commands passes data between commands
+     * in memory and runs them one after another.
+     */
+    void setInternalCommandRunner(InternalCommandRunner *runner) { m_internalCommandRunner = runner; }
+
 public slots:
     /** Terminate (kill) process. */
     void terminate();
@@ -117,10 +167,13 @@ private slots:
     void onSubProcessErrorOutput();
     void writeInput();
     void onBytesWritten();
+    void runNextStage();
 
 private:
     void closeSubCommands();
     void actionFinished();
+    bool hasOnlyInternalCommands(const QList<QStringList> &cmds) const;
+    QProcess *createProcess();
 
     QByteArray m_input;
     QList< QList<QStringList> > m_cmds;
@@ -138,6 +191,15 @@ private:
     QString m_errorString;
 
     int m_id = -1;
+
+    InternalCommandRunner *m_internalCommandRunner = nullptr;
+    bool m_stagesRunning = false;
+    int m_stage = -1;
+    QByteArray m_stageData;
+
+    QElapsedTimer m_wallTimer;
+    qint64 m_wallTimeMs = 0;
+    ActionResourceUsage m_resourceUsage;
 };
 
 #endif // ACTION_H
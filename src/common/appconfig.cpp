@@ -19,11 +19,42 @@
 
 #include "appconfig.h"
 
+#include "common/common.h"
 #include "platform/platformnativeinterface.h"
 
 #include <QObject>
 #include <QString>
 
+namespace {
+
+std::shared_ptr<const AppConfigSnapshot> &sharedSnapshot()
+{
+    static std::shared_ptr<const AppConfigSnapshot> snapshot;
+    return snapshot;
+}
+
+std::shared_ptr<const AppConfigSnapshot> currentSnapshot()
+{
+    auto &snapshot = sharedSnapshot();
+    Settings::reloadChangedFiles();
+    const int generation = Settings::generation();
+    if ( snapshot && snapshot->generation == generation )
+        return snapshot;
+
+    auto newSnapshot = std::make_shared<AppConfigSnapshot>();
+    newSnapshot->generation = generation;
+
+    Settings settings;
+    settings.beginGroup("Options");
+    for ( const auto &name : settings.allKeys() )
+        newSnapshot->options.insert( name, settings.value(name) );
+
+    snapshot = newSnapshot;
+    return snapshot;
+}
+
+} // namespace
+
 Config::Config<QString>::Value Config::editor::defaultValue()
 {
     return createPlatformNativeInterface()->defaultEditorCommand();
@@ -48,21 +79,49 @@ QString defaultTabName()
 
 QVariant AppConfig::option(const QString &name) const
 {
-    return m_settings.value(name);
+    return m_snapshot->options.value(name);
 }
 
 AppConfig::AppConfig()
 {
-    m_settings.beginGroup("Options");
+    Q_ASSERT( isMainThread() );
+    m_snapshot = currentSnapshot();
 }
 
+AppConfig::~AppConfig() = default;
+
 void AppConfig::setOption(const QString &name, const QVariant &value)
 {
-    if ( option(name) != value )
-        m_settings.setValue(name, value);
+    if ( option(name) != value ) {
+        settings()->setValue(name, value);
+        updateSnapshot(name, value);
+    }
 }
 
 void AppConfig::removeOption(const QString &name)
 {
-    m_settings.remove(name);
+    settings()->remove(name);
+    updateSnapshot(name, QVariant());
+}
+
+Settings *AppConfig::settings()
+{
+    if (!m_settings) {
+        m_settings.reset(new Settings);
+        m_settings->beginGroup("Options");
+    }
+
+    return m_settings.get();
+}
+
+void AppConfig::updateSnapshot(const QString &name, const QVariant &value)
+{
+    // Other instances see the change after settings are saved.
+    auto snapshot = std::make_shared<AppConfigSnapshot>(*m_snapshot);
+    if ( value.isValid() )
+        snapshot->options.insert(name, value);
+    else
+        snapshot->options.remove(name);
+    snapshot->generation = -1;
+    m_snapshot = snapshot;
 }
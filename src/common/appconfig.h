@@ -24,6 +24,8 @@
 
 #include <QVariant>
 
+#include <memory>
+
 class QString;
 
 QString defaultClipboardTabName();
@@ -288,13 +290,63 @@ struct autocompletion : Config<bool> {
     static Value defaultValue() { return true; }
 };
 
+struct paged_editor_threshold : Config<int> {
+    static QString name() { return "paged_editor_threshold"; }
+    /// Size in kB.
+    static Value defaultValue() { return 4 * 1024; }
+    static Value value(Value v) { return qBound(1, v, 1024 * 1024); }
+};
+
+struct defer_startup : Config<bool> {
+    static QString name() { return "defer_startup"; }
+    static Value defaultValue() { return false; }
+};
+
+struct clipboard_data_limits : Config<QString> {
+    static QString name() { return "clipboard_data_limits"; }
+};
+
+struct tabs_memory_limit : Config<int> {
+    static QString name() { return "tabs_memory_limit"; }
+    /// Size in MB (0 is unlimited).
+    static Value defaultValue() { return 0; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
+struct in_server_script_timeout : Config<int> {
+    static QString name() { return "in_server_script_timeout"; }
+    /// Timeout in seconds (0 is unlimited).
+    static Value defaultValue() { return 60; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
 } // namespace Config
 
+/**
+ * Immutable copy of options.
+ */
+struct AppConfigSnapshot {
+    QVariantMap options;
+
+    /// Value of Settings::generation() when loaded or -1 if options were changed locally.
+    int generation = -1;
+};
+
+/**
+ * Reads and writes options.
+ *
+ * Options are read from a snapshot shared by all instances in the process
+ * which is reloaded only after settings change in this process or settings
+ * files change (see Settings::generation()).
+ * Changes are written to settings when the instance is destroyed.
+ */
 class AppConfig
 {
 public:
     explicit AppConfig();
 
+    ~AppConfig();
+
     QVariant option(const QString &name) const;
 
     template <typename T>
@@ -307,16 +359,36 @@ public:
     template <typename T>
     typename T::Value option() const
     {
-        typename T::Value value = option(T::name(), T::defaultValue());
-        return T::value(value);
+        // Keep converted value until options change.
+        static int cachedGeneration = -1;
+        static typename T::Value cachedValue;
+
+        const int generation = m_snapshot->generation;
+        if (generation != -1 && generation == cachedGeneration)
+            return cachedValue;
+
+        const typename T::Value value = T::value( option(T::name(), T::defaultValue()) );
+        if (generation != -1) {
+            cachedGeneration = generation;
+            cachedValue = value;
+        }
+
+        return value;
     }
 
     void setOption(const QString &name, const QVariant &value);
 
     void removeOption(const QString &name);
 
+    AppConfig(const AppConfig &) = delete;
+    AppConfig &operator=(const AppConfig &) = delete;
+
 private:
-    Settings m_settings;
+    Settings *settings();
+    void updateSnapshot(const QString &name, const QVariant &value);
+
+    std::shared_ptr<const AppConfigSnapshot> m_snapshot;
+    std::unique_ptr<Settings> m_settings;
 };
 
 #endif // APPCONFIG_H
@@ -0,0 +1,112 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "atomicfile.h"
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+#if defined(Q_OS_UNIX)
+#   include <cstdio>
+#   include <fcntl.h>
+#   include <unistd.h>
+#elif defined(Q_OS_WIN)
+#   include <io.h>
+#   include <windows.h>
+#endif
+
+namespace {
+
+bool syncFile(QFile *file)
+{
+    if ( !file->flush() )
+        return false;
+
+#if defined(Q_OS_UNIX)
+    return ::fsync( file->handle() ) == 0;
+#elif defined(Q_OS_WIN)
+    const auto handle = reinterpret_cast<HANDLE>( _get_osfhandle(file->handle()) );
+    return FlushFileBuffers(handle) != 0;
+#else
+    return true;
+#endif
+}
+
+void syncDirectory(const QString &path)
+{
+#ifdef Q_OS_UNIX
+    const int fd = ::open( QFile::encodeName(path).constData(), O_RDONLY );
+    if (fd != -1) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+/// Rename file, replacing target file atomically if possible.
+bool replaceFile(const QString &sourceFileName, const QString &targetFileName)
+{
+#if defined(Q_OS_UNIX)
+    return ::rename( QFile::encodeName(sourceFileName).constData(),
+                     QFile::encodeName(targetFileName).constData() ) == 0;
+#elif defined(Q_OS_WIN)
+    const QString source = QDir::toNativeSeparators(sourceFileName);
+    const QString target = QDir::toNativeSeparators(targetFileName);
+    return MoveFileExW(
+                reinterpret_cast<const wchar_t*>(source.utf16()),
+                reinterpret_cast<const wchar_t*>(target.utf16()),
+                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+    QFile::remove(targetFileName);
+    return QFile::rename(sourceFileName, targetFileName);
+#endif
+}
+
+} // namespace
+
+bool writeFileAtomically(const QString &fileName, const QByteArray &bytes, QString *error)
+{
+    QFile tmpFile(fileName + ".tmp");
+    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
+        *error = tmpFile.errorString();
+        return false;
+    }
+
+    if ( tmpFile.write(bytes) != bytes.size() || !syncFile(&tmpFile) ) {
+        *error = tmpFile.errorString();
+        tmpFile.remove();
+        return false;
+    }
+    tmpFile.close();
+
+    if ( !replaceFile(tmpFile.fileName(), fileName) ) {
+        *error = QString("Failed to rename \"%1\"").arg(tmpFile.fileName());
+        tmpFile.remove();
+        return false;
+    }
+
+    syncDirectory( QFileInfo(fileName).absolutePath() );
+
+    return true;
+}
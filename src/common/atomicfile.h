@@ -0,0 +1,37 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+class QByteArray;
+class QString;
+
+/**
+ * Replace file content so that it survives crash or power loss.
+ *
+ * Data are written to a temporary file which is flushed to disk and renamed
+ * over the original file, then the directory is flushed. After crash the
+ * file contains either the old or the whole new content.
+ *
+ * On failure returns false and sets @a error.
+ */
+bool writeFileAtomically(const QString &fileName, const QByteArray &bytes, QString *error);
+
+#endif // ATOMICFILE_H
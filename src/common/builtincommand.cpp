@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "builtincommand.h"
+
+namespace {
+
+bool isNumber(const QString &text)
+{
+    bool ok;
+    text.toInt(&ok);
+    return ok;
+}
+
+bool isBuiltInCommandName(const QString &name)
+{
+    return name == "read"
+            || name == "add"
+            || name == "insert"
+            || name == "remove"
+            || name == "size"
+            || name == "length"
+            || name == "count"
+            || name == "tab";
+}
+
+} // namespace
+
+bool parseBuiltInCommand(const QStringList &args, BuiltInCommand *command)
+{
+    if ( args.value(0) != "copyq" )
+        return false;
+
+    int i = 1;
+    if ( args.value(i) == "tab" && i + 2 < args.size() ) {
+        command->tabName = args[i + 1];
+        i += 2;
+    }
+
+    command->name = args.value(i);
+    if ( !isBuiltInCommandName(command->name) )
+        return false;
+
+    command->arguments = args.mid(i + 1);
+
+    // Arguments with escape sequences and options are handled by client.
+    for (const auto &arg : command->arguments) {
+        if ( arg.contains('\\') || (arg.startsWith('-') && arg != "-" && !isNumber(arg)) )
+            return false;
+    }
+
+    // Listing tabs is the only supported form of "tab" command.
+    if ( command->name == "tab" && !command->arguments.isEmpty() )
+        return false;
+
+    return true;
+}
+
+bool isBuiltInCommand(const QStringList &args)
+{
+    BuiltInCommand command;
+    return parseBuiltInCommand(args, &command);
+}
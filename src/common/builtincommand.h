@@ -0,0 +1,50 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BUILTINCOMMAND_H
+#define BUILTINCOMMAND_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Simple "copyq" command which can run without script engine.
+ *
+ * E.g. "copyq read 0" or "copyq tab notes add -".
+ */
+struct BuiltInCommand {
+    QString tabName;
+    QString name;
+    QStringList arguments;
+};
+
+/**
+ * Parse arguments (starting with "copyq") of a command which can be possibly
+ * run without script engine.
+ *
+ * Returns false if the command needs script engine (unknown command,
+ * options or escape sequences in arguments).
+ */
+bool parseBuiltInCommand(const QStringList &args, BuiltInCommand *command);
+
+/// Returns true if parseBuiltInCommand() would succeed.
+bool isBuiltInCommand(const QStringList &args);
+
+#endif // BUILTINCOMMAND_H
@@ -21,6 +21,7 @@
 #include "common/config.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
 #include <QString>
@@ -46,3 +47,32 @@ QString clipboardServerName()
     return appName + "_" + qgetenv("USERNAME") + "_s";
 #endif
 }
+
+QString clipboardMessageDirectory()
+{
+#ifdef Q_OS_UNIX
+    // User runtime directory is in memory (tmpfs) and it's cleared on logout.
+    const QString runtimePath = QString::fromLocal8Bit( qgetenv("XDG_RUNTIME_DIR") );
+    if ( runtimePath.isEmpty() )
+        return QString();
+
+    // Directory is unique for server socket (which is in settings directory).
+    const QString appName = QCoreApplication::applicationName().toLower();
+    const QByteArray hash = QCryptographicHash::hash(
+                settingsDirectoryPath().toUtf8(), QCryptographicHash::Md5 ).toHex().left(8);
+    return runtimePath + "/" + appName + "_messages_" + QString::fromLatin1(hash);
+#else
+    return QString();
+#endif
+}
+
+void removeClipboardMessageFiles()
+{
+    const QString dirPath = clipboardMessageDirectory();
+    if ( dirPath.isEmpty() )
+        return;
+
+    QDir dir(dirPath);
+    for ( const auto &fileName : dir.entryList(QDir::Files | QDir::Hidden) )
+        dir.remove(fileName);
+}
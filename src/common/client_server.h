@@ -24,4 +24,15 @@ class QString;
 
 QString clipboardServerName();
 
+/**
+ * Directory in memory for big messages passed between server and clients in files.
+ *
+ * Returns empty string if there is no such directory (messages are passed
+ * through socket).
+ */
+QString clipboardMessageDirectory();
+
+/// Remove message files left behind by crashed or killed processes.
+void removeClipboardMessageFiles();
+
 #endif // CLIENT_SERVER_H
@@ -24,6 +24,12 @@
 #include "common/sleeptimer.h"
 
 #include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#include <limits>
 
 #define SOCKET_LOG(text) \
     COPYQ_LOG_VERBOSE( QString("Socket %1: %2").arg(m_socketId).arg(text) )
@@ -31,6 +37,15 @@
 namespace {
 
 const int bigMessageThreshold = 5 * 1024 * 1024;
+
+/// Messages bigger than this are passed in a file if possible.
+const int fileMessageThreshold = 1024 * 1024;
+
+/// Message is stored in a file; frame contains file path and size.
+/// The receiver removes the file right after opening it.
+const quint32 messageFlagFile = 0x80000000;
+const quint32 messageFlags = messageFlagFile;
+
 int lastSocketId = 0;
 
 template <typename T>
@@ -60,24 +75,19 @@ bool readValue(T *value, QByteArray *message)
     return stream.status() == QDataStream::Ok;
 }
 
-bool writeMessage(QLocalSocket *socket, const QByteArray &msg)
+bool writeFrame(QLocalSocket *socket, const QByteArray &msg, quint32 flags = 0)
 {
-    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes).").arg(msg.size()) );
-
-    if (msg.size() > bigMessageThreshold)
-        COPYQ_LOG( QString("Sending big message: %1 MiB").arg(msg.size() / 1024 / 1024) );
-
     QDataStream out(socket);
-    // length is serialized as a quint32, followed by msg
+    // length and flags are serialized as a quint32, followed by msg
     const auto length = static_cast<quint32>(msg.length());
-    out.writeBytes( msg.constData(), length );
+    out << (length | flags);
+    out.writeRawData( msg.constData(), msg.length() );
 
     if (out.status() != QDataStream::Ok) {
         COPYQ_LOG("Cannot write message!");
         return false;
     }
 
-    COPYQ_LOG_VERBOSE("Message written.");
     return true;
 }
 
@@ -179,7 +189,7 @@ void ClientSocket::sendMessage(const QByteArray &message, int messageCode)
         QDataStream out(&msg, QIODevice::WriteOnly);
         out << static_cast<qint32>(messageCode);
         out.writeRawData( message.constData(), message.length() );
-        if ( writeMessage(m_socket, msg) )
+        if ( writeMessage(msg) )
             SOCKET_LOG("Message sent to client.");
         else
             SOCKET_LOG("Failed to send message to client!");
@@ -219,6 +229,8 @@ void ClientSocket::onReadyRead()
                 return;
             }
             m_hasMessageLength = true;
+            m_messageFlags = m_messageLength & messageFlags;
+            m_messageLength &= ~messageFlags;
 
             if (m_messageLength > bigMessageThreshold)
                 COPYQ_LOG( QString("Receiving big message: %1 MiB").arg(m_messageLength / 1024 / 1024) );
@@ -229,15 +241,18 @@ void ClientSocket::onReadyRead()
             break;
 
         QByteArray msg = m_message.mid(0, length);
+        m_hasMessageLength = false;
+        m_message = m_message.mid(length);
+
+        if ( (m_messageFlags & messageFlagFile) && !readFileMessage(&msg) )
+            return;
+
         qint32 messageCode;
         if ( !readValue(&messageCode, &msg) ) {
             error("Failed to read message code from client!");
             return;
         }
 
-        m_hasMessageLength = false;
-        m_message = m_message.mid(length);
-
         emit messageReceived(msg, messageCode, this);
     }
 }
@@ -272,6 +287,114 @@ void ClientSocket::onStateChanged(QLocalSocket::LocalSocketState state)
     }
 }
 
+bool ClientSocket::writeMessage(const QByteArray &msg)
+{
+    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes).").arg(msg.size()) );
+
+    if (msg.size() > bigMessageThreshold)
+        COPYQ_LOG( QString("Sending big message: %1 MiB").arg(msg.size() / 1024 / 1024) );
+
+    if ( msg.size() > fileMessageThreshold && writeFileMessage(msg) )
+        return true;
+
+    if ( static_cast<quint32>(msg.length()) & messageFlags ) {
+        COPYQ_LOG("Message is too big!");
+        return false;
+    }
+
+    if ( !writeFrame(m_socket, msg) )
+        return false;
+
+    COPYQ_LOG_VERBOSE("Message written.");
+    return true;
+}
+
+bool ClientSocket::writeFileMessage(const QByteArray &msg)
+{
+    const QString dirPath = clipboardMessageDirectory();
+    if ( dirPath.isEmpty() || !QDir(dirPath).mkpath(".") )
+        return false;
+
+    // Files left by processes which crashed before the message was read
+    // are removed when server starts.
+    QTemporaryFile file(dirPath + "/message");
+    file.setAutoRemove(false);
+    if ( !file.open() ) {
+        COPYQ_LOG( QString("Failed to create message file: %1").arg(file.errorString()) );
+        return false;
+    }
+
+    if ( file.write(msg) != msg.size() || !file.flush() ) {
+        COPYQ_LOG( QString("Failed to write message file: %1").arg(file.errorString()) );
+        file.remove();
+        return false;
+    }
+
+    QByteArray body;
+    {
+        QDataStream out(&body, QIODevice::WriteOnly);
+        out << file.fileName() << static_cast<qint64>(msg.size());
+    }
+
+    if ( !writeFrame(m_socket, body, messageFlagFile) ) {
+        file.remove();
+        return false;
+    }
+
+    COPYQ_LOG_VERBOSE("Message written to file.");
+    return true;
+}
+
+bool ClientSocket::readFileMessage(QByteArray *msg)
+{
+    QString fileName;
+    qint64 size;
+    {
+        QDataStream in(*msg);
+        in >> fileName >> size;
+        if (in.status() != QDataStream::Ok) {
+            error("Failed to read message file name from client!");
+            return false;
+        }
+    }
+
+    // Accept only files in message directory.
+    const QString dirPath = clipboardMessageDirectory();
+    if ( dirPath.isEmpty() || QFileInfo(fileName).absolutePath() != QDir(dirPath).absolutePath() ) {
+        error("Unexpected message file path!");
+        return false;
+    }
+
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        error("Failed to open message file: " + file.errorString());
+        return false;
+    }
+
+    // File is not needed once opened so it's not left behind if reading fails.
+    QFile::remove(fileName);
+
+    if ( file.size() != size || size > std::numeric_limits<int>::max() ) {
+        error("Unexpected message file size!");
+        return false;
+    }
+
+    const auto data = file.map(0, size);
+    if (data) {
+        *msg = QByteArray( reinterpret_cast<const char*>(data), static_cast<int>(size) );
+        file.unmap(data);
+    } else {
+        *msg = file.readAll();
+    }
+
+    if ( msg->size() != size ) {
+        error("Failed to read message file!");
+        return false;
+    }
+
+    return true;
+}
+
 void ClientSocket::error(const QString &errorMessage)
 {
     log(errorMessage, LogError);
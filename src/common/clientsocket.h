@@ -86,12 +86,17 @@ private slots:
 private:
     void error(const QString &errorMessage);
 
+    bool writeMessage(const QByteArray &msg);
+    bool writeFileMessage(const QByteArray &msg);
+    bool readFileMessage(QByteArray *msg);
+
     LocalSocketGuard m_socket;
     int m_socketId;
     bool m_closed;
 
     bool m_hasMessageLength = false;
     quint32 m_messageLength = 0;
+    quint32 m_messageFlags = 0;
     QByteArray m_message;
 };
 
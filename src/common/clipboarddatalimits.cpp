@@ -0,0 +1,222 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clipboarddatalimits.h"
+
+#include "common/appconfig.h"
+#include "common/config.h"
+#include "common/log.h"
+#include "common/mimetypes.h"
+
+#include <QCryptographicHash>
+#include <QStringList>
+
+namespace {
+
+bool parseSize(const QString &text, qint64 *size)
+{
+    QString number = text.trimmed().toUpper();
+    qint64 multiplier = 1;
+    if ( number.endsWith('K') )
+        multiplier = 1024;
+    else if ( number.endsWith('M') )
+        multiplier = 1024 * 1024;
+    else if ( number.endsWith('G') )
+        multiplier = 1024 * 1024 * 1024;
+
+    if (multiplier != 1)
+        number.chop(1);
+
+    bool ok;
+    const qint64 value = number.toLongLong(&ok);
+    if (!ok || value < 0)
+        return false;
+
+    *size = value * multiplier;
+    return true;
+}
+
+bool parsePolicy(const QString &text, ClipboardDataPolicy *policy)
+{
+    const QString name = text.trimmed().toLower();
+    if (name == "truncate")
+        *policy = ClipboardDataPolicy::Truncate;
+    else if (name == "file")
+        *policy = ClipboardDataPolicy::StoreToFile;
+    else if (name == "hash")
+        *policy = ClipboardDataPolicy::Hash;
+    else if (name == "skip")
+        *policy = ClipboardDataPolicy::Skip;
+    else
+        return false;
+
+    return true;
+}
+
+const ClipboardDataLimit *findLimit(const ClipboardDataLimits &limits, const QString &format)
+{
+    for (const auto &limit : limits) {
+        if ( limit.format.exactMatch(format) )
+            return &limit;
+    }
+
+    return nullptr;
+}
+
+QByteArray truncateData(const QByteArray &bytes, const QString &format, qint64 maxSize)
+{
+    const int size = static_cast<int>(maxSize);
+    if ( format.startsWith("text/") )
+        return bytes.left( utf8Boundary(bytes, size) );
+    return bytes.left(size);
+}
+
+QByteArray dataHash(const QByteArray &bytes)
+{
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex();
+}
+
+QString policyName(ClipboardDataPolicy policy)
+{
+    switch (policy) {
+    case ClipboardDataPolicy::Truncate:
+        return "truncate";
+    case ClipboardDataPolicy::StoreToFile:
+        return "file";
+    case ClipboardDataPolicy::Hash:
+        return "hash";
+    case ClipboardDataPolicy::Skip:
+        return "skip";
+    }
+
+    return QString();
+}
+
+} // namespace
+
+int utf8Boundary(const QByteArray &bytes, int size)
+{
+    int i = size;
+    while ( i > 0 && (static_cast<uchar>(bytes[i - 1]) & 0xC0) == 0x80 )
+        --i;
+
+    if (i == 0)
+        return size;
+
+    const auto lead = static_cast<uchar>(bytes[i - 1]);
+    const int charSize = (lead & 0xF8) == 0xF0 ? 4
+                       : (lead & 0xF0) == 0xE0 ? 3
+                       : (lead & 0xE0) == 0xC0 ? 2
+                       : 1;
+
+    return size - (i - 1) < charSize ? i - 1 : size;
+}
+
+ClipboardDataLimits parseClipboardDataLimits(const QString &text)
+{
+    ClipboardDataLimits limits;
+
+    for ( const auto &entry : text.split(QRegExp("[,\\n]"), QString::SkipEmptyParts) ) {
+        if ( entry.trimmed().isEmpty() )
+            continue;
+
+        const int formatEnd = entry.indexOf('=');
+        const int sizeEnd = entry.lastIndexOf(':');
+
+        ClipboardDataLimit limit;
+        if ( formatEnd == -1 || sizeEnd < formatEnd
+             || !parseSize(entry.mid(formatEnd + 1, sizeEnd - formatEnd - 1), &limit.maxSize)
+             || !parsePolicy(entry.mid(sizeEnd + 1), &limit.policy) )
+        {
+            log( QString("Invalid clipboard data limit: %1").arg(entry.trimmed()), LogWarning );
+            continue;
+        }
+
+        limit.format = QRegExp(entry.left(formatEnd).trimmed(), Qt::CaseInsensitive, QRegExp::Wildcard);
+        limits.append(limit);
+    }
+
+    return limits;
+}
+
+ClipboardDataLimits clipboardDataLimits()
+{
+    static QString lastText;
+    static ClipboardDataLimits limits;
+
+    const QString text = AppConfig().option<Config::clipboard_data_limits>();
+    if (text != lastText) {
+        lastText = text;
+        limits = parseClipboardDataLimits(text);
+    }
+
+    return limits;
+}
+
+void applyClipboardDataLimits(const ClipboardDataLimits &limits, QVariantMap *data)
+{
+    if ( limits.isEmpty() )
+        return;
+
+    QByteArray files = data->value(mimeDataFiles).toByteArray();
+    QByteArray hashes = data->value(mimeDataHashes).toByteArray();
+
+    for ( const auto &format : data->keys() ) {
+        if ( format.startsWith(COPYQ_MIME_PREFIX) )
+            continue;
+
+        const auto limit = findLimit(limits, format);
+        if (!limit)
+            continue;
+
+        const QByteArray bytes = data->value(format).toByteArray();
+        if (bytes.size() <= limit->maxSize)
+            continue;
+
+        COPYQ_LOG( QString("Clipboard format \"%1\" has %2 bytes, applying policy \"%3\"")
+                   .arg(format)
+                   .arg(bytes.size())
+                   .arg(policyName(limit->policy)) );
+
+        switch (limit->policy) {
+        case ClipboardDataPolicy::Truncate:
+            data->insert( format, truncateData(bytes, format, limit->maxSize) );
+            break;
+
+        case ClipboardDataPolicy::StoreToFile:
+            // Data are stored once the item is added in the server.
+            files.append( format.toUtf8() + "\t\n" );
+            break;
+
+        case ClipboardDataPolicy::Hash:
+            hashes.append( format.toUtf8() + '\t' + dataHash(bytes) + '\n' );
+            data->remove(format);
+            break;
+
+        case ClipboardDataPolicy::Skip:
+            data->remove(format);
+            break;
+        }
+    }
+
+    if ( !files.isEmpty() )
+        data->insert(mimeDataFiles, files);
+    if ( !hashes.isEmpty() )
+        data->insert(mimeDataHashes, hashes);
+}
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIPBOARDDATALIMITS_H
+#define CLIPBOARDDATALIMITS_H
+
+#include <QRegExp>
+#include <QVariantMap>
+#include <QVector>
+
+class QString;
+
+enum class ClipboardDataPolicy {
+    /// Keep only beginning of the data.
+    Truncate,
+    /// Save data to a file in BlobStore (in the server) and keep only digest of the data.
+    StoreToFile,
+    /// Keep only hash of the data so same content is not added again.
+    Hash,
+    /// Drop the data.
+    Skip
+};
+
+struct ClipboardDataLimit {
+    QRegExp format;
+    qint64 maxSize = 0;
+    ClipboardDataPolicy policy = ClipboardDataPolicy::Skip;
+};
+
+using ClipboardDataLimits = QVector<ClipboardDataLimit>;
+
+/**
+ * Parse size limits for clipboard formats.
+ *
+ * Entries are separated by comma or new line and have format
+ * "FORMAT=SIZE:POLICY", e.g. "text/*=10M:truncate, *=100M:file".
+ *
+ * FORMAT can contain wildcards, SIZE is number of bytes with optional K, M or G
+ * suffix and POLICY is one of "truncate", "file", "hash" or "skip".
+ *
+ * Invalid entries are skipped and reported in log.
+ */
+ClipboardDataLimits parseClipboardDataLimits(const QString &text);
+
+/**
+ * Return size to truncate UTF-8 text to so that the last multi-byte
+ * character is not split (@a size must not exceed size of the text).
+ */
+int utf8Boundary(const QByteArray &bytes, int size);
+
+/// Return limits from configuration (option "clipboard_data_limits").
+ClipboardDataLimits clipboardDataLimits();
+
+/**
+ * Apply the first matching limit to each format bigger than the limit.
+ *
+ * Internal formats are never limited.
+ *
+ * Hashes are kept in mimeDataHashes ("FORMAT\tHASH" on each line).
+ *
+ * Formats to store in a file are listed in mimeDataFiles without digest
+ * ("FORMAT\t" on each line) and the data are kept. The server stores the data
+ * once the item is added and keeps only the digest (see BlobStore::storeDataFiles()).
+ */
+void applyClipboardDataLimits(const ClipboardDataLimits &limits, QVariantMap *data);
+
+#endif // CLIPBOARDDATALIMITS_H
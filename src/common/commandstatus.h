@@ -36,6 +36,21 @@ enum CommandStatus {
 
     CommandFunctionCall = 8,
     CommandFunctionCallReturnValue = 9,
+
+    /** Run simple built-in command directly in server (without script engine) */
+    CommandBuiltInCall = 10,
+    /** Server cannot run the built-in command; client has to run it */
+    CommandBuiltInCallRejected = 11,
+
+    /** Run script in server (client option "--in-server") */
+    CommandScriptCall = 12,
+    /** Script running in server requests standard input from client */
+    CommandReadInput = 13,
+    /** Standard input for script running in server */
+    CommandInput = 14,
+
+    /** Function call with arguments in fixed binary layout (see ScriptableProxy::callTypedFunction()) */
+    CommandTypedFunctionCall = 15,
 };
 
 #endif // COMMANDSTATUS_H
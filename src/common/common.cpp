@@ -31,6 +31,7 @@
 #include <QDropEvent>
 #include <QDir>
 #include <QImage>
+#include <QImageReader>
 #include <QImageWriter>
 #include <QKeyEvent>
 #include <QMimeData>
@@ -57,6 +58,14 @@ namespace {
 
 const int maxElidedTextLineLength = 512;
 
+const char mimeQtImage[] = "application/x-qt-image";
+
+/// Preferred format for storing images converted from clipboard.
+const char mimeCanonicalImage[] = "image/png";
+
+/// Maximum number of image conversions kept in ClipboardMimeData.
+const int maxConvertedImageCount = 2;
+
 QString getImageFormatFromMime(const QString &mime)
 {
     const auto imageMimePrefix = "image/";
@@ -75,19 +84,19 @@ QImage getImageData(const QMimeData &data)
 }
 
 /**
+ * Converts image to given format.
+ *
  * Sometimes only Qt internal image data are available in cliboard,
- * so this tries to convert the image data (if available) to given format.
+ * so this is used to store the image in some real format.
  */
-void cloneImageData(
-        const QImage &image, const QString &format,
-        const QString &mime, QVariantMap *dataMap)
+QByteArray convertImage(const QImage &image, const QString &format)
 {
     if (image.isNull())
-        return;
+        return QByteArray();
 
     // Omit converting unsupported formats (takes too much time and still fails).
     if ( !QImageWriter::supportedImageFormats().contains(format.toUtf8()) )
-        return;
+        return QByteArray();
 
     QBuffer buffer;
     bool saved = image.save(&buffer, format.toUtf8().constData());
@@ -96,34 +105,115 @@ void cloneImageData(
                .arg(format,
                     saved ? "Done" : "Failed") );
 
-    if (saved)
-        dataMap->insert(mime, buffer.buffer());
+    return saved ? buffer.buffer() : QByteArray();
 }
 
-bool setImageData(const QVariantMap &data, const QString &mime, QMimeData *mimeData)
+/// Converts image to the first supported format from the list.
+void cloneImageData(const QImage &image, QStringList mimes, QVariantMap *dataMap)
 {
-    if ( !data.contains(mime) )
-        return false;
+    // Store single image format, other formats are converted when pasted.
+    if ( mimes.removeOne(mimeCanonicalImage) )
+        mimes.prepend(mimeCanonicalImage);
 
-    const QString imageFormat = getImageFormatFromMime(mime);
-    if ( imageFormat.isEmpty() )
-        return false;
+    for (const auto &mime : mimes) {
+        const QByteArray bytes = convertImage( image, getImageFormatFromMime(mime) );
+        if ( !bytes.isEmpty() ) {
+            dataMap->insert(mime, bytes);
+            return;
+        }
+    }
+}
 
-    QByteArray bytes = data.value(mime).toByteArray();
+bool isAnimatedImage(const QByteArray &imageData, const QString &imageFormat)
+{
+    const QByteArray format = imageFormat.toUtf8();
+    if ( !QMovie::supportedFormats().contains(format) )
+        return false;
 
-    // Omit converting animated images to static ones.
+    QByteArray bytes = imageData;
     QBuffer buffer(&bytes);
-    QMovie animatedImage( &buffer, imageFormat.toUtf8().constData() );
-    if ( animatedImage.frameCount() > 1 )
-        return false;
+    QMovie animatedImage( &buffer, format.constData() );
+    return animatedImage.frameCount() > 1;
+}
 
-    const QImage image = QImage::fromData( bytes, imageFormat.toUtf8().constData() );
-    if ( image.isNull() )
-        return false;
+/**
+ * Clipboard data with image formats converted only when requested.
+ *
+ * Item usually contains only single image format. The image is decoded
+ * (for application/x-qt-image) and converted to other image formats only
+ * when an application asks for the data. Last few conversions are cached.
+ */
+class ClipboardMimeData final : public QMimeData
+{
+public:
+    /// Use given image data as source for other image formats.
+    void setSourceImage(const QString &mime)
+    {
+        m_sourceImageMime = mime;
+    }
 
-    mimeData->setImageData(image);
-    return true;
-}
+    bool hasFormat(const QString &mime) const override
+    {
+        return QMimeData::hasFormat(mime)
+                || (mime == mimeQtImage && !m_sourceImageMime.isEmpty());
+    }
+
+    QStringList formats() const override
+    {
+        QStringList result = QMimeData::formats();
+        if ( !m_sourceImageMime.isEmpty() && !result.contains(mimeQtImage) )
+            result.append(mimeQtImage);
+        return result;
+    }
+
+protected:
+    QVariant retrieveData(const QString &mime, QVariant::Type type) const override
+    {
+        if ( QMimeData::hasFormat(mime) || m_sourceImageMime.isEmpty() )
+            return QMimeData::retrieveData(mime, type);
+
+        if (mime == mimeQtImage)
+            return sourceImage();
+
+        const QString imageFormat = getImageFormatFromMime(mime);
+        if ( imageFormat.isEmpty() )
+            return QVariant();
+
+        for (const auto &converted : m_convertedImages) {
+            if (converted.first == mime)
+                return converted.second;
+        }
+
+        const QByteArray bytes = convertImage(sourceImage(), imageFormat);
+        if ( !bytes.isEmpty() ) {
+            if ( m_convertedImages.size() >= maxConvertedImageCount )
+                m_convertedImages.removeFirst();
+            m_convertedImages.append( qMakePair(mime, bytes) );
+        }
+
+        return bytes;
+    }
+
+private:
+    const QImage &sourceImage() const
+    {
+        if (!m_sourceImageLoaded) {
+            m_sourceImageLoaded = true;
+            const QString imageFormat = getImageFormatFromMime(m_sourceImageMime);
+            const QByteArray bytes = QMimeData::data(m_sourceImageMime);
+            m_sourceImage = QImage::fromData( bytes, imageFormat.toUtf8().constData() );
+            COPYQ_LOG( QString("Decoding image from \"%1\": %2")
+                       .arg(m_sourceImageMime, m_sourceImage.isNull() ? "Failed" : "Done") );
+        }
+
+        return m_sourceImage;
+    }
+
+    QString m_sourceImageMime;
+    mutable bool m_sourceImageLoaded = false;
+    mutable QImage m_sourceImage;
+    mutable QList< QPair<QString, QByteArray> > m_convertedImages;
+};
 
 QTextCodec *codecForText(const QByteArray &bytes)
 {
@@ -207,8 +297,8 @@ QVariantMap cloneData(const QMimeData &data, QStringList formats)
 
     QVariantMap newdata;
 
-    QImage image;
-    bool imageLoaded = false;
+    QStringList missingImageFormats;
+    bool hasImage = false;
 
     // Ignore image data if text is available.
     if ( formats.contains(mimeText) && data.hasFormat(mimeText) ) {
@@ -235,18 +325,25 @@ QVariantMap cloneData(const QMimeData &data, QStringList formats)
 #endif
 
         const QByteArray bytes = getUtf8Data(data, mime);
+        const bool isImage = !getImageFormatFromMime(mime).isEmpty();
         if ( !bytes.isEmpty() ) {
             newdata.insert(mime, bytes);
-        } else if ( !imageLoaded || !image.isNull() ) {
-            const QString format = getImageFormatFromMime(mime);
-            if ( !format.isEmpty() ) {
-                if (!imageLoaded) {
-                    image = getImageData(data);
-                    imageLoaded = true;
-                }
-                cloneImageData(image, format, mime, &newdata);
-            }
+            hasImage = hasImage || isImage;
+        } else if (isImage) {
+            missingImageFormats.append(mime);
+        }
+    }
+
+    // Convert image only if no image format is available.
+    if ( !hasImage && !missingImageFormats.isEmpty() ) {
+#ifdef PROCESS_EVENTS_BEFORE_CLIPBOARD_DATA
+        if (dataGuard.isNull()) {
+            log("Clipboard data lost", LogWarning);
+            return newdata;
         }
+#endif
+        const QImage image = getImageData(data);
+        cloneImageData(image, missingImageFormats, &newdata);
     }
 
     for (const auto &internalMime : internalMimeTypes) {
@@ -283,7 +380,7 @@ QMimeData* createMimeData(const QVariantMap &data)
     QStringList copyFormats = data.keys();
     copyFormats.removeOne(mimeClipboardMode);
 
-    std::unique_ptr<QMimeData> newClipboardData(new QMimeData);
+    std::unique_ptr<ClipboardMimeData> newClipboardData(new ClipboardMimeData);
 
     for ( const auto &format : copyFormats )
         newClipboardData->setData( format, data[format].toByteArray() );
@@ -294,12 +391,22 @@ QMimeData* createMimeData(const QVariantMap &data)
 #endif
         newClipboardData->setData( mimeOwner, qgetenv("COPYQ_SESSION_NAME") );
 
-    // Set image data.
-    const QStringList formats =
-            QStringList() << "image/png" << "image/bmp" << "application/x-qt-image" << data.keys();
-    for (const auto &imageFormat : formats) {
-        if ( setImageData(data, imageFormat, newClipboardData.get()) )
-            break;
+    // Set source for other image formats (image is decoded and converted only if requested).
+    const QStringList formats = QStringList() << "image/png" << "image/bmp" << data.keys();
+    for (const auto &mime : formats) {
+        const QString imageFormat = getImageFormatFromMime(mime);
+        if ( imageFormat.isEmpty() || !data.contains(mime) )
+            continue;
+
+        if ( !QImageReader::supportedImageFormats().contains(imageFormat.toUtf8()) )
+            continue;
+
+        // Omit converting animated images to static ones.
+        if ( isAnimatedImage(data[mime].toByteArray(), imageFormat) )
+            continue;
+
+        newClipboardData->setSourceImage(mime);
+        break;
     }
 
     return newClipboardData.release();
@@ -23,6 +23,7 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QString>
 #include <QSystemSemaphore>
 #include <QThread>
@@ -94,6 +95,9 @@ THREAD_LOCAL char currentThreadLabel[maxThreadLabelSize + 1] = "";
 const int logFileSize = 512 * 1024;
 const int logFileCount = 10;
 
+/// Size of log file beginning used to detect rotated log files.
+const int logFileHeadSize = 256;
+
 const char propertySessionMutex[] = "CopyQ_Session_Mutex";
 
 int getLogLevel()
@@ -210,18 +214,32 @@ QString getDefaultLogFilePath()
 #endif
 }
 
-QString readLogFile(const QString &fileName, int maxReadSize)
+QByteArray readLogFile(const QString &fileName, qint64 maxReadSize)
 {
     QFile f(fileName);
     if ( !f.open(QIODevice::ReadOnly) )
-        return QString();
+        return QByteArray();
 
     const auto seek = f.size() - maxReadSize;
     if (seek > 0)
         f.seek(seek);
-    const QByteArray content = f.readAll();
+    return f.readAll();
+}
+
+QByteArray readLogFileFrom(const QString &fileName, qint64 position)
+{
+    QFile f(fileName);
+    if ( !f.open(QIODevice::ReadOnly) || !f.seek(position) )
+        return QByteArray();
+    return f.readAll();
+}
 
-    return QString::fromUtf8(content);
+QByteArray readLogFileHead(const QString &fileName)
+{
+    QFile f(fileName);
+    if ( !f.open(QIODevice::ReadOnly) )
+        return QByteArray();
+    return f.read(logFileHeadSize);
 }
 
 QString logFileName(int i)
@@ -275,18 +293,42 @@ QString logFileName()
     return path + "/copyq.log";
 }
 
-QString readLogFile(int maxReadSize)
+QByteArray readLogFileChanges(LogFilePosition *position, qint64 maxReadSize)
 {
+    // Lock only for reading files, not for processing the content.
     SystemMutexLocker lock(getSessionMutex());
 
-    QString content;
-    for (int i = 0; i < logFileCount; ++i) {
-        const int toRead = maxReadSize - content.size();
-        content.prepend( readLogFile(logFileName(i), toRead) );
-        if ( maxReadSize <= content.size() )
-            break;
+    const QString fileName = logFileName(0);
+    const qint64 size = QFileInfo(fileName).size();
+    const QByteArray head = readLogFileHead(fileName);
+
+    QByteArray content;
+    if (position->size < 0) {
+        for (int i = 0; i < logFileCount; ++i) {
+            const qint64 toRead = maxReadSize - content.size();
+            content.prepend( readLogFile(logFileName(i), toRead) );
+            if ( maxReadSize <= content.size() )
+                break;
+        }
+    } else {
+        // Log file was rotated if it's smaller or starts differently
+        // (new file can grow past the previous position before next read).
+        qint64 readFrom = position->size;
+        if ( size < readFrom || !head.startsWith(position->head) ) {
+            // Rest of the previous log file was moved to first rotated file
+            // (unless rotated multiple times since last read).
+            const QString rotatedFileName = logFileName(1);
+            if ( readLogFileHead(rotatedFileName).startsWith(position->head) )
+                content = readLogFileFrom(rotatedFileName, readFrom);
+            readFrom = 0;
+        }
+
+        if (size > readFrom)
+            content.append( readLogFileFrom(fileName, readFrom) );
     }
 
+    position->size = size;
+    position->head = head;
     return content;
 }
 
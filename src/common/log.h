@@ -20,7 +20,9 @@
 #ifndef LOG_H
 #define LOG_H
 
-class QByteArray;
+#include <QByteArray>
+#include <QtGlobal>
+
 class QString;
 
 enum LogLevel {
@@ -34,7 +36,21 @@ enum LogLevel {
 
 QString logFileName();
 
-QString readLogFile(int maxReadSize);
+/// Position in log files after last read (see readLogFileChanges()).
+struct LogFilePosition {
+    /// Size of the current log file after last read or negative if nothing was read.
+    qint64 size = -1;
+    /// Beginning of the current log file, identifies the file after rotation.
+    QByteArray head;
+};
+
+/**
+ * Read log content written after @a position and update the position.
+ *
+ * Rotated log files are handled. If @a position is not set, reads at most
+ * @a maxReadSize bytes from the end of all log files.
+ */
+QByteArray readLogFileChanges(LogFilePosition *position, qint64 maxReadSize);
 
 void createSessionMutex();
 
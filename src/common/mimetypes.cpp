@@ -36,3 +36,6 @@ const char mimeColor[] = COPYQ_MIME_PREFIX "color";
 const char mimeOutputTab[] = COPYQ_MIME_PREFIX "output-tab";
 const char mimeSyncToClipboard[] = COPYQ_MIME_PREFIX "sync-to-clipboard";
 const char mimeSyncToSelection[] = COPYQ_MIME_PREFIX "sync-to-selection";
+const char mimeStreamedInput[] = COPYQ_MIME_PREFIX "streamed-input";
+const char mimeDataFiles[] = COPYQ_MIME_PREFIX "data-files";
+const char mimeDataHashes[] = COPYQ_MIME_PREFIX "data-hashes";
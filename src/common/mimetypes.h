@@ -38,5 +38,8 @@ extern const char mimeColor[];
 extern const char mimeOutputTab[];
 extern const char mimeSyncToClipboard[];
 extern const char mimeSyncToSelection[];
+extern const char mimeStreamedInput[];
+extern const char mimeDataFiles[];
+extern const char mimeDataHashes[];
 
 #endif // MIMETYPES_H
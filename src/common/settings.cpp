@@ -25,11 +25,39 @@
 
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QStringList>
 
 namespace {
 
+int settingsGeneration = 0;
+
+/// Number of instances with unsaved changes.
+int changedSettingsCount = 0;
+
+/// Interval for checking changes in settings files.
+const int checkSettingsFilesIntervalMs = 1000;
+
+struct SettingsFileState {
+    QDateTime lastModified;
+    qint64 size;
+
+    bool operator==(const SettingsFileState &other) const
+    {
+        return lastModified == other.lastModified && size == other.size;
+    }
+};
+
+SettingsFileState settingsFileState(const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    SettingsFileState state;
+    state.lastModified = info.lastModified();
+    state.size = info.exists() ? info.size() : -1;
+    return state;
+}
+
 bool needsUpdate(const Settings &newSettings, const QSettings &oldSettings)
 {
     if ( Settings::isEmpty(oldSettings) )
@@ -102,6 +130,9 @@ Settings::Settings()
 
 Settings::~Settings()
 {
+    if (m_changed)
+        --changedSettingsCount;
+
     // Only main application is allowed to change settings.
     if (canModifySettings() && m_changed) {
         m_settings.sync();
@@ -115,6 +146,58 @@ Settings::~Settings()
     }
 }
 
+int Settings::generation()
+{
+    return settingsGeneration;
+}
+
+bool Settings::reloadChangedFiles()
+{
+    static QElapsedTimer lastCheck;
+    if ( lastCheck.isValid() && lastCheck.elapsed() < checkSettingsFilesIntervalMs )
+        return false;
+    lastCheck.start();
+
+    static const QString fileName = QSettings().fileName();
+    static const QString backupFileName = Settings().fileName();
+    static SettingsFileState state = settingsFileState(fileName);
+    static SettingsFileState backupState = settingsFileState(backupFileName);
+
+    const SettingsFileState newState = settingsFileState(fileName);
+    SettingsFileState newBackupState = settingsFileState(backupFileName);
+    if (newState == state && newBackupState == backupState)
+        return false;
+
+    // Copy application settings changed by hand.
+    if ( !(newState == state) && canModifySettings()
+         && changedSettingsCount == 0 && !isLastSaveUnfinished() )
+    {
+        Settings appSettings;
+        const QSettings settings;
+        if ( needsUpdate(appSettings, settings) ) {
+            COPYQ_LOG("Reloading changed application settings");
+            copySettings(settings, &appSettings.m_settings);
+            newBackupState = settingsFileState(backupFileName);
+        }
+    }
+
+    state = newState;
+    backupState = newBackupState;
+    ++settingsGeneration;
+    return true;
+}
+
+void Settings::setChanged()
+{
+    if (!m_changed) {
+        m_changed = true;
+        ++changedSettingsCount;
+    }
+
+    // Let other instances see the modified values.
+    ++settingsGeneration;
+}
+
 void Settings::restore()
 {
     Settings appSettings;
@@ -58,22 +58,44 @@ public:
 
     static void restore();
 
+    /**
+     * Number of times settings were changed.
+     *
+     * Incremented whenever a value is modified in this process or
+     * settings files are changed by other process or by hand
+     * (see reloadChangedFiles()).
+     */
+    static int generation();
+
+    /**
+     * Check if settings files were changed outside this process.
+     *
+     * Files are checked at most once a second. If the application settings
+     * were changed by hand, main application copies them to settings copy
+     * (only if no instance has unsaved changes).
+     *
+     * Returns true if the files changed (and increments generation()).
+     */
+    static bool reloadChangedFiles();
+
     bool isEmpty() const { return isEmpty(m_settings); }
 
     QVariant value(const QString &name) const { return m_settings.value(name); }
 
+    QStringList allKeys() const { return m_settings.allKeys(); }
+
     void setValue(const QString &name, const QVariant &value) {
-        m_changed = true;
+        setChanged();
         m_settings.setValue(name, value);
     }
 
     void remove(const QString &name) {
-        m_changed = true;
+        setChanged();
         m_settings.remove(name);
     }
 
     void clear() {
-        m_changed = true;
+        setChanged();
         m_settings.clear();
     }
 
@@ -90,7 +112,7 @@ public:
     }
 
     void beginWriteArray(const QString &prefix, int size = -1) {
-        m_changed = true;
+        setChanged();
         m_settings.beginWriteArray(prefix, size);
     }
 
@@ -107,7 +129,7 @@ public:
     }
 
     QSettings *settingsData() {
-        m_changed = true;
+        setChanged();
         return &m_settings;
     }
 
@@ -115,6 +137,8 @@ public:
     Settings &operator=(const Settings &) = delete;
 
 private:
+    void setChanged();
+
     QSettings m_settings;
 
     /// True only if QSetting data changed and need to be synced.
@@ -27,6 +27,7 @@
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "gui/actionhistory.h"
 #include "gui/notification.h"
 #include "gui/processmanagerdialog.h"
 #include "gui/clipboardbrowser.h"
@@ -40,6 +41,9 @@
 
 namespace {
 
+const int maxActionHistorySize = 1000;
+const int maxActionStatisticsSize = 200;
+
 QString actionDescription(const Action &action)
 {
     const auto name = action.name();
@@ -55,8 +59,16 @@ ActionHandler::ActionHandler(MainWindow *mainWindow)
     : QObject(mainWindow)
     , m_wnd(mainWindow)
     , m_activeActionDialog(new ProcessManagerDialog(mainWindow))
+    , m_history(new ActionHistoryModel(maxActionHistorySize, this))
+    , m_statistics(new ActionStatisticsModel(maxActionStatisticsSize, this))
+    , m_builtInCommandRunner(mainWindow)
 {
     Q_ASSERT(mainWindow);
+
+    m_activeActionDialog->setActionHistoryModels(m_history, m_statistics);
+
+    connect( m_activeActionDialog, SIGNAL(cancelActionRequested(Action*)),
+             this, SLOT(cancelQueuedAction(Action*)) );
 }
 
 void ActionHandler::showProcessManagerDialog()
@@ -82,9 +94,14 @@ void ActionHandler::setActionData(int id, const QVariantMap &data)
         action->setData(data);
 }
 
-void ActionHandler::internalAction(Action *action)
+QVector<QVariantMap> ActionHandler::actionHistory() const
+{
+    return m_history->toVariantMaps();
+}
+
+void ActionHandler::internalAction(Action *action, ActionCategory category, const QString &coalescingKey)
 {
-    this->action(action);
+    scheduleAction(action, category, coalescingKey);
     if ( m_actions.contains(action->id()) )
         m_internalActions.insert(action->id());
 }
@@ -96,20 +113,7 @@ bool ActionHandler::isInternalActionId(int id) const
 
 void ActionHandler::action(Action *action)
 {
-    action->setParent(this);
-
-    const auto id = ++m_lastActionId;
-    action->setId(id);
-    m_actions.insert(id, action);
-
-    connect( action, SIGNAL(actionStarted(Action*)),
-             this, SLOT(actionStarted(Action*)) );
-    connect( action, SIGNAL(actionFinished(Action*)),
-             this, SLOT(closeAction(Action*)) );
-
-    m_activeActionDialog->actionAboutToStart(action);
-    COPYQ_LOG( QString("Executing: %1").arg(actionDescription(*action)) );
-    action->start();
+    scheduleAction(action, ActionCategory::Interactive, QString());
 }
 
 void ActionHandler::actionStarted(Action *action)
@@ -123,6 +127,10 @@ void ActionHandler::closeAction(Action *action)
     m_actions.remove(action->id());
     m_internalActions.remove(action->id());
 
+    const auto historyEntry = createActionHistoryEntry(*action);
+    m_history->addEntry(historyEntry);
+    m_statistics->addEntry(historyEntry);
+
     QString msg;
 
     QSystemTrayIcon::MessageIcon icon = QSystemTrayIcon::Information;
@@ -170,4 +178,70 @@ void ActionHandler::closeAction(Action *action)
     emit runningActionsCountChanged();
 
     action->deleteLater();
+
+    m_scheduler.remove(action);
+    startQueuedActions();
+}
+
+bool ActionHandler::cancelQueuedAction(Action *action)
+{
+    if ( !m_scheduler.isQueued(action) )
+        return false;
+
+    m_scheduler.remove(action);
+    cancelAction(action);
+    m_activeActionDialog->setQueueStatistics(m_scheduler);
+    return true;
+}
+
+void ActionHandler::scheduleAction(Action *action, ActionCategory category, const QString &coalescingKey)
+{
+    action->setParent(this);
+
+    const auto id = ++m_lastActionId;
+    action->setId(id);
+    action->setInternalCommandRunner(&m_builtInCommandRunner);
+    m_actions.insert(id, action);
+
+    connect( action, SIGNAL(actionStarted(Action*)),
+             this, SLOT(actionStarted(Action*)) );
+    connect( action, SIGNAL(actionFinished(Action*)),
+             this, SLOT(closeAction(Action*)) );
+
+    m_activeActionDialog->actionAboutToStart(action);
+
+    const auto superseded = m_scheduler.enqueue(action, category, coalescingKey);
+    for (auto supersededAction : superseded)
+        cancelAction(supersededAction);
+
+    startQueuedActions();
+
+    if ( m_scheduler.isQueued(action) ) {
+        COPYQ_LOG( QString("Queued: %1").arg(actionDescription(*action)) );
+        m_activeActionDialog->actionQueued(action);
+    }
+}
+
+void ActionHandler::startQueuedActions()
+{
+    const auto actions = m_scheduler.takeActionsToStart();
+    m_activeActionDialog->setQueueStatistics(m_scheduler);
+
+    for (auto action : actions) {
+        COPYQ_LOG( QString("Executing: %1").arg(actionDescription(*action)) );
+        action->start();
+    }
+}
+
+void ActionHandler::cancelAction(Action *action)
+{
+    COPYQ_LOG( QString("Cancelled: %1").arg(actionDescription(*action)) );
+
+    m_actions.remove(action->id());
+    m_internalActions.remove(action->id());
+    m_activeActionDialog->actionCancelled(action);
+
+    emit runningActionsCountChanged();
+
+    action->deleteLater();
 }
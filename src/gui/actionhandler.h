@@ -21,6 +21,8 @@
 #define ACTIONHANDLER_H
 
 #include "common/command.h"
+#include "gui/actionscheduler.h"
+#include "gui/builtincommandrunner.h"
 
 #include <QDateTime>
 #include <QMenu>
@@ -31,6 +33,8 @@
 
 class Action;
 class ActionDialog;
+class ActionHistoryModel;
+class ActionStatisticsModel;
 class ProcessManagerDialog;
 class QDialog;
 class MainWindow;
@@ -55,13 +59,32 @@ public:
     QVariantMap actionData(int id) const;
     void setActionData(int id, const QVariantMap &data);
 
-    void internalAction(Action *action);
+    /** Return finished actions with used resources, newest first. */
+    QVector<QVariantMap> actionHistory() const;
+
+    /**
+     * Execute internal action.
+     *
+     * Action is queued if too many actions in given category are running.
+     * Queued actions with the same non-empty coalescing key are cancelled.
+     */
+    void internalAction(
+            Action *action,
+            ActionCategory category = ActionCategory::Internal,
+            const QString &coalescingKey = QString());
     bool isInternalActionId(int id) const;
 
 public slots:
     /** Execute action. */
     void action(Action *action);
 
+    /**
+     * Remove action from queue before it starts.
+     *
+     * Returns false if the action is not queued.
+     */
+    bool cancelQueuedAction(Action *action);
+
 signals:
     /** Emitted new action starts or ends. */
     void runningActionsCountChanged();
@@ -74,8 +97,16 @@ private slots:
     void closeAction(Action *action);
 
 private:
+    void scheduleAction(Action *action, ActionCategory category, const QString &coalescingKey);
+    void startQueuedActions();
+    void cancelAction(Action *action);
+
     MainWindow *m_wnd;
     ProcessManagerDialog *m_activeActionDialog;
+    ActionHistoryModel *m_history;
+    ActionStatisticsModel *m_statistics;
+    BuiltInCommandRunner m_builtInCommandRunner;
+    ActionScheduler m_scheduler;
     QHash<int, Action*> m_actions;
     QSet<int> m_internalActions;
     int m_lastActionId = -1;
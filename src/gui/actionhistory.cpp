@@ -0,0 +1,346 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/actionhistory.h"
+
+namespace {
+
+namespace historyColumns {
+enum {
+    name,
+    finished,
+    exitCode,
+    wallTime,
+    cpuTime,
+    peakMemory,
+    bytesIn,
+    bytesOut,
+    count
+};
+}
+
+namespace statisticsColumns {
+enum {
+    name,
+    runs,
+    failures,
+    wallTime,
+    averageWallTime,
+    cpuTime,
+    peakMemory,
+    bytesIn,
+    bytesOut,
+    count
+};
+}
+
+QVariant knownValue(qint64 value)
+{
+    return value == -1 ? QVariant() : QVariant(value);
+}
+
+QVariant numberAlignment()
+{
+    return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+}
+
+} // namespace
+
+ActionHistoryEntry createActionHistoryEntry(const Action &action)
+{
+    ActionHistoryEntry entry;
+    entry.name = action.name();
+    entry.command = action.command();
+    if ( entry.name.isEmpty() )
+        entry.name = QString(entry.command).replace('\n', " ");
+    entry.finished = QDateTime::currentDateTime();
+    entry.exitCode = action.exitCode();
+    entry.failed = action.actionFailed();
+    entry.usage = action.resourceUsage();
+    return entry;
+}
+
+ActionHistoryModel::ActionHistoryModel(int capacity, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_capacity(qMax(1, capacity))
+{
+}
+
+int ActionHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+int ActionHistoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : historyColumns::count;
+}
+
+QVariant ActionHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if ( !index.isValid() || index.row() >= m_count )
+        return QVariant();
+
+    const auto &e = entry(index.row());
+
+    if (role == Qt::ToolTipRole) {
+        if ( index.column() == historyColumns::name )
+            return e.command;
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole) {
+        if ( index.column() == historyColumns::name || index.column() == historyColumns::finished )
+            return QVariant();
+        return numberAlignment();
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch ( index.column() ) {
+    case historyColumns::name:
+        return e.name;
+    case historyColumns::finished:
+        return e.finished;
+    case historyColumns::exitCode:
+        return e.failed ? QVariant(tr("Failed")) : QVariant(e.exitCode);
+    case historyColumns::wallTime:
+        return e.usage.wallTimeMs;
+    case historyColumns::cpuTime:
+        return knownValue(e.usage.cpuTimeMs);
+    case historyColumns::peakMemory:
+        return knownValue(e.usage.peakRssKiB);
+    case historyColumns::bytesIn:
+        return e.usage.bytesIn;
+    case historyColumns::bytesOut:
+        return e.usage.bytesOut;
+    }
+
+    return QVariant();
+}
+
+QVariant ActionHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (section) {
+    case historyColumns::name:
+        return tr("Name");
+    case historyColumns::finished:
+        return tr("Finished");
+    case historyColumns::exitCode:
+        return tr("Exit Code");
+    case historyColumns::wallTime:
+        return tr("Time (ms)");
+    case historyColumns::cpuTime:
+        return tr("CPU Time (ms)");
+    case historyColumns::peakMemory:
+        return tr("Peak Memory (KiB)");
+    case historyColumns::bytesIn:
+        return tr("Input (bytes)");
+    case historyColumns::bytesOut:
+        return tr("Output (bytes)");
+    }
+
+    return QVariant();
+}
+
+void ActionHistoryModel::addEntry(const ActionHistoryEntry &entry)
+{
+    // Drop the oldest entry (last row) if full.
+    if (m_count == m_capacity) {
+        beginRemoveRows(QModelIndex(), m_count - 1, m_count - 1);
+        --m_count;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_newest = (m_newest + 1) % m_capacity;
+    if ( m_newest < m_entries.size() )
+        m_entries[m_newest] = entry;
+    else
+        m_entries.append(entry);
+    ++m_count;
+    endInsertRows();
+}
+
+const ActionHistoryEntry &ActionHistoryModel::entry(int row) const
+{
+    Q_ASSERT(row >= 0 && row < m_count);
+    const int size = m_entries.size();
+    return m_entries[(m_newest - row + size) % size];
+}
+
+QVector<QVariantMap> ActionHistoryModel::toVariantMaps() const
+{
+    QVector<QVariantMap> result;
+    result.reserve(m_count);
+
+    for (int row = 0; row < m_count; ++row) {
+        const auto &e = entry(row);
+        QVariantMap map;
+        map["name"] = e.name;
+        map["command"] = e.command;
+        map["finished"] = e.finished.toString(Qt::ISODate);
+        map["exitCode"] = e.exitCode;
+        map["failed"] = e.failed;
+        map["wallTime"] = e.usage.wallTimeMs;
+        map["cpuTime"] = e.usage.cpuTimeMs;
+        map["peakMemory"] = e.usage.peakRssKiB;
+        map["bytesIn"] = e.usage.bytesIn;
+        map["bytesOut"] = e.usage.bytesOut;
+        result.append(map);
+    }
+
+    return result;
+}
+
+ActionStatisticsModel::ActionStatisticsModel(int capacity, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_capacity(qMax(1, capacity))
+{
+}
+
+int ActionStatisticsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int ActionStatisticsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : statisticsColumns::count;
+}
+
+QVariant ActionStatisticsModel::data(const QModelIndex &index, int role) const
+{
+    if ( !index.isValid() || index.row() >= m_rows.size() )
+        return QVariant();
+
+    if (role == Qt::TextAlignmentRole) {
+        if ( index.column() == statisticsColumns::name )
+            return QVariant();
+        return numberAlignment();
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    const auto &s = m_rows[index.row()];
+
+    switch ( index.column() ) {
+    case statisticsColumns::name:
+        return s.name;
+    case statisticsColumns::runs:
+        return s.runs;
+    case statisticsColumns::failures:
+        return s.failures;
+    case statisticsColumns::wallTime:
+        return s.wallTimeMs;
+    case statisticsColumns::averageWallTime:
+        return s.wallTimeMs / qMax(1, s.runs);
+    case statisticsColumns::cpuTime:
+        return knownValue(s.cpuTimeMs);
+    case statisticsColumns::peakMemory:
+        return knownValue(s.peakRssKiB);
+    case statisticsColumns::bytesIn:
+        return s.bytesIn;
+    case statisticsColumns::bytesOut:
+        return s.bytesOut;
+    }
+
+    return QVariant();
+}
+
+QVariant ActionStatisticsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (section) {
+    case statisticsColumns::name:
+        return tr("Name");
+    case statisticsColumns::runs:
+        return tr("Runs");
+    case statisticsColumns::failures:
+        return tr("Failures");
+    case statisticsColumns::wallTime:
+        return tr("Total Time (ms)");
+    case statisticsColumns::averageWallTime:
+        return tr("Average Time (ms)");
+    case statisticsColumns::cpuTime:
+        return tr("Total CPU Time (ms)");
+    case statisticsColumns::peakMemory:
+        return tr("Peak Memory (KiB)");
+    case statisticsColumns::bytesIn:
+        return tr("Input (bytes)");
+    case statisticsColumns::bytesOut:
+        return tr("Output (bytes)");
+    }
+
+    return QVariant();
+}
+
+void ActionStatisticsModel::addEntry(const ActionHistoryEntry &entry)
+{
+    int row = m_rowForName.value(entry.name, -1);
+    if (row == -1) {
+        if (m_rows.size() == m_capacity)
+            removeLeastRecentlyUpdated();
+
+        row = m_rows.size();
+        beginInsertRows(QModelIndex(), row, row);
+        Statistics s;
+        s.name = entry.name;
+        m_rows.append(s);
+        m_rowForName.insert(entry.name, row);
+        endInsertRows();
+    }
+
+    auto &s = m_rows[row];
+    s.lastUpdate = ++m_updateCount;
+    ++s.runs;
+    if (entry.failed || entry.exitCode != 0)
+        ++s.failures;
+    s.wallTimeMs += entry.usage.wallTimeMs;
+    if (entry.usage.cpuTimeMs != -1)
+        s.cpuTimeMs = qMax<qint64>(0, s.cpuTimeMs) + entry.usage.cpuTimeMs;
+    s.peakRssKiB = qMax(s.peakRssKiB, entry.usage.peakRssKiB);
+    s.bytesIn += entry.usage.bytesIn;
+    s.bytesOut += entry.usage.bytesOut;
+
+    emit dataChanged( index(row, 0), index(row, statisticsColumns::count - 1) );
+}
+
+void ActionStatisticsModel::removeLeastRecentlyUpdated()
+{
+    int row = 0;
+    for (int i = 1; i < m_rows.size(); ++i) {
+        if (m_rows[i].lastUpdate < m_rows[row].lastUpdate)
+            row = i;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rowForName.remove(m_rows[row].name);
+    m_rows.remove(row);
+    for (int i = row; i < m_rows.size(); ++i)
+        m_rowForName[m_rows[i].name] = i;
+    endRemoveRows();
+}
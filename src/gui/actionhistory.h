@@ -0,0 +1,117 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTIONHISTORY_H
+#define ACTIONHISTORY_H
+
+#include "common/action.h"
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+
+/**
+ * Finished action with resources it used.
+ */
+struct ActionHistoryEntry {
+    QString name;
+    QString command;
+    QDateTime finished;
+    int exitCode = 0;
+    bool failed = false;
+    ActionResourceUsage usage;
+};
+
+ActionHistoryEntry createActionHistoryEntry(const Action &action);
+
+/**
+ * Finished actions, newest first.
+ *
+ * Entries are kept in ring buffer with given capacity so the oldest entry is
+ * dropped when a new one is added to full history.
+ */
+class ActionHistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ActionHistoryModel(int capacity, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void addEntry(const ActionHistoryEntry &entry);
+
+    const ActionHistoryEntry &entry(int row) const;
+
+    /** Return entries as maps for scripts, newest first. */
+    QVector<QVariantMap> toVariantMaps() const;
+
+private:
+    QVector<ActionHistoryEntry> m_entries;
+    int m_capacity;
+    int m_count = 0;
+    int m_newest = -1;
+};
+
+/**
+ * Resources used by finished actions aggregated by command name.
+ *
+ * Number of rows is limited by given capacity so the least recently updated
+ * row is dropped when a new command name is added to full model.
+ */
+class ActionStatisticsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit ActionStatisticsModel(int capacity, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void addEntry(const ActionHistoryEntry &entry);
+
+private:
+    struct Statistics {
+        QString name;
+        int runs = 0;
+        int failures = 0;
+        qint64 wallTimeMs = 0;
+        qint64 cpuTimeMs = -1;
+        qint64 peakRssKiB = -1;
+        qint64 bytesIn = 0;
+        qint64 bytesOut = 0;
+        quint64 lastUpdate = 0;
+    };
+
+    void removeLeastRecentlyUpdated();
+
+    QVector<Statistics> m_rows;
+    QHash<QString, int> m_rowForName;
+    int m_capacity;
+    quint64 m_updateCount = 0;
+};
+
+#endif // ACTIONHISTORY_H
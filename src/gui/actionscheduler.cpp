@@ -0,0 +1,150 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "actionscheduler.h"
+
+#include <QtGlobal>
+
+namespace {
+
+struct CategoryPolicy {
+    /// Higher priority actions are started first.
+    int priority;
+    /// Maximum running actions in category (0 means no limit).
+    int maxRunning;
+};
+
+CategoryPolicy categoryPolicy(ActionCategory category)
+{
+    switch (category) {
+    case ActionCategory::Interactive:
+        return {3, 0};
+    case ActionCategory::Internal:
+        return {2, 0};
+    case ActionCategory::Display:
+        return {1, 1};
+    case ActionCategory::MenuFilter:
+        return {0, 2};
+    }
+
+    Q_ASSERT(false && "Unknown action category!");
+    return {0, 0};
+}
+
+} // namespace
+
+QList<Action*> ActionScheduler::enqueue(Action *action, ActionCategory category, const QString &coalescingKey)
+{
+    QList<Action*> superseded;
+
+    if ( !coalescingKey.isEmpty() ) {
+        for (int i = m_queue.size() - 1; i >= 0; --i) {
+            const auto &queued = m_queue[i];
+            if (queued.category == category && queued.coalescingKey == coalescingKey) {
+                superseded.append(queued.action);
+                m_queue.removeAt(i);
+            }
+        }
+    }
+
+    // Keep queue sorted by priority; FIFO in same priority.
+    const int priority = categoryPolicy(category).priority;
+    int i = m_queue.size();
+    while ( i > 0 && categoryPolicy(m_queue[i - 1].category).priority < priority )
+        --i;
+    m_queue.insert( i, QueuedAction{action, category, coalescingKey} );
+
+    auto &stats = statisticsRef(category);
+    stats.coalesced += superseded.size();
+    stats.queued -= superseded.size();
+    ++stats.queued;
+    stats.peakQueued = qMax(stats.peakQueued, stats.queued);
+
+    return superseded;
+}
+
+QList<Action*> ActionScheduler::takeActionsToStart()
+{
+    QList<Action*> actions;
+
+    for (int i = 0; i < m_queue.size(); ) {
+        const auto queued = m_queue[i];
+        if ( !canStart(queued.category) ) {
+            ++i;
+            continue;
+        }
+
+        m_queue.removeAt(i);
+        m_running.insert(queued.action, queued.category);
+
+        auto &stats = statisticsRef(queued.category);
+        --stats.queued;
+        ++stats.running;
+        ++stats.started;
+
+        actions.append(queued.action);
+    }
+
+    return actions;
+}
+
+void ActionScheduler::remove(Action *action)
+{
+    const auto it = m_running.find(action);
+    if ( it != m_running.end() ) {
+        const auto category = it.value();
+        m_running.erase(it);
+        --statisticsRef(category).running;
+        return;
+    }
+
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue[i].action == action) {
+            --statisticsRef(m_queue[i].category).queued;
+            m_queue.removeAt(i);
+            return;
+        }
+    }
+}
+
+bool ActionScheduler::isQueued(const Action *action) const
+{
+    for (const auto &queued : m_queue) {
+        if (queued.action == action)
+            return true;
+    }
+
+    return false;
+}
+
+const ActionQueueStatistics &ActionScheduler::statistics(ActionCategory category) const
+{
+    return m_statistics[static_cast<int>(category)];
+}
+
+bool ActionScheduler::canStart(ActionCategory category) const
+{
+    const auto policy = categoryPolicy(category);
+    return policy.maxRunning == 0 || statistics(category).running < policy.maxRunning;
+}
+
+ActionQueueStatistics &ActionScheduler::statisticsRef(ActionCategory category)
+{
+    return m_statistics[static_cast<int>(category)];
+}
@@ -0,0 +1,95 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTIONSCHEDULER_H
+#define ACTIONSCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class Action;
+
+enum class ActionCategory {
+    /// Commands started by user (menu items, shortcuts, action dialog).
+    Interactive,
+    /// Internal actions which always start immediately (e.g. clipboard monitor or providers).
+    Internal,
+    /// Display commands.
+    Display,
+    /// Menu filters (enabling or disabling menu items).
+    MenuFilter,
+};
+
+const int actionCategoryCount = static_cast<int>(ActionCategory::MenuFilter) + 1;
+
+struct ActionQueueStatistics {
+    int running = 0;
+    int queued = 0;
+    int peakQueued = 0;
+    int started = 0;
+    int coalesced = 0;
+};
+
+/**
+ * Decides when to start actions.
+ *
+ * Limits number of concurrently running background actions per category,
+ * prefers interactive actions over background ones and drops queued actions
+ * superseded by newer ones with the same coalescing key.
+ *
+ * Interactive and internal actions are never limited.
+ */
+class ActionScheduler
+{
+public:
+    /**
+     * Add action to queue.
+     *
+     * Returns queued actions with the same category and non-empty coalescing
+     * key which were removed from queue and should be cancelled.
+     */
+    QList<Action*> enqueue(Action *action, ActionCategory category, const QString &coalescingKey);
+
+    /// Returns actions that can be started now and marks them as running.
+    QList<Action*> takeActionsToStart();
+
+    /// Removes queued or running action (when finished or cancelled).
+    void remove(Action *action);
+
+    bool isQueued(const Action *action) const;
+
+    const ActionQueueStatistics &statistics(ActionCategory category) const;
+
+private:
+    struct QueuedAction {
+        Action *action;
+        ActionCategory category;
+        QString coalescingKey;
+    };
+
+    bool canStart(ActionCategory category) const;
+    ActionQueueStatistics &statisticsRef(ActionCategory category);
+
+    QList<QueuedAction> m_queue;
+    QHash<const Action*, ActionCategory> m_running;
+    ActionQueueStatistics m_statistics[actionCategoryCount];
+};
+
+#endif // ACTIONSCHEDULER_H
@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "builtincommandrunner.h"
+
+#include "common/builtincommand.h"
+#include "common/commandstatus.h"
+#include "common/mimetypes.h"
+#include "common/textdata.h"
+#include "gui/mainwindow.h"
+#include "scriptable/scriptableproxy.h"
+
+namespace {
+
+QString argumentText(const QString &arg, const QByteArray &input)
+{
+    return arg == "-" ? getTextData(input) : arg;
+}
+
+QByteArray readItems(ScriptableProxy *proxy, const QStringList &arguments)
+{
+    QByteArray result;
+    QString mime(mimeText);
+    bool used = false;
+
+    for (const auto &arg : arguments) {
+        bool isRow;
+        const int row = arg.toInt(&isRow);
+        if (isRow) {
+            if (used)
+                result.append('\n');
+            used = true;
+            result.append( row >= 0 ? proxy->browserItemData(row, mime)
+                                    : proxy->getClipboardData(mime) );
+        } else {
+            mime = arg;
+        }
+    }
+
+    if (!used)
+        result.append( proxy->getClipboardData(mime) );
+
+    return result;
+}
+
+QString insertItems(ScriptableProxy *proxy, int row, const QStringList &arguments, const QByteArray &input)
+{
+    QVector<QVariantMap> items;
+    items.reserve( arguments.size() );
+    for (const auto &arg : arguments)
+        items.append( createDataMap(mimeText, argumentText(arg, input)) );
+
+    return proxy->browserInsert(row, items);
+}
+
+QString removeItems(ScriptableProxy *proxy, const QStringList &arguments)
+{
+    QVector<int> rows;
+    for (const auto &arg : arguments) {
+        bool ok;
+        const int row = arg.toInt(&ok);
+        if (!ok)
+            return "Invalid number of arguments!";
+        rows.append(row);
+    }
+
+    if ( rows.isEmpty() )
+        rows.append(0);
+
+    return proxy->browserRemoveRows(rows);
+}
+
+} // namespace
+
+BuiltInCommandRunner::BuiltInCommandRunner(MainWindow *mainWindow)
+    : m_wnd(mainWindow)
+{
+}
+
+bool BuiltInCommandRunner::canRunInternally(const QStringList &args) const
+{
+    // Functions can be overridden in script commands.
+    if ( !m_wnd->scriptCommands().isEmpty() )
+        return false;
+
+    return isBuiltInCommand(args);
+}
+
+int BuiltInCommandRunner::runInternally(
+        const QStringList &args, int actionId, const QByteArray &input,
+        QByteArray *output, QString *errorOutput)
+{
+    BuiltInCommand command;
+    if ( !parseBuiltInCommand(args, &command) ) {
+        *errorOutput = "Bad command syntax";
+        return CommandBadSyntax;
+    }
+
+    ScriptableProxy proxy(m_wnd, nullptr);
+    if (actionId != -1)
+        proxy.getActionData(actionId);
+    if ( !command.tabName.isEmpty() )
+        proxy.setTab(command.tabName);
+
+    const auto &name = command.name;
+    const auto &arguments = command.arguments;
+    QString error;
+
+    if (name == "read") {
+        *output = readItems(&proxy, arguments);
+    } else if (name == "add") {
+        error = insertItems(&proxy, 0, arguments, input);
+    } else if (name == "insert") {
+        bool ok;
+        const int row = arguments.value(0).toInt(&ok);
+        error = ok ? insertItems(&proxy, row, arguments.mid(1), input)
+                   : QString("Invalid number of arguments!");
+    } else if (name == "remove") {
+        error = removeItems(&proxy, arguments);
+    } else if (name == "tab") {
+        const auto tabs = proxy.tabs();
+        for (const auto &tab : tabs)
+            output->append( tab.toUtf8() + '\n' );
+    } else {
+        *output = QByteArray::number( proxy.browserLength() ) + '\n';
+    }
+
+    if ( !error.isEmpty() ) {
+        *errorOutput = "ScriptError: " + error + "\n";
+        return CommandException;
+    }
+
+    return CommandFinished;
+}
@@ -0,0 +1,52 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BUILTINCOMMANDRUNNER_H
+#define BUILTINCOMMANDRUNNER_H
+
+#include "common/action.h"
+
+class MainWindow;
+
+/**
+ * Runs simple "copyq" commands from command pipelines directly in server.
+ *
+ * Avoids starting new client process (which needs to connect to server)
+ * for commands like "copyq read 0" or "copyq add -".
+ *
+ * Scripts ("copyq eval", "copyq: ...") and any other commands still run
+ * in separate process.
+ */
+class BuiltInCommandRunner : public InternalCommandRunner
+{
+public:
+    explicit BuiltInCommandRunner(MainWindow *mainWindow);
+
+    bool canRunInternally(const QStringList &args) const override;
+
+    int runInternally(
+            const QStringList &args, int actionId, const QByteArray &input,
+            QByteArray *output, QString *errorOutput) override;
+
+private:
+    MainWindow *m_wnd;
+};
+
+#endif // BUILTINCOMMANDRUNNER_H
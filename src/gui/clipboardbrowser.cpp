@@ -27,7 +27,9 @@
 #include "gui/clipboarddialog.h"
 #include "gui/iconfactory.h"
 #include "gui/icons.h"
+#include "gui/savescheduler.h"
 #include "gui/theme.h"
+#include "item/blobstore.h"
 #include "item/itemeditor.h"
 #include "item/itemeditorwidget.h"
 #include "item/itemfactory.h"
@@ -57,6 +59,12 @@
 
 namespace {
 
+/// Delay for saving items after a change.
+const int saveDelayMs = 30000;
+
+/// Delay for saving items after user edits an item (merges multiple edits in a row).
+const int quickSaveDelayMs = 1000;
+
 enum class MoveType {
     Absolute,
     Relative
@@ -271,7 +279,6 @@ ClipboardBrowser::ClipboardBrowser(
     setEditTriggers(QAbstractItemView::NoEditTriggers);
     setAlternatingRowColors(true);
 
-    initSingleShotTimer( &m_timerSave, 30000, this, SLOT(saveItems()) );
     initSingleShotTimer( &m_timerEmitItemCount, 0, this, SLOT(emitItemCount()) );
     initSingleShotTimer( &m_timerUpdateSizes, 0, this, SLOT(updateSizes()) );
     initSingleShotTimer( &m_timerUpdateItemWidgets, 0, this, SLOT(updateItemWidgets()) );
@@ -370,6 +377,14 @@ QVariantMap ClipboardBrowser::itemData(const QModelIndex &index) const
     return index.data(contentType::data).toMap();
 }
 
+QVariant ClipboardBrowser::queryTab(const QString &loaderId, const QString &query, const QVariantList &arguments) const
+{
+    if (!m_sharedData->itemFactory)
+        return QVariant();
+
+    return m_sharedData->itemFactory->queryTab(loaderId, m, query, arguments);
+}
+
 bool ClipboardBrowser::hideFiltered(int row)
 {
     const bool hide = isFiltered(row);
@@ -553,6 +568,16 @@ void ClipboardBrowser::connectModelAndDelegate()
     connect( &m, SIGNAL(rowsRemoved(QModelIndex,int,int)),
              SLOT(onItemCountChanged()) );
 
+    // Memory usage
+    connect( &m, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             SLOT(addItemsMemoryUsage(QModelIndex,int,int)) );
+    connect( &m, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+             SLOT(removeItemsMemoryUsage(QModelIndex,int,int)) );
+    connect( &m, SIGNAL(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)),
+             SLOT(moveItemsMemoryUsage(QModelIndex,int,int,QModelIndex,int)) );
+    connect( &m, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             SLOT(updateItemsMemoryUsage(QModelIndex,QModelIndex)) );
+
     // Save on change
     connect( &m, SIGNAL(rowsInserted(QModelIndex,int,int)),
              SLOT(delayedSaveItems()) );
@@ -772,7 +797,7 @@ void ClipboardBrowser::paste(const QVariantMap &data, int destinationRow)
         add(data, destinationRow);
     }
 
-    saveItems();
+    saveItemsSoon();
 }
 
 QPixmap ClipboardBrowser::renderItemPreview(const QModelIndexList &indexes, int maxWidth, int maxHeight)
@@ -865,12 +890,107 @@ void ClipboardBrowser::onItemCountChanged()
         m_timerEmitItemCount.start();
 }
 
+void ClipboardBrowser::addItemsMemoryUsage(const QModelIndex &, int first, int last)
+{
+    std::vector<ItemMemoryUsage> usage;
+    usage.reserve( static_cast<size_t>(last - first + 1) );
+    for (int row = first; row <= last; ++row)
+        usage.push_back( acquireItemMemoryUsage(row) );
+
+    m_itemsMemoryUsage.insert(
+                std::begin(m_itemsMemoryUsage) + first, std::begin(usage), std::end(usage) );
+}
+
+void ClipboardBrowser::removeItemsMemoryUsage(const QModelIndex &, int first, int last)
+{
+    const auto start = std::begin(m_itemsMemoryUsage) + first;
+    const auto end = std::begin(m_itemsMemoryUsage) + last + 1;
+    for (auto it = start; it != end; ++it)
+        releaseItemMemoryUsage(*it);
+
+    m_itemsMemoryUsage.erase(start, end);
+}
+
+void ClipboardBrowser::moveItemsMemoryUsage(
+        const QModelIndex &, int sourceStart, int sourceEnd,
+        const QModelIndex &, int destinationRow)
+{
+    auto count = sourceEnd - sourceStart + 1;
+    auto from = sourceStart;
+    auto to = destinationRow;
+
+    if (to < from) {
+        std::swap(from, to);
+        to += count;
+        count = to - from - count;
+    }
+
+    const auto start1 = std::begin(m_itemsMemoryUsage) + from;
+    const auto start2 = start1 + count;
+    const auto end2 = std::begin(m_itemsMemoryUsage) + to;
+    std::rotate(start1, start2, end2);
+}
+
+void ClipboardBrowser::updateItemsMemoryUsage(const QModelIndex &a, const QModelIndex &b)
+{
+    for (int row = a.row(); row <= b.row(); ++row) {
+        auto &usage = m_itemsMemoryUsage[static_cast<size_t>(row)];
+        // Acquire new data first so the unchanged shared data are not released.
+        const ItemMemoryUsage oldUsage = usage;
+        usage = acquireItemMemoryUsage(row);
+        releaseItemMemoryUsage(oldUsage);
+    }
+}
+
+ClipboardBrowser::ItemMemoryUsage ClipboardBrowser::acquireItemMemoryUsage(int row)
+{
+    ItemMemoryUsage usage;
+
+    const QVariantMap data = m.data(m.index(row), contentType::data).toMap();
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        usage.size += 2 * it.key().size();
+
+        if ( it.value().type() != QVariant::ByteArray ) {
+            usage.size += it.value().toByteArray().size();
+            continue;
+        }
+
+        // Data can be shared with other items (see BlobStore).
+        // Size is part of the key since the data of changed item could be
+        // already freed and the same address used for new data.
+        const QByteArray bytes = it.value().toByteArray();
+        const auto key = qMakePair(bytes.constData(), bytes.size());
+        int &references = m_sharedDataReferences[key];
+        if (references == 0)
+            m_itemsDataSize += bytes.size();
+        ++references;
+        usage.sharedData.append(key);
+    }
+
+    m_itemsDataSize += usage.size;
+    return usage;
+}
+
+void ClipboardBrowser::releaseItemMemoryUsage(const ItemMemoryUsage &usage)
+{
+    m_itemsDataSize -= usage.size;
+
+    for (const auto &key : usage.sharedData) {
+        const auto it = m_sharedDataReferences.find(key);
+        Q_ASSERT( it != m_sharedDataReferences.end() );
+        if ( --it.value() == 0 ) {
+            m_itemsDataSize -= key.second;
+            m_sharedDataReferences.erase(it);
+        }
+    }
+}
+
 void ClipboardBrowser::onEditorSave()
 {
     Q_ASSERT(!m_editor.isNull());
     m_editor->commitData(&m);
     focusEditedIndex();
-    saveItems();
+    saveItemsSoon();
 }
 
 void ClipboardBrowser::onEditorCancel()
@@ -1104,6 +1224,7 @@ void ClipboardBrowser::mouseMoveEvent(QMouseEvent *event)
     }
 
     QVariantMap data = copyIndexes(selected);
+    BlobStore::instance()->loadDataFiles(&data);
 
     auto drag = new QDrag(this);
     drag->setMimeData( createMimeData(data) );
@@ -1260,7 +1381,7 @@ void ClipboardBrowser::itemModified(const QByteArray &bytes, const QString &mime
             m.setData(index, dataMap, contentType::updateData);
         else
             add(dataMap);
-        saveItems();
+        saveItemsSoon();
     }
 }
 
@@ -1561,8 +1682,10 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
     }
 
     // create new item
+    QVariantMap newData = data;
+    BlobStore::instance()->storeDataFiles(&newData);
     const int newRow = row < 0 ? m.rowCount() : qMin(row, m.rowCount());
-    m.insertItem(data, newRow);
+    m.insertItem(newData, newRow);
 
     delayedSaveItems();
 
@@ -1572,6 +1695,7 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
 void ClipboardBrowser::addUnique(const QVariantMap &data)
 {
     auto newData = data;
+    BlobStore::instance()->storeDataFiles(&newData);
 
     if ( moveToTop(hash(newData)) ) {
         COPYQ_LOG("New item: Moving existing to top");
@@ -1623,7 +1747,8 @@ bool ClipboardBrowser::loadItems()
     if ( isLoaded() )
         return true;
 
-    m_timerSave.stop();
+    if (m_sharedData->saveScheduler)
+        m_sharedData->saveScheduler->cancelSave(this);
 
     m.blockSignals(true);
     m_itemSaver = ::loadItems(m_tabName, m, m_sharedData->itemFactory, m_sharedData->maxItems);
@@ -1642,7 +1767,8 @@ bool ClipboardBrowser::loadItems()
 
 bool ClipboardBrowser::saveItems()
 {
-    m_timerSave.stop();
+    if (m_sharedData->saveScheduler)
+        m_sharedData->saveScheduler->cancelSave(this);
 
     if ( !isLoaded() || m_tabName.isEmpty() )
         return false;
@@ -1657,15 +1783,22 @@ void ClipboardBrowser::moveToClipboard()
 
 void ClipboardBrowser::delayedSaveItems()
 {
-    if ( !isLoaded() || tabName().isEmpty() )
+    if ( !isLoaded() || tabName().isEmpty() || !m_sharedData->saveScheduler )
         return;
 
-    if ( !m_timerSave.isActive() )
-        m_timerSave.start();
+    m_sharedData->saveScheduler->scheduleSave(this, saveDelayMs);
 
     emit itemsChanged(this);
 }
 
+void ClipboardBrowser::saveItemsSoon()
+{
+    if ( !isLoaded() || tabName().isEmpty() || !m_sharedData->saveScheduler )
+        return;
+
+    m_sharedData->saveScheduler->scheduleSave(this, quickSaveDelayMs);
+}
+
 void ClipboardBrowser::updateSizes()
 {
     updateItemMaximumSize();
@@ -1704,17 +1837,32 @@ void ClipboardBrowser::updateCurrent()
 
 void ClipboardBrowser::saveUnsavedItems()
 {
-    if ( m_timerSave.isActive() )
+    if ( hasUnsavedItems() )
         saveItems();
 }
 
+bool ClipboardBrowser::hasUnsavedItems() const
+{
+    return m_sharedData->saveScheduler
+            && m_sharedData->saveScheduler->isSaveScheduled(this);
+}
+
+qint64 ClipboardBrowser::memoryUsage() const
+{
+    // Rough estimate of memory used by single item widget.
+    const qint64 itemWidgetSize = 16 * 1024;
+
+    return d.cachedItemCount() * itemWidgetSize + m_itemsDataSize;
+}
+
 void ClipboardBrowser::purgeItems()
 {
     if ( tabName().isEmpty() )
         return;
 
     removeItems(tabName());
-    m_timerSave.stop();
+    if (m_sharedData->saveScheduler)
+        m_sharedData->saveScheduler->cancelSave(this);
 }
 
 const QString ClipboardBrowser::selectedText() const
@@ -28,13 +28,16 @@
 #include "item/itemdelegate.h"
 #include "item/itemwidget.h"
 
+#include <QHash>
 #include <QListView>
+#include <QPair>
 #include <QPointer>
 #include <QTimer>
 #include <QVariantMap>
 #include <QVector>
 
 #include <memory>
+#include <vector>
 
 class ItemEditorWidget;
 class ItemFactory;
@@ -207,6 +210,17 @@ class ClipboardBrowser : public QListView
          */
         void saveUnsavedItems();
 
+        /** Return true only if items changed and were not saved yet. */
+        bool hasUnsavedItems() const;
+
+        /**
+         * Return approximate memory used by items (in bytes).
+         *
+         * This includes size of item data (data shared by items are counted once)
+         * and estimated size of cached item widgets.
+         */
+        qint64 memoryUsage() const;
+
         /**
          * Clear all items from configuration.
          * @see setID, loadItems, saveItems
@@ -250,6 +264,9 @@ class ClipboardBrowser : public QListView
 
         QVariantMap itemData(const QModelIndex &index) const;
 
+        /** Pass query about items to plugin (see ItemLoaderInterface::queryTab()). */
+        QVariant queryTab(const QString &loaderId, const QString &query, const QVariantList &arguments) const;
+
     public slots:
         /**
          * Save items to configuration.
@@ -341,6 +358,12 @@ class ClipboardBrowser : public QListView
 
         void onItemCountChanged();
 
+        void addItemsMemoryUsage(const QModelIndex &parent, int first, int last);
+        void removeItemsMemoryUsage(const QModelIndex &parent, int first, int last);
+        void moveItemsMemoryUsage(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                                  const QModelIndex &destinationParent, int destinationRow);
+        void updateItemsMemoryUsage(const QModelIndex &a, const QModelIndex &b);
+
         void onEditorSave();
 
         void onEditorCancel();
@@ -356,6 +379,11 @@ class ClipboardBrowser : public QListView
          */
         void delayedSaveItems();
 
+        /**
+         * Save items to configuration after a short interval.
+         */
+        void saveItemsSoon();
+
         /**
          * Update item and editor sizes.
          */
@@ -422,11 +450,19 @@ class ClipboardBrowser : public QListView
 
         QModelIndex firstUnpinnedIndex() const;
 
+        /// Memory used by item data, data shared with other items are counted once.
+        struct ItemMemoryUsage {
+            qint64 size = 0;
+            QVector<QPair<const char *, int>> sharedData;
+        };
+
+        ItemMemoryUsage acquireItemMemoryUsage(int row);
+        void releaseItemMemoryUsage(const ItemMemoryUsage &usage);
+
         ItemSaverPtr m_itemSaver;
         QString m_tabName;
         ClipboardModel m;
         ItemDelegate d;
-        QTimer m_timerSave;
         QTimer m_timerEmitItemCount;
         QTimer m_timerUpdateSizes;
         QTimer m_timerUpdateItemWidgets;
@@ -444,6 +480,10 @@ class ClipboardBrowser : public QListView
         int m_filterRow = -1;
 
         QVector<QPersistentModelIndex> m_itemWidgetsToUpdate;
+
+        std::vector<ItemMemoryUsage> m_itemsMemoryUsage;
+        QHash<QPair<const char *, int>, int> m_sharedDataReferences;
+        qint64 m_itemsDataSize = 0;
 };
 
 #endif // CLIPBOARDBROWSER_H
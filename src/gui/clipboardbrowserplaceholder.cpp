@@ -67,10 +67,16 @@ ClipboardBrowser *ClipboardBrowserPlaceholder::createBrowser()
                  &m_timerExpire, SLOT(start()) );
     }
 
+    connect( c.get(), SIGNAL(selectionChanged(const ClipboardBrowser*)),
+             this, SLOT(onBrowserUsed()) );
+    connect( c.get(), SIGNAL(itemsChanged(const ClipboardBrowser*)),
+             this, SLOT(onBrowserUsed()) );
+
     m_browser = c.release();
     setActiveWidget(m_browser);
 
     restartExpiring();
+    onBrowserUsed();
 
     return m_browser;
 }
@@ -99,6 +105,15 @@ void ClipboardBrowserPlaceholder::removeItems()
     ::removeItems(m_tabName);
 }
 
+bool ClipboardBrowserPlaceholder::unloadUnmodifiedBrowser()
+{
+    if ( !canExpire() || m_browser->hasUnsavedItems() )
+        return false;
+
+    unloadBrowser();
+    return true;
+}
+
 void ClipboardBrowserPlaceholder::createBrowserAgain()
 {
     delete m_loadButton;
@@ -120,7 +135,10 @@ void ClipboardBrowserPlaceholder::reloadBrowser()
 
 void ClipboardBrowserPlaceholder::showEvent(QShowEvent *event)
 {
-    createBrowser();
+    if (m_browser)
+        onBrowserUsed();
+    else
+        createBrowser();
     QWidget::showEvent(event);
 }
 
@@ -138,6 +156,11 @@ void ClipboardBrowserPlaceholder::expire()
         restartExpiring();
 }
 
+void ClipboardBrowserPlaceholder::onBrowserUsed()
+{
+    emit browserUsed(this);
+}
+
 void ClipboardBrowserPlaceholder::setActiveWidget(QWidget *widget)
 {
     layout()->addWidget(widget);
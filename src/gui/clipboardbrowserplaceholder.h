@@ -54,9 +54,19 @@ public:
 
     void removeItems();
 
+    /**
+     * Unload browser if it's hidden, not edited and all items are saved.
+     *
+     * Returns true if browser was unloaded.
+     */
+    bool unloadUnmodifiedBrowser();
+
 signals:
     void browserCreated(ClipboardBrowser *browser);
 
+    /// Emitted when browser is shown or its items or selection changes.
+    void browserUsed(ClipboardBrowserPlaceholder *placeholder);
+
 public slots:
     /// Create browser if it doesn't exist and even if it previously failed.
     void createBrowserAgain();
@@ -70,6 +80,7 @@ protected:
 
 private slots:
     void expire();
+    void onBrowserUsed();
 
 private:
     void setActiveWidget(QWidget *widget);
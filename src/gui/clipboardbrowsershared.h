@@ -26,6 +26,7 @@
 #include <memory>
 
 class ItemFactory;
+class SaveScheduler;
 
 struct ClipboardBrowserShared {
     QString editor;
@@ -36,7 +37,10 @@ struct ClipboardBrowserShared {
     bool moveItemOnReturnKey = false;
     bool showSimpleItems = false;
     int minutesToExpire = 0;
+    /// Edit bigger text items in pages (in bytes).
+    int pagedEditorThreshold = 4 * 1024 * 1024;
     ItemFactory *itemFactory = nullptr;
+    SaveScheduler *saveScheduler = nullptr;
     Theme theme;
 };
 
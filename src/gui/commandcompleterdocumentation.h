@@ -64,6 +64,9 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("config", "String config(optionName, value, ...)", "Sets multiple options and return list with values in format `optionName=newValue`.");
     addDocumentation("toggleConfig", "bool toggleConfig(optionName)", "Toggles an option (true to false and vice versa) and returns the new value.");
     addDocumentation("info", "String info([pathName])", "Returns paths and flags used by the application.");
+    addDocumentation("actionHistory", "Object[] actionHistory()", "Returns recently finished commands with resources they used, newest first.");
+    addDocumentation("tabMemoryUsage", "Object[] tabMemoryUsage()", "Returns approximate memory used by tabs, most recently used first.");
+    addDocumentation("saveTabs", "saveTabs()", "Saves all unsaved changes in tabs and waits until they are written to disk.");
     addDocumentation("eval", "Value eval(script)", "Evaluates script and returns result.");
     addDocumentation("source", "Value source(fileName)", "Evaluates script file and returns result of last expression in the script.");
     addDocumentation("currentPath", "String currentPath([path])", "Get or set current path.");
@@ -251,6 +251,11 @@ void ConfigurationManager::initOptions()
 
     /* other options */
     bind<Config::command_history_size>();
+    bind<Config::defer_startup>();
+    bind<Config::paged_editor_threshold>();
+    bind<Config::clipboard_data_limits>();
+    bind<Config::tabs_memory_limit>();
+    bind<Config::in_server_script_timeout>();
 #ifdef HAS_MOUSE_SELECTIONS
     /* X11 clipboard selection monitoring and synchronization */
     bind<Config::check_selection>(ui->checkBoxSel);
@@ -34,6 +34,7 @@
 #include <QPaintDevice>
 #include <QPaintEngine>
 #include <QPixmap>
+#include <QPixmapCache>
 #include <QPointer>
 #include <QVariant>
 #include <QWidget>
@@ -59,6 +60,9 @@ const int lightThreshold = 100;
 
 QPointer<QObject> activePaintDevice;
 
+/// Prefix for rendered icons stored in the process-wide QPixmapCache.
+const char iconCacheKeyPrefix[] = "CopyQ_icon:";
+
 void replaceColor(QPixmap *pix, const QColor &from, const QColor &to)
 {
     if (from == to)
@@ -214,37 +218,24 @@ public:
 
     QPixmap createPixmap(QSize size, QIcon::Mode mode, QIcon::State state, QPainter *painter = nullptr)
     {
-        if ( useSystemIcons || m_iconId == 0 || !loadIconFont() ) {
-            // Tint tab icons.
-            if ( m_iconName.startsWith(imagesRecourcePath + QString("tab_")) ) {
-                QPixmap pixmap(m_iconName);
-                pixmap = pixmap.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-                QPainter painter2(&pixmap);
-                painter2.setCompositionMode(QPainter::CompositionMode_SourceIn);
-                painter2.fillRect( pixmap.rect(), color(painter, mode) );
-                return taggedIcon(&pixmap);
-            }
-
-            QIcon icon = m_iconName.startsWith(':') ? QIcon(m_iconName) : QIcon::fromTheme(m_iconName);
-            if ( !icon.isNull() ) {
-                auto pixmap = icon.pixmap(size, mode, state);
-                return taggedIcon(&pixmap);
-            }
-        }
+        const QColor color = this->color(painter, mode);
 
 #if QT_VERSION >= 0x050000
-        if (painter)
-            size *= painter->paintEngine()->paintDevice()->devicePixelRatio();
+        const qreal ratio = painter ? painter->paintEngine()->paintDevice()->devicePixelRatio() : 1;
+#else
+        const qreal ratio = 1;
 #endif
-        QPixmap pixmap(size);
-        pixmap.fill(Qt::transparent);
-
-        if (m_iconId == 0)
-            return taggedIcon(&pixmap);
 
-        drawFontIcon( &pixmap, m_iconId, size.width(), size.height(), color(painter, mode) );
+        // Same icons are requested repeatedly for tabs, menus and items,
+        // so share rendered pixmaps between all icon engine instances.
+        const QString key = cacheKey(size, mode, state, color, ratio);
+        QPixmap pixmap;
+        if ( QPixmapCache::find(key, &pixmap) )
+            return pixmap;
 
-        return taggedIcon(&pixmap);
+        pixmap = renderPixmap(size, mode, state, color, ratio);
+        QPixmapCache::insert(key, pixmap);
+        return pixmap;
     }
 
     // QIconEngine doesn't seem to work in menus on OS X.
@@ -328,6 +319,53 @@ private:
     {
     }
 
+    QString cacheKey(QSize size, QIcon::Mode mode, QIcon::State state, const QColor &color, qreal ratio) const
+    {
+        return QString(iconCacheKeyPrefix)
+                + QString::number(useSystemIcons) + ':'
+                + QString::number(m_iconId) + ':'
+                + QString::number(size.width()) + 'x' + QString::number(size.height()) + ':'
+                + QString::number(mode) + ':'
+                + QString::number(state) + ':'
+                + QString::number(ratio) + ':'
+                + QString::number(color.rgba(), 16) + ':'
+                + QString::number(m_tagColor.rgba(), 16) + ':'
+                + m_iconName + ':'
+                + m_tag;
+    }
+
+    QPixmap renderPixmap(QSize size, QIcon::Mode mode, QIcon::State state, const QColor &color, qreal ratio)
+    {
+        if ( useSystemIcons || m_iconId == 0 || !loadIconFont() ) {
+            // Tint tab icons.
+            if ( m_iconName.startsWith(imagesRecourcePath + QString("tab_")) ) {
+                QPixmap pixmap(m_iconName);
+                pixmap = pixmap.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                QPainter painter2(&pixmap);
+                painter2.setCompositionMode(QPainter::CompositionMode_SourceIn);
+                painter2.fillRect( pixmap.rect(), color );
+                return taggedIcon(&pixmap);
+            }
+
+            QIcon icon = m_iconName.startsWith(':') ? QIcon(m_iconName) : QIcon::fromTheme(m_iconName);
+            if ( !icon.isNull() ) {
+                auto pixmap = icon.pixmap(size, mode, state);
+                return taggedIcon(&pixmap);
+            }
+        }
+
+        size *= ratio;
+        QPixmap pixmap(size);
+        pixmap.fill(Qt::transparent);
+
+        if (m_iconId == 0)
+            return taggedIcon(&pixmap);
+
+        drawFontIcon( &pixmap, m_iconId, size.width(), size.height(), color );
+
+        return taggedIcon(&pixmap);
+    }
+
     QColor color(QPainter *painter, QIcon::Mode mode)
     {
         auto parent = painter
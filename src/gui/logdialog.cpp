@@ -16,25 +16,46 @@
     You should have received a copy of the GNU General Public License
     along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
 */
+
+
 #include "gui/logdialog.h"
 #include "ui_logdialog.h"
 
 #include "common/common.h"
 #include "common/log.h"
 
+#include <QAbstractListModel>
+#include <QApplication>
 #include <QCheckBox>
-#include <QElapsedTimer>
+#include <QClipboard>
+#include <QHash>
+#include <QLineEdit>
+#include <QPainter>
 #include <QRegExp>
-#include <QTextBlock>
+#include <QScrollBar>
+#include <QShortcut>
+#include <QStyledItemDelegate>
 #include <QTextCharFormat>
-#include <QTextBlockFormat>
-#include <QTextCursor>
-#include <QTimer>
+#include <QTextLayout>
+#include <QVector>
+
+#include <algorithm>
 
 namespace {
 
-const int maxDisplayLogSize = 128 * 1024;
-const auto logLinePrefix = "CopyQ ";
+/// Maximum size of log read when dialog opens.
+const qint64 maxInitialLogSize = 8 * 1024 * 1024;
+/// Reload log from the end if it grows over this size while dialog is open.
+const qint64 maxLogDataSize = 2 * maxInitialLogSize;
+
+const int updateLogIntervalMs = 500;
+
+const char logLinePrefix[] = "CopyQ ";
+const int logLinePrefixSize = sizeof(logLinePrefix) - 1;
+
+const int logLevelRole = Qt::UserRole;
+
+const LogLevel filteredLogLevels[] = {LogError, LogWarning, LogNote, LogDebug, LogTrace};
 
 void addFilterCheckBox(QLayout *layout, LogLevel level, const char *slot)
 {
@@ -46,83 +67,257 @@ void addFilterCheckBox(QLayout *layout, LogLevel level, const char *slot)
     layout->addWidget(checkBox);
 }
 
-void showLogLines(QString *content, bool show, LogLevel level)
-{
-    if (show)
-        return;
-
-    const QString label = logLinePrefix + logLevelLabel(level);
-
-    const QRegExp re("\n" + label + "[^\n]*");
-    content->remove(re);
-
-    const QRegExp re2("^" + label + "[^\n]*\n");
-    content->remove(re2);
-}
+struct LogLine {
+    /// Offset of the line in log data.
+    int offset;
+    int size;
+    LogLevel level;
+    /// Index of thread label or -1.
+    int threadLabel;
+};
 
 } // namespace
 
-/// Decorates document in batches so it doesn't block UI.
-class Decorator : public QObject
+/**
+ * Indexes lines in log data and provides only lines matching current filter.
+ *
+ * Text is decoded only for lines requested by view.
+ */
+class LogModel : public QAbstractListModel
 {
-    Q_OBJECT
 public:
-    Decorator(const QRegExp &re, QObject *parent)
-        : QObject(parent)
-        , m_re(re)
+    explicit LogModel(QObject *parent)
+        : QAbstractListModel(parent)
+    {
+        for (const auto level : filteredLogLevels)
+            m_levelLabels.append(logLevelLabel(level) + " ");
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
     {
-        initSingleShotTimer(&m_timerDecorate, 0, this, SLOT(decorateBatch()));
+        return parent.isValid() ? 0 : m_visibleLines.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if ( !index.isValid() || index.row() >= m_visibleLines.size() )
+            return QVariant();
+
+        const auto &line = m_lines[ m_visibleLines[index.row()] ];
+
+        if (role == Qt::DisplayRole)
+            return lineText(line);
+
+        if (role == logLevelRole)
+            return static_cast<int>(line.level);
+
+        return QVariant();
     }
 
-    /// Start decorating.
-    void decorate(QTextDocument *document)
+    qint64 dataSize() const { return m_data.size(); }
+
+    /// Number of characters in longest line (without common prefix).
+    int maxLineSize() const { return m_maxLineSize; }
+
+    void clear()
     {
-        m_tc = QTextCursor(document);
-        m_tc.movePosition(QTextCursor::End);
-        decorateBatch();
+        beginResetModel();
+        m_data.clear();
+        m_parsedSize = 0;
+        m_lines.clear();
+        m_visibleLines.clear();
+        m_threadLabels.clear();
+        m_threadLabelIds.clear();
+        m_threadLabelVisible.clear();
+        m_maxLineSize = 0;
+        endResetModel();
     }
 
-private slots:
-    void decorateBatch()
+    /// Index complete lines in new log data.
+    void appendLogData(const QByteArray &data)
     {
-        if (m_tc.isNull())
+        if ( data.isEmpty() )
             return;
 
-        QElapsedTimer t;
-        t.start();
+        m_data.append(data);
 
-        do {
-            m_tc = m_tc.document()->find(m_re, m_tc, QTextDocument::FindBackward);
-            if (m_tc.isNull())
+        // Skip first line if incomplete.
+        if ( m_parsedSize == 0 && !m_data.startsWith(logLinePrefix) ) {
+            const int i = m_data.indexOf('\n');
+            if (i == -1)
                 return;
+            m_parsedSize = i + 1;
+        }
+
+        QVector<int> newVisibleLines;
+        for (;;) {
+            const int end = m_data.indexOf('\n', m_parsedSize);
+            if (end == -1)
+                break;
+
+            m_lines.append( parseLine(m_parsedSize, end - m_parsedSize) );
+            if ( isLineVisible(m_lines.last()) )
+                newVisibleLines.append(m_lines.size() - 1);
+
+            m_parsedSize = end + 1;
+        }
 
-            decorate(&m_tc);
-        } while ( t.elapsed() < 20 );
+        if ( newVisibleLines.isEmpty() )
+            return;
+
+        const int row = m_visibleLines.size();
+        beginInsertRows(QModelIndex(), row, row + newVisibleLines.size() - 1);
+        m_visibleLines += newVisibleLines;
+        endInsertRows();
+    }
+
+    void setLevelVisible(LogLevel level, bool visible)
+    {
+        const int mask = 1 << level;
+        m_hiddenLevels = visible ? (m_hiddenLevels & ~mask) : (m_hiddenLevels | mask);
+        filterLines();
+    }
+
+    void setThreadFilter(const QString &text)
+    {
+        m_threadFilter = text;
+        for (int i = 0; i < m_threadLabels.size(); ++i)
+            m_threadLabelVisible[i] = isThreadLabelVisible(m_threadLabels[i]);
+        filterLines();
+    }
 
-        m_timerDecorate.start();
+    QString linesText(const QModelIndexList &indexes) const
+    {
+        QList<int> rows;
+        for (const auto &index : indexes)
+            rows.append(index.row());
+        std::sort(rows.begin(), rows.end());
+
+        QString text;
+        for (const int row : rows)
+            text.append( lineText(m_lines[m_visibleLines[row]]) + "\n" );
+        return text;
     }
 
 private:
-    virtual void decorate(QTextCursor *tc) = 0;
+    LogLine parseLine(int offset, int size)
+    {
+        LogLine line;
+        line.offset = offset;
+        line.size = size;
+
+        // Continuation of unknown message.
+        line.level = m_lines.isEmpty() ? LogNote : m_lines.last().level;
+        line.threadLabel = m_lines.isEmpty() ? -1 : m_lines.last().threadLabel;
+
+        const auto text = QByteArray::fromRawData(m_data.constData() + offset, size);
+        if ( text.startsWith(logLinePrefix) ) {
+            const auto labels = QByteArray::fromRawData(
+                        text.constData() + logLinePrefixSize, size - logLinePrefixSize);
+
+            for (int i = 0; i < m_levelLabels.size(); ++i) {
+                if ( labels.startsWith(m_levelLabels[i]) ) {
+                    line.level = filteredLogLevels[i];
+                    break;
+                }
+            }
+
+            // Thread label is between time stamp and colon.
+            const int i = labels.indexOf("] ");
+            const int j = i == -1 ? -1 : labels.indexOf(':', i);
+            if (j != -1)
+                line.threadLabel = threadLabelId( labels.mid(i + 2, j - i - 2) );
+
+            m_maxLineSize = qMax(m_maxLineSize, size - logLinePrefixSize);
+        } else {
+            m_maxLineSize = qMax(m_maxLineSize, size);
+        }
+
+        return line;
+    }
 
-    QTimer m_timerDecorate;
-    QTextCursor m_tc;
-    QRegExp m_re;
-};
+    QString lineText(const LogLine &line) const
+    {
+        const char *text = m_data.constData() + line.offset;
+        int size = line.size;
+        if ( size >= logLinePrefixSize && qstrncmp(text, logLinePrefix, logLinePrefixSize) == 0 ) {
+            text += logLinePrefixSize;
+            size -= logLinePrefixSize;
+        }
+        return QString::fromUtf8(text, size);
+    }
 
-namespace {
+    int threadLabelId(const QByteArray &label)
+    {
+        auto it = m_threadLabelIds.find(label);
+        if ( it != m_threadLabelIds.end() )
+            return it.value();
+
+        const auto text = QString::fromUtf8(label);
+        m_threadLabels.append(text);
+        m_threadLabelVisible.append( isThreadLabelVisible(text) );
+        const int id = m_threadLabels.size() - 1;
+        m_threadLabelIds.insert(label, id);
+        return id;
+    }
+
+    bool isThreadLabelVisible(const QString &label) const
+    {
+        return label.contains(m_threadFilter, Qt::CaseInsensitive);
+    }
+
+    bool isLineVisible(const LogLine &line) const
+    {
+        if ( m_hiddenLevels & (1 << line.level) )
+            return false;
+
+        if ( m_threadFilter.isEmpty() )
+            return true;
+
+        return line.threadLabel != -1 && m_threadLabelVisible[line.threadLabel];
+    }
+
+    void filterLines()
+    {
+        beginResetModel();
+        m_visibleLines.clear();
+        for (int i = 0; i < m_lines.size(); ++i) {
+            if ( isLineVisible(m_lines[i]) )
+                m_visibleLines.append(i);
+        }
+        endResetModel();
+    }
+
+    QByteArray m_data;
+    int m_parsedSize = 0;
+    QVector<LogLine> m_lines;
+    QVector<int> m_visibleLines;
+    int m_maxLineSize = 0;
 
-class LogDecorator : public Decorator
+    QList<QByteArray> m_levelLabels;
+    int m_hiddenLevels = 0;
+
+    QStringList m_threadLabels;
+    QHash<QByteArray, int> m_threadLabelIds;
+    QVector<bool> m_threadLabelVisible;
+    QString m_threadFilter;
+};
+
+/// Decorates log lines when they are painted (i.e. only visible lines).
+class LogDelegate : public QStyledItemDelegate
 {
 public:
-    LogDecorator(const QFont &font, QObject *parent)
-        : Decorator(QRegExp("^[^\\]]*\\]"), parent)
-        , m_labelNote(logLevelLabel(LogNote))
-        , m_labelError(logLevelLabel(LogError))
-        , m_labelWarning(logLevelLabel(LogWarning))
-        , m_labelDebug(logLevelLabel(LogDebug))
-        , m_labelTrace(logLevelLabel(LogTrace))
+    LogDelegate(const QFont &font, const LogModel *model, QObject *parent)
+        : QStyledItemDelegate(parent)
+        , m_model(model)
+        , m_font(font)
+        , m_reThreadLabel(" [A-Z][a-z]+-[0-9-]+:")
+        , m_reString("\"[^\"]*\"|'[^']*'")
     {
+        const QFontMetrics fm(font);
+        m_lineHeight = fm.lineSpacing();
+        m_charWidth = fm.width('x');
+
         QFont boldFont = font;
         boldFont.setBold(true);
 
@@ -131,121 +326,154 @@ public:
         normalFormat.setBackground(Qt::white);
         normalFormat.setForeground(Qt::black);
 
-        m_noteLogLevelFormat = normalFormat;
+        m_logLevelFormats[LogNote] = normalFormat;
+
+        m_logLevelFormats[LogError] = normalFormat;
+        m_logLevelFormats[LogError].setForeground(Qt::red);
 
-        m_errorLogLevelFormat = normalFormat;
-        m_errorLogLevelFormat.setForeground(Qt::red);
+        m_logLevelFormats[LogWarning] = normalFormat;
+        m_logLevelFormats[LogWarning].setForeground(Qt::darkRed);
 
-        m_warningLogLevelFormat = normalFormat;
-        m_warningLogLevelFormat.setForeground(Qt::darkRed);
+        m_logLevelFormats[LogDebug] = normalFormat;
+        m_logLevelFormats[LogDebug].setForeground(QColor(100, 100, 200));
 
-        m_debugLogLevelFormat = normalFormat;
-        m_debugLogLevelFormat.setForeground(QColor(100, 100, 200));
+        m_logLevelFormats[LogTrace] = normalFormat;
+        m_logLevelFormats[LogTrace].setForeground(QColor(200, 150, 100));
 
-        m_traceLogLevelFormat = normalFormat;
-        m_traceLogLevelFormat.setForeground(QColor(200, 150, 100));
+        m_threadNameFormat.setFont(boldFont);
+
+        m_stringFormat.setForeground(Qt::darkGreen);
     }
 
-private:
-    void decorate(QTextCursor *tc) override
+    QSize sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const override
     {
-        const QString text = tc->selectedText();
-        if ( text.startsWith(m_labelNote) )
-            tc->setCharFormat(m_noteLogLevelFormat);
-        else if ( text.startsWith(m_labelError) )
-            tc->setCharFormat(m_errorLogLevelFormat);
-        else if ( text.startsWith(m_labelWarning) )
-            tc->setCharFormat(m_warningLogLevelFormat);
-        else if ( text.startsWith(m_labelDebug) )
-            tc->setCharFormat(m_debugLogLevelFormat);
-        else if ( text.startsWith(m_labelTrace) )
-            tc->setCharFormat(m_traceLogLevelFormat);
+        return QSize( m_charWidth * (m_model->maxLineSize() + 1), m_lineHeight );
     }
 
-    QString m_labelNote;
-    QString m_labelError;
-    QString m_labelWarning;
-    QString m_labelDebug;
-    QString m_labelTrace;
-
-    QTextCharFormat m_noteLogLevelFormat;
-    QTextCharFormat m_errorLogLevelFormat;
-    QTextCharFormat m_warningLogLevelFormat;
-    QTextCharFormat m_debugLogLevelFormat;
-    QTextCharFormat m_traceLogLevelFormat;
-};
-
-class StringDecorator : public Decorator
-{
-public:
-    explicit StringDecorator(QObject *parent)
-        : Decorator(QRegExp("\"[^\"]*\"|'[^']*'"), parent)
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
     {
-        m_stringFormat.setForeground(Qt::darkGreen);
+        const auto text = index.data().toString();
+        const auto level = static_cast<LogLevel>( index.data(logLevelRole).toInt() );
+
+        QTextLayout layout(text, m_font);
+        setFormats(&layout, decorations(text, level));
+        layout.beginLayout();
+        layout.createLine();
+        layout.endLayout();
+
+        painter->save();
+
+        const bool selected = option.state & QStyle::State_Selected;
+        if (selected)
+            painter->fillRect(option.rect, option.palette.highlight());
+        painter->setPen( selected ? option.palette.highlightedText().color()
+                                  : option.palette.text().color() );
+
+        layout.draw(painter, option.rect.topLeft());
+
+        painter->restore();
     }
 
-private:
-    void decorate(QTextCursor *tc) override
+    /// Make view update item sizes if longest line changed.
+    void updateLineWidth()
     {
-        tc->setCharFormat(m_stringFormat);
+        if ( m_lastMaxLineSize == m_model->maxLineSize() )
+            return;
+
+        m_lastMaxLineSize = m_model->maxLineSize();
+        emit sizeHintChanged(QModelIndex());
     }
 
-    QTextCharFormat m_stringFormat;
-};
+private:
+    using FormatRanges = QList<QTextLayout::FormatRange>;
 
-class ThreadNameDecorator : public Decorator
-{
-public:
-    explicit ThreadNameDecorator(const QFont &font, QObject *parent)
-        : Decorator(QRegExp(" [A-Z][a-z]+-[0-9-]+:"), parent)
+    static void addFormat(int start, int length, const QTextCharFormat &format, FormatRanges *formats)
     {
-        QFont boldFont = font;
-        boldFont.setBold(true);
-        m_format.setFont(boldFont);
+        QTextLayout::FormatRange range;
+        range.start = start;
+        range.length = length;
+        range.format = format;
+        formats->append(range);
     }
 
-private:
-    void decorate(QTextCursor *tc) override
+    static void setFormats(QTextLayout *layout, const FormatRanges &formats)
     {
-        // Colorize thread label.
-        const auto text = tc->selectedText();
+#if QT_VERSION < 0x050600
+        layout->setAdditionalFormats(formats);
+#else
+        layout->setFormats( formats.toVector() );
+#endif
+    }
 
-        const auto hash = qHash(text);
-        const int h = hash % 360;
-        m_format.setForeground( QColor::fromHsv(h, 150, 100) );
+    FormatRanges decorations(const QString &text, LogLevel level) const
+    {
+        FormatRanges formats;
 
-        const auto bg =
-                text.startsWith(" Server-") ? QColor::fromHsv(60, 80, 255)
-              : text.startsWith(" Monitor-") ? QColor::fromHsv(200, 80, 255)
-              : QColor(Qt::white);
-        m_format.setBackground(bg);
+        // Log level and time stamp.
+        const int labelEnd = text.indexOf(']');
+        if (labelEnd != -1)
+            addFormat( 0, labelEnd + 1, m_logLevelFormats.value(level), &formats );
 
-        tc->setCharFormat(m_format);
+        // Colorize thread label.
+        const int threadLabelStart = m_reThreadLabel.indexIn(text);
+        if (threadLabelStart != -1) {
+            const auto threadLabel = m_reThreadLabel.cap(0);
+
+            const auto hash = qHash(threadLabel);
+            const int h = hash % 360;
+            auto format = m_threadNameFormat;
+            format.setForeground( QColor::fromHsv(h, 150, 100) );
+
+            const auto bg =
+                    threadLabel.startsWith(" Server-") ? QColor::fromHsv(60, 80, 255)
+                  : threadLabel.startsWith(" Monitor-") ? QColor::fromHsv(200, 80, 255)
+                  : QColor(Qt::white);
+            format.setBackground(bg);
+
+            addFormat( threadLabelStart, threadLabel.size(), format, &formats );
+        }
+
+        for ( int i = m_reString.indexIn(text); i != -1;
+              i = m_reString.indexIn(text, i + m_reString.matchedLength()) )
+        {
+            addFormat( i, m_reString.matchedLength(), m_stringFormat, &formats );
+        }
+
+        return formats;
     }
 
-    QTextCharFormat m_format;
-};
+    const LogModel *m_model;
+    QFont m_font;
+    int m_lineHeight;
+    int m_charWidth;
+    int m_lastMaxLineSize = 0;
 
-} // namespace
+    QHash<int, QTextCharFormat> m_logLevelFormats;
+    QTextCharFormat m_threadNameFormat;
+    QTextCharFormat m_stringFormat;
+
+    mutable QRegExp m_reThreadLabel;
+    mutable QRegExp m_reString;
+};
 
 LogDialog::LogDialog(QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::LogDialog)
-    , m_showError(true)
-    , m_showWarning(true)
-    , m_showNote(true)
-    , m_showDebug(true)
-    , m_showTrace(true)
+    , m_model(new LogModel(this))
 {
     ui->setupUi(this);
 
-    auto font = ui->textBrowserLog->font();
+    auto font = ui->listViewLog->font();
     font.setFamily("Monospace");
-    ui->textBrowserLog->setFont(font);
+    ui->listViewLog->setFont(font);
+
+    m_delegate = new LogDelegate(font, m_model, this);
+    ui->listViewLog->setItemDelegate(m_delegate);
+    ui->listViewLog->setModel(m_model);
 
-    m_logDecorator = new LogDecorator(font, this);
-    m_stringDecorator = new StringDecorator(this);
-    m_threadNameDecorator = new ThreadNameDecorator(font, this);
+    auto copyShortcut = new QShortcut(QKeySequence::Copy, ui->listViewLog);
+    connect( copyShortcut, SIGNAL(activated()),
+             this, SLOT(copySelectedLines()) );
 
     ui->labelLogFileName->setText(logFileName());
 
@@ -254,8 +482,17 @@ LogDialog::LogDialog(QWidget *parent)
     addFilterCheckBox(ui->layoutFilters, LogNote, SLOT(showNote(bool)));
     addFilterCheckBox(ui->layoutFilters, LogDebug, SLOT(showDebug(bool)));
     addFilterCheckBox(ui->layoutFilters, LogTrace, SLOT(showTrace(bool)));
+
+    auto threadFilter = new QLineEdit(this);
+    threadFilter->setPlaceholderText(tr("Thread"));
+    connect( threadFilter, SIGNAL(textChanged(QString)),
+             this, SLOT(setThreadFilter(QString)) );
+    ui->layoutFilters->addWidget(threadFilter);
+
     ui->layoutFilters->addStretch(1);
 
+    initSingleShotTimer( &m_timerUpdate, updateLogIntervalMs, this, SLOT(updateLog()) );
+
     updateLog();
 }
 
@@ -266,64 +503,62 @@ LogDialog::~LogDialog()
 
 void LogDialog::updateLog()
 {
-    QString content = readLogFile(maxDisplayLogSize);
+    const QScrollBar *scrollBar = ui->listViewLog->verticalScrollBar();
+    const bool followLog = scrollBar->value() == scrollBar->maximum();
 
-    // Remove first line if incomplete.
-    if ( !content.startsWith(logLinePrefix) ) {
-        const int i = content.indexOf('\n');
-        content.remove(0, i + 1);
+    if (m_model->dataSize() > maxLogDataSize) {
+        m_model->clear();
+        m_logPosition = LogFilePosition();
     }
 
-    showLogLines(&content, m_showError, LogError);
-    showLogLines(&content, m_showWarning, LogWarning);
-    showLogLines(&content, m_showNote, LogNote);
-    showLogLines(&content, m_showDebug, LogDebug);
-    showLogLines(&content, m_showTrace, LogTrace);
-
-    // Remove common prefix.
-    const QString prefix = logLinePrefix;
-    if ( content.startsWith(prefix) )
-        content.remove( 0, prefix.size() );
-    content.replace("\n" + prefix, "\n");
-
-    ui->textBrowserLog->setPlainText(content);
+    m_model->appendLogData( readLogFileChanges(&m_logPosition, maxInitialLogSize) );
+    m_delegate->updateLineWidth();
 
-    ui->textBrowserLog->moveCursor(QTextCursor::End);
+    if (followLog)
+        ui->listViewLog->scrollToBottom();
 
-    QTextDocument *doc = ui->textBrowserLog->document();
-    m_logDecorator->decorate(doc);
-    m_stringDecorator->decorate(doc);
-    m_threadNameDecorator->decorate(doc);
+    m_timerUpdate.start();
 }
 
 void LogDialog::showError(bool show)
 {
-    m_showError = show;
-    updateLog();
+    m_model->setLevelVisible(LogError, show);
+    ui->listViewLog->scrollToBottom();
 }
 
 void LogDialog::showWarning(bool show)
 {
-    m_showWarning = show;
-    updateLog();
+    m_model->setLevelVisible(LogWarning, show);
+    ui->listViewLog->scrollToBottom();
 }
 
 void LogDialog::showNote(bool show)
 {
-    m_showNote = show;
-    updateLog();
+    m_model->setLevelVisible(LogNote, show);
+    ui->listViewLog->scrollToBottom();
 }
 
 void LogDialog::showDebug(bool show)
 {
-    m_showDebug = show;
-    updateLog();
+    m_model->setLevelVisible(LogDebug, show);
+    ui->listViewLog->scrollToBottom();
 }
 
 void LogDialog::showTrace(bool show)
 {
-    m_showTrace = show;
-    updateLog();
+    m_model->setLevelVisible(LogTrace, show);
+    ui->listViewLog->scrollToBottom();
 }
 
-#include "logdialog.moc"
+void LogDialog::setThreadFilter(const QString &text)
+{
+    m_model->setThreadFilter(text);
+    ui->listViewLog->scrollToBottom();
+}
+
+void LogDialog::copySelectedLines()
+{
+    const auto indexes = ui->listViewLog->selectionModel()->selectedIndexes();
+    if ( !indexes.isEmpty() )
+        QApplication::clipboard()->setText( m_model->linesText(indexes) );
+}
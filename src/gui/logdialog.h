@@ -16,16 +16,21 @@
     You should have received a copy of the GNU General Public License
     along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
 */
+
 #ifndef LOGDIALOG_H
 #define LOGDIALOG_H
 
+#include "common/log.h"
+
 #include <QDialog>
+#include <QTimer>
 
 namespace Ui {
 class LogDialog;
 }
 
-class Decorator;
+class LogDelegate;
+class LogModel;
 
 class LogDialog : public QDialog
 {
@@ -36,6 +41,7 @@ public:
     ~LogDialog();
 
 private slots:
+    /// Append new log lines and follow the end of log if already scrolled to it.
     void updateLog();
 
     void showError(bool show);
@@ -44,18 +50,17 @@ private slots:
     void showDebug(bool show);
     void showTrace(bool show);
 
+    void setThreadFilter(const QString &text);
+
+    void copySelectedLines();
+
 private:
     Ui::LogDialog *ui;
 
-    Decorator *m_logDecorator;
-    Decorator *m_stringDecorator;
-    Decorator *m_threadNameDecorator;
-
-    bool m_showError;
-    bool m_showWarning;
-    bool m_showNote;
-    bool m_showDebug;
-    bool m_showTrace;
+    LogModel *m_model;
+    LogDelegate *m_delegate;
+    LogFilePosition m_logPosition;
+    QTimer m_timerUpdate;
 };
 
 #endif // LOGDIALOG_H
@@ -53,12 +53,15 @@
 #include "gui/notification.h"
 #include "gui/notificationbutton.h"
 #include "gui/notificationdaemon.h"
+#include "gui/savescheduler.h"
 #include "gui/tabdialog.h"
 #include "gui/tabicons.h"
+#include "gui/tabresidencymanager.h"
 #include "gui/tabwidget.h"
 #include "gui/theme.h"
 #include "gui/traymenu.h"
 #include "gui/windowgeometryguard.h"
+#include "item/blobstore.h"
 #include "item/itemfactory.h"
 #include "item/serialize.h"
 #include "platform/platformclipboard.h"
@@ -377,6 +380,7 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     , m_lastWindow()
     , m_notifications(nullptr)
     , m_actionHandler(new ActionHandler(this))
+    , m_tabResidency(new TabResidencyManager(this))
     , m_menu( new TrayMenu(this) )
     , m_menuMaxItemCount(-1)
     , m_commandDialog(nullptr)
@@ -401,6 +405,7 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     m_showItemPreview = !ui->dockWidgetItemPreview->isHidden();
 
     m_sharedData->itemFactory = itemFactory;
+    m_sharedData->saveScheduler = new SaveScheduler(this);
 
     updateIcon();
 
@@ -1024,9 +1029,20 @@ void MainWindow::onItemWidgetCreated(const PersistentDisplayItem &item)
     if ( m_displayCommands.isEmpty() )
         return;
 
+    // Drop pending items replaced by new widgets or scrolled out of view.
+    for (int i = m_displayItemList.size() - 1; i >= 0; --i) {
+        if ( m_displayItemList[i].isGone() )
+            m_displayItemList.removeAt(i);
+    }
+
     m_displayItemList.append(item);
-    if (!m_currentDisplayAction)
+
+    if (!m_currentDisplayAction) {
         runDisplayCommands();
+    } else if ( m_currentDisplayItem.isGone() ) {
+        // Next item is started after the cancelled action is destroyed.
+        m_actionHandler->cancelQueuedAction(m_currentDisplayAction);
+    }
 }
 
 void MainWindow::onDisplayActionFinished()
@@ -1060,7 +1076,11 @@ void MainWindow::runDisplayCommands()
 
     m_currentDisplayItem = m_displayItemList.takeFirst();
 
-    m_currentDisplayAction = runScript("runDisplayCommands()", m_currentDisplayItem.data());
+    // Display items are processed one by one and already coalesced per item
+    // widget in onItemWidgetCreated(), so no coalescing key is needed.
+    const auto &data = m_currentDisplayItem.data();
+    m_currentDisplayAction = runScript(
+                "runDisplayCommands()", data, ActionCategory::Display);
     connect( m_currentDisplayAction.data(), SIGNAL(destroyed()),
              this, SLOT(onDisplayActionFinished()) );
 }
@@ -1353,6 +1373,7 @@ ClipboardBrowserPlaceholder *MainWindow::createTab(
     auto placeholder = new ClipboardBrowserPlaceholder(name, m_sharedData, this);
     connect( placeholder, SIGNAL(browserCreated(ClipboardBrowser*)),
              this, SLOT(onBrowserCreated(ClipboardBrowser*)) );
+    m_tabResidency->addTab(placeholder);
 
     ui->tabWidget->addTab(placeholder, name);
     saveTabPositions();
@@ -1500,7 +1521,12 @@ void MainWindow::addMenuMatchCommand(MenuMatchCommands *menuMatchCommands, const
 void MainWindow::runMenuCommandFilters(MenuMatchCommands *menuMatchCommands, const QVariantMap &data)
 {
     if ( !menuMatchCommands->actions.isEmpty() ) {
-        const auto act = runScript("runMenuCommandFilters()", data);
+        // Filters for previous menu content are not needed anymore.
+        const auto coalescingKey = menuMatchCommands == &m_trayMenuMatchCommands
+                ? QString("tray") : QString("item");
+        const auto act = runScript(
+                    "runMenuCommandFilters()", data,
+                    ActionCategory::MenuFilter, coalescingKey);
         menuMatchCommands->actionId = act->id();
     }
 }
@@ -1967,12 +1993,14 @@ const Theme &MainWindow::theme() const
     return m_sharedData->theme;
 }
 
-Action *MainWindow::runScript(const QString &script, const QVariantMap &data)
+Action *MainWindow::runScript(
+        const QString &script, const QVariantMap &data,
+        ActionCategory category, const QString &coalescingKey)
 {
     auto act = new Action();
     act->setCommand(QStringList() << "copyq" << "eval" << "--" << script);
     act->setData(data);
-    runInternalAction(act);
+    runInternalAction(act, category, coalescingKey);
     return act;
 }
 
@@ -2300,6 +2328,9 @@ void MainWindow::loadSettings()
     m_sharedData->moveItemOnReturnKey = appConfig.option<Config::move>();
     m_sharedData->showSimpleItems = appConfig.option<Config::show_simple_items>();
     m_sharedData->minutesToExpire = appConfig.option<Config::expire_tab>();
+    m_sharedData->pagedEditorThreshold = 1024 * appConfig.option<Config::paged_editor_threshold>();
+
+    m_tabResidency->setMemoryLimit( 1024 * 1024 * static_cast<qint64>(appConfig.option<Config::tabs_memory_limit>()) );
 
     reloadBrowsers();
 
@@ -2315,6 +2346,8 @@ void MainWindow::loadSettings()
 
     ui->tabWidget->updateTabs();
 
+    m_tabResidency->preloadTabs(m_sharedData->maxItems);
+
     m_timerSaveTabPositions.stop();
 
     updateContextMenu(contextMenuUpdateIntervalMsec);
@@ -2527,6 +2560,9 @@ void MainWindow::tabChanged(int current, int)
     emit tabGroupSelected(currentIsTabGroup);
 
     if (!currentIsTabGroup) {
+        if (current >= 0)
+            m_tabResidency->countTabUse( ui->tabWidget->tabName(current) );
+
         // update item menu (necessary for keyboard shortcuts to work)
         auto c = browser();
         if (c) {
@@ -2659,6 +2695,16 @@ void MainWindow::setActionData(int id, const QVariantMap &data)
     m_actionHandler->setActionData(id, data);
 }
 
+QVector<QVariantMap> MainWindow::actionHistory() const
+{
+    return m_actionHandler->actionHistory();
+}
+
+QVariantList MainWindow::tabMemoryUsage() const
+{
+    return m_tabResidency->memoryUsage();
+}
+
 void MainWindow::setCommands(const QVector<Command> &commands)
 {
     if ( !maybeCloseCommandDialog() )
@@ -2788,9 +2834,13 @@ void MainWindow::setClipboard(const QVariantMap &data, ClipboardMode mode)
 {
     const auto argument = mode == ClipboardMode::Clipboard
             ? "provideClipboard" : "provideSelection";
+    // Load data which were too big to be stored in item.
+    QVariantMap newData = data;
+    BlobStore::instance()->loadDataFiles(&newData);
+
     auto act = new Action();
     act->setCommand(QStringList() << "copyq" << argument);
-    act->setData(data);
+    act->setData(newData);
 
     // Wait for clipboard/selection change.
     ClipboardSpy spy(mode);
@@ -3283,12 +3333,9 @@ bool MainWindow::exportData()
 
 void MainWindow::saveTabs()
 {
-    for( int i = 0; i < ui->tabWidget->count(); ++i ) {
-        auto c = getPlaceholder(i)->browser();
-        if (c)
-            c->saveUnsavedItems();
-    }
+    m_sharedData->saveScheduler->flush();
     ui->tabWidget->saveTabInfo();
+    m_tabResidency->saveTabUseCounts();
 }
 
 bool MainWindow::loadTab(const QString &fileName)
@@ -3414,9 +3461,9 @@ Action *MainWindow::action(const QVariantMap &data, const Command &cmd, const QM
     return nullptr;
 }
 
-void MainWindow::runInternalAction(Action *action)
+void MainWindow::runInternalAction(Action *action, ActionCategory category, const QString &coalescingKey)
 {
-    m_actionHandler->internalAction(action);
+    m_actionHandler->internalAction(action, category, coalescingKey);
 }
 
 bool MainWindow::isInternalActionId(int id) const
@@ -22,6 +22,7 @@
 
 #include "common/clipboardmode.h"
 #include "common/command.h"
+#include "gui/actionscheduler.h"
 #include "gui/clipboardbrowsershared.h"
 #include "gui/menuitems.h"
 #include "item/persistentdisplayitem.h"
@@ -48,6 +49,7 @@ class Notification;
 class NotificationDaemon;
 class QAction;
 class QMimeData;
+class TabResidencyManager;
 class Theme;
 class TrayMenu;
 struct MainWindowOptions;
@@ -237,7 +239,7 @@ public:
             int tabIndex = -1 //!< Tab index or current tab.
             );
 
-    /** Save all unsaved tabs. */
+    /** Save all unsaved tabs and wait until they are written. */
     void saveTabs();
 
     /**
@@ -272,6 +274,11 @@ public:
     QVariantMap actionData(int id) const;
     void setActionData(int id, const QVariantMap &data);
 
+    QVector<QVariantMap> actionHistory() const;
+
+    /// Return approximate memory used by each tab.
+    QVariantList tabMemoryUsage() const;
+
     void setCommands(const QVector<Command> &commands);
 
     void setSessionIconColor(QColor color);
@@ -372,7 +379,10 @@ public slots:
             const Command &cmd,
             const QModelIndex &outputIndex);
 
-    void runInternalAction(Action *action);
+    void runInternalAction(
+            Action *action,
+            ActionCategory category = ActionCategory::Internal,
+            const QString &coalescingKey = QString());
     bool isInternalActionId(int id) const;
 
     /** Set clipboard. */
@@ -681,7 +691,11 @@ private:
 
     const Theme &theme() const;
 
-    Action *runScript(const QString &script, const QVariantMap &data = QVariantMap());
+    Action *runScript(
+            const QString &script,
+            const QVariantMap &data = QVariantMap(),
+            ActionCategory category = ActionCategory::Internal,
+            const QString &coalescingKey = QString());
 
     ConfigurationManager *cm;
     Ui::MainWindow *ui;
@@ -718,6 +732,8 @@ private:
 
     ActionHandler *m_actionHandler;
 
+    TabResidencyManager *m_tabResidency;
+
     QVariantMap m_clipboardData;
 
     TrayMenu *m_menu;
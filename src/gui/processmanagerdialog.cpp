@@ -22,12 +22,15 @@
 
 #include "common/action.h"
 #include "common/shortcuts.h"
+#include "gui/actionscheduler.h"
 #include "gui/iconfont.h"
 #include "gui/icons.h"
 #include "gui/windowgeometryguard.h"
 
 #include <QDateTime>
+#include <QHeaderView>
 #include <QPushButton>
+#include <QSortFilterProxyModel>
 
 #include <algorithm>
 #include <functional>
@@ -36,6 +39,8 @@ namespace {
 
 const int maxNumberOfProcesses = 100;
 
+const char propertyQueuedAction[] = "CopyQ_queued_action";
+
 namespace statusItemData {
 enum {
     actionId = Qt::UserRole,
@@ -94,6 +99,23 @@ quintptr actionId(const Action *act)
     return reinterpret_cast<quintptr>(act);
 }
 
+QString categoryName(ActionCategory category)
+{
+    switch (category) {
+    case ActionCategory::Interactive:
+        return ProcessManagerDialog::tr("Commands");
+    case ActionCategory::Internal:
+        return ProcessManagerDialog::tr("Internal");
+    case ActionCategory::Display:
+        return ProcessManagerDialog::tr("Display commands");
+    case ActionCategory::MenuFilter:
+        return ProcessManagerDialog::tr("Menu filters");
+    }
+
+    Q_ASSERT(false && "Undefined name for action category!");
+    return QString();
+}
+
 } // namespace
 
 ProcessManagerDialog::ProcessManagerDialog(QWidget *parent)
@@ -161,39 +183,78 @@ void ProcessManagerDialog::actionStarted(Action *action)
     statusItem->setText(tr("Running"));
     statusItem->setData(statusItemData::status, QProcess::Running);
     updateTable();
+
+    // Button could be used to cancel the action while it was queued.
+    QWidget *button = t->cellWidget(row, tableCommandsColumns::action);
+    if ( button->property(propertyQueuedAction).isValid() ) {
+        button->setProperty(propertyQueuedAction, QVariant());
+        button->disconnect();
+        connect( button, SIGNAL(clicked()),
+                 action, SLOT(terminate()) );
+    }
 }
 
 void ProcessManagerDialog::actionFinished(Action *action)
+{
+    const QString status = action->actionFailed() ? tr("Failed") : tr("Finished");
+    setActionFinished(action, status);
+}
+
+void ProcessManagerDialog::actionFinished(const QString &name)
+{
+    createTableRow(name);
+}
+
+void ProcessManagerDialog::actionQueued(Action *action)
 {
     const int row = getRowForAction(action);
     Q_ASSERT(row != -1);
 
-    const QString status = action->actionFailed() ? tr("Failed") : tr("Finished");
-
     QTableWidget *t = ui->tableWidgetCommands;
     SortingGuard sortGuard(t);
 
-    QWidget *button = t->cellWidget(row, tableCommandsColumns::action);
-    QTableWidgetItem *statusItem = t->item(row, tableCommandsColumns::status);
-    statusItem->setText(status);
-    statusItem->setData(statusItemData::status, QProcess::NotRunning);
-    t->item(row, tableCommandsColumns::endTime)->setText(currentTime());
-    button->setToolTip( tr("Remove") );
-    button->setProperty( "text", QString(IconTrash) );
+    t->item(row, tableCommandsColumns::status)->setText(tr("Queued"));
     updateTable();
 
+    QWidget *button = t->cellWidget(row, tableCommandsColumns::action);
+    button->setToolTip( tr("Cancel") );
+    button->setProperty( propertyQueuedAction, QVariant::fromValue<QObject*>(action) );
     button->disconnect();
     connect( button, SIGNAL(clicked()),
-             this, SLOT(onRemoveActionButtonClicked()) );
+             this, SLOT(onCancelActionButtonClicked()) );
+}
 
-    // Reset action ID so it can be used again.
-    t->item(row, tableCommandsColumns::status)->setData(statusItemData::actionId, 0);
-    Q_ASSERT(getRowForAction(action) == -1);
+void ProcessManagerDialog::actionCancelled(Action *action)
+{
+    setActionFinished( action, tr("Cancelled") );
 }
 
-void ProcessManagerDialog::actionFinished(const QString &name)
+void ProcessManagerDialog::setQueueStatistics(const ActionScheduler &scheduler)
 {
-    createTableRow(name);
+    QStringList lines;
+    for (int i = 0; i < actionCategoryCount; ++i) {
+        const auto category = static_cast<ActionCategory>(i);
+        const auto &stats = scheduler.statistics(category);
+        if (stats.started == 0 && stats.queued == 0 && stats.coalesced == 0)
+            continue;
+
+        lines.append(
+            tr("%1: %2 running, %3 queued (at most %4), %5 started, %6 skipped")
+                    .arg( categoryName(category) )
+                    .arg(stats.running)
+                    .arg(stats.queued)
+                    .arg(stats.peakQueued)
+                    .arg(stats.started)
+                    .arg(stats.coalesced) );
+    }
+
+    ui->labelQueueStatistics->setText( lines.join("\n") );
+}
+
+void ProcessManagerDialog::setActionHistoryModels(QAbstractItemModel *history, QAbstractItemModel *statistics)
+{
+    setSortedModel(ui->tableViewHistory, history);
+    setSortedModel(ui->tableViewStatistics, statistics);
 }
 
 void ProcessManagerDialog::showEvent(QShowEvent *event)
@@ -210,6 +271,15 @@ void ProcessManagerDialog::onRemoveActionButtonClicked()
     ui->tableWidgetCommands->removeRow(row);
 }
 
+void ProcessManagerDialog::onCancelActionButtonClicked()
+{
+    Q_ASSERT(sender());
+    const auto object = sender()->property(propertyQueuedAction).value<QObject*>();
+    const auto action = qobject_cast<Action*>(object);
+    if (action)
+        emit cancelActionRequested(action);
+}
+
 void ProcessManagerDialog::onDeleteShortcut()
 {
     const QList<QTableWidgetItem *> selectedItems = ui->tableWidgetCommands->selectedItems();
@@ -264,6 +334,33 @@ bool ProcessManagerDialog::removeIfNotRunning(int row)
     return true;
 }
 
+void ProcessManagerDialog::setActionFinished(Action *action, const QString &status)
+{
+    const int row = getRowForAction(action);
+    Q_ASSERT(row != -1);
+
+    QTableWidget *t = ui->tableWidgetCommands;
+    SortingGuard sortGuard(t);
+
+    QWidget *button = t->cellWidget(row, tableCommandsColumns::action);
+    QTableWidgetItem *statusItem = t->item(row, tableCommandsColumns::status);
+    statusItem->setText(status);
+    statusItem->setData(statusItemData::status, QProcess::NotRunning);
+    t->item(row, tableCommandsColumns::endTime)->setText(currentTime());
+    button->setToolTip( tr("Remove") );
+    button->setProperty( "text", QString(IconTrash) );
+    button->setProperty( propertyQueuedAction, QVariant() );
+    updateTable();
+
+    button->disconnect();
+    connect( button, SIGNAL(clicked()),
+             this, SLOT(onRemoveActionButtonClicked()) );
+
+    // Reset action ID so it can be used again.
+    t->item(row, tableCommandsColumns::status)->setData(statusItemData::actionId, 0);
+    Q_ASSERT(getRowForAction(action) == -1);
+}
+
 void ProcessManagerDialog::updateTable()
 {
     if (isVisible())
@@ -307,3 +404,14 @@ QWidget *ProcessManagerDialog::createRemoveButton(Action *action)
 
     return button;
 }
+
+void ProcessManagerDialog::setSortedModel(QTableView *view, QAbstractItemModel *model)
+{
+    auto proxyModel = new QSortFilterProxyModel(this);
+    proxyModel->setSourceModel(model);
+    view->setModel(proxyModel);
+
+    // Keep order of source model until user clicks on a column header.
+    view->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    view->setSortingEnabled(true);
+}
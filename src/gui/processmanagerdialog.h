@@ -23,6 +23,9 @@
 #include <QDialog>
 
 class Action;
+class ActionScheduler;
+class QAbstractItemModel;
+class QTableView;
 
 namespace Ui {
 class ProcessManagerDialog;
@@ -41,21 +44,35 @@ public:
     void actionStarted(Action *action);
     void actionFinished(Action *action);
     void actionFinished(const QString &name);
+    void actionQueued(Action *action);
+    void actionCancelled(Action *action);
+
+    void setQueueStatistics(const ActionScheduler &scheduler);
+
+    /** Show history of finished actions and statistics aggregated by command. */
+    void setActionHistoryModels(QAbstractItemModel *history, QAbstractItemModel *statistics);
+
+signals:
+    /** Emitted if user wants to remove action from queue. */
+    void cancelActionRequested(Action *action);
 
 protected:
     void showEvent(QShowEvent *event) override;
 
 private slots:
     void onRemoveActionButtonClicked();
+    void onCancelActionButtonClicked();
     void onDeleteShortcut();
 
 private:
     int getRowForAction(Action *action) const;
     int getRowForActionButton(QObject *button) const;
     bool removeIfNotRunning(int row);
+    void setActionFinished(Action *action, const QString &status);
     void updateTable();
     void createTableRow(const QString &name, Action *action = nullptr);
     QWidget *createRemoveButton(Action *action = nullptr);
+    void setSortedModel(QTableView *view, QAbstractItemModel *model);
 
     Ui::ProcessManagerDialog *ui;
 };
@@ -0,0 +1,101 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "savescheduler.h"
+
+#include "common/common.h"
+#include "gui/clipboardbrowser.h"
+#include "item/itemstore.h"
+
+#include <QVector>
+
+#include <algorithm>
+
+SaveScheduler::SaveScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    initSingleShotTimer( &m_timerSave, 0, this, SLOT(saveScheduledTabs()) );
+}
+
+void SaveScheduler::scheduleSave(ClipboardBrowser *browser, int delayMs)
+{
+    const qint64 saveTime = m_clock.elapsed() + delayMs;
+    const auto it = m_saveTimes.find(browser);
+    if ( it == m_saveTimes.end() )
+        m_saveTimes.insert(browser, saveTime);
+    else if ( saveTime < it.value() )
+        it.value() = saveTime;
+    else
+        return;
+
+    startTimer();
+}
+
+void SaveScheduler::cancelSave(const ClipboardBrowser *browser)
+{
+    m_saveTimes.remove( const_cast<ClipboardBrowser*>(browser) );
+}
+
+bool SaveScheduler::isSaveScheduled(const ClipboardBrowser *browser) const
+{
+    return m_saveTimes.contains( const_cast<ClipboardBrowser*>(browser) );
+}
+
+void SaveScheduler::flush()
+{
+    m_timerSave.stop();
+
+    const auto browsers = m_saveTimes.keys();
+    m_saveTimes.clear();
+    for (auto c : browsers)
+        c->saveItems();
+
+    waitForSavedItems();
+}
+
+void SaveScheduler::saveScheduledTabs()
+{
+    const qint64 now = m_clock.elapsed();
+
+    QVector<ClipboardBrowser*> browsers;
+    for (auto it = m_saveTimes.constBegin(); it != m_saveTimes.constEnd(); ++it) {
+        if ( it.value() <= now )
+            browsers.append( it.key() );
+    }
+
+    for (auto c : browsers) {
+        m_saveTimes.remove(c);
+        c->saveItems();
+    }
+
+    startTimer();
+}
+
+void SaveScheduler::startTimer()
+{
+    if ( m_saveTimes.isEmpty() ) {
+        m_timerSave.stop();
+        return;
+    }
+
+    const qint64 nextSaveTime = *std::min_element( m_saveTimes.constBegin(), m_saveTimes.constEnd() );
+    const qint64 delayMs = qMax(Q_INT64_C(0), nextSaveTime - m_clock.elapsed());
+    m_timerSave.start( static_cast<int>(delayMs) );
+}
@@ -0,0 +1,69 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SAVESCHEDULER_H
+#define SAVESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+class ClipboardBrowser;
+
+/**
+ * Saves items of changed tabs.
+ *
+ * All changes in a tab before scheduled time are saved at once, so bursts
+ * of changes (e.g. from scripts) don't save the tab repeatedly. Items are
+ * serialized immediately and written to disk in a background thread.
+ */
+class SaveScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SaveScheduler(QObject *parent = nullptr);
+
+    /**
+     * Save items in tab after given time.
+     *
+     * If the tab is already scheduled to be saved earlier, nothing changes.
+     */
+    void scheduleSave(ClipboardBrowser *browser, int delayMs);
+
+    void cancelSave(const ClipboardBrowser *browser);
+
+    bool isSaveScheduled(const ClipboardBrowser *browser) const;
+
+    /// Save all scheduled tabs and wait until all items are written.
+    void flush();
+
+private slots:
+    void saveScheduledTabs();
+
+private:
+    void startTimer();
+
+    QHash<ClipboardBrowser*, qint64> m_saveTimes;
+    QElapsedTimer m_clock;
+    QTimer m_timerSave;
+};
+
+#endif // SAVESCHEDULER_H
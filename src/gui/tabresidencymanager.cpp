@@ -0,0 +1,369 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tabresidencymanager.h"
+
+#include "common/common.h"
+#include "common/config.h"
+#include "common/contenttype.h"
+#include "common/log.h"
+#include "gui/clipboardbrowser.h"
+#include "gui/clipboardbrowserplaceholder.h"
+#include "item/blobstore.h"
+#include "item/clipboardmodel.h"
+#include "item/itemstore.h"
+#include "item/serialize.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include <QVariantMap>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+
+/// Maximum number of tabs to preload.
+const int preloadTabCount = 3;
+
+/// Delay after start before preloading tabs (to keep start fast).
+const int preloadDelayMs = 10000;
+
+/// Delay after preloading before dropping unused preloaded items.
+const int dropPreloadedItemsDelayMs = 5 * 60 * 1000;
+
+/// Delay before saving changed tab use counts.
+const int saveTabUseCountsDelayMs = 30000;
+
+const char optionTabUseCounts[] = "tab_use_counts";
+
+QString usageFilePath()
+{
+    return getConfigurationFilePath("_usage.ini");
+}
+
+} // namespace
+
+ItemFileReader::ItemFileReader(
+        const QStringList &tabNames, const QStringList &fileNames,
+        const BlobStore *blobStore, int maxItems, qint64 maxBlobBytes)
+    : m_tabNames(tabNames)
+    , m_fileNames(fileNames)
+    , m_blobStore(blobStore)
+    , m_maxItems(maxItems)
+    , m_maxBlobBytes(maxBlobBytes)
+{
+}
+
+void ItemFileReader::readFiles()
+{
+    for (int i = 0; i < m_fileNames.size(); ++i) {
+        const QString &fileName = m_fileNames[i];
+        const QDateTime lastModified = QFileInfo(fileName).lastModified();
+
+        QFile file(fileName);
+        if ( !file.open(QIODevice::ReadOnly) )
+            continue;
+
+        QByteArray bytes = file.readAll();
+        if ( bytes.size() != file.size() )
+            continue;
+
+        // Read stored data used by items and deserialize items in default format
+        // (plugins load their items later in main thread from the file content).
+        BlobReader blobs(m_blobStore, m_maxBlobBytes);
+        ClipboardModel model;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        const bool deserialized = deserializeData(&model, &buffer, m_maxItems, &blobs);
+        if (m_maxBlobBytes >= 0)
+            m_maxBlobBytes = qMax( Q_INT64_C(0), m_maxBlobBytes - blobs.bytes() );
+
+        PreloadedItems items;
+        items.bytes = bytes;
+        items.lastModified = lastModified;
+        items.blobs = blobs.blobs();
+        items.deserialized = deserialized && !blobs.hasSkippedBlobs();
+        if (items.deserialized) {
+            items.items.reserve( model.rowCount() );
+            for (int row = 0; row < model.rowCount(); ++row)
+                items.items.append( model.index(row, 0).data(contentType::data).toMap() );
+            items.blobReferences = blobs.references();
+        }
+
+        emit fileRead(m_tabNames[i], items);
+    }
+
+    emit finished();
+}
+
+TabResidencyManager::TabResidencyManager(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<PreloadedItems>("PreloadedItems");
+
+    initSingleShotTimer( &m_timerUnloadTabs, 1000, this, SLOT(unloadTabsOverLimit()) );
+    initSingleShotTimer( &m_timerPreload, preloadDelayMs, this, SLOT(startPreloading()) );
+    initSingleShotTimer( &m_timerDropPreloadedItems, dropPreloadedItemsDelayMs, this, SLOT(dropPreloadedItems()) );
+    initSingleShotTimer( &m_timerSaveTabUseCounts, saveTabUseCountsDelayMs, this, SLOT(saveTabUseCounts()) );
+
+    const QSettings settings(usageFilePath(), QSettings::IniFormat);
+    const QVariantMap counts = settings.value(optionTabUseCounts).toMap();
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+        m_tabUseCounts.insert( it.key(), it.value().toInt() );
+}
+
+TabResidencyManager::~TabResidencyManager()
+{
+    saveTabUseCounts();
+
+    if (m_preloadThread) {
+        m_preloadThread->quit();
+        m_preloadThread->wait();
+    }
+}
+
+void TabResidencyManager::addTab(ClipboardBrowserPlaceholder *placeholder)
+{
+    m_tabs.append(placeholder);
+    connect( placeholder, SIGNAL(browserUsed(ClipboardBrowserPlaceholder*)),
+             this, SLOT(onBrowserUsed(ClipboardBrowserPlaceholder*)) );
+}
+
+void TabResidencyManager::countTabUse(const QString &tabName)
+{
+    int &count = m_tabUseCounts[tabName];
+    ++count;
+
+    // Prefer recent usage by halving old counts.
+    if (count > 1000) {
+        for (auto it = m_tabUseCounts.begin(); it != m_tabUseCounts.end(); ++it)
+            it.value() /= 2;
+    }
+
+    m_tabUseCountsChanged = true;
+    if ( !m_timerSaveTabUseCounts.isActive() )
+        m_timerSaveTabUseCounts.start();
+}
+
+void TabResidencyManager::saveTabUseCounts()
+{
+    m_timerSaveTabUseCounts.stop();
+    if (!m_tabUseCountsChanged)
+        return;
+
+    m_tabUseCountsChanged = false;
+
+    QVariantMap counts;
+    for (auto it = m_tabUseCounts.constBegin(); it != m_tabUseCounts.constEnd(); ++it) {
+        if (it.value() > 0)
+            counts.insert( it.key(), it.value() );
+    }
+
+    QSettings settings(usageFilePath(), QSettings::IniFormat);
+    settings.setValue(optionTabUseCounts, counts);
+}
+
+void TabResidencyManager::preloadTabs(int maxItems)
+{
+    m_maxItems = maxItems;
+    m_timerPreload.start();
+}
+
+void TabResidencyManager::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = bytes;
+    if (m_memoryLimit > 0)
+        m_timerUnloadTabs.start();
+}
+
+QVariantList TabResidencyManager::memoryUsage() const
+{
+    QVariantList result;
+    for (const auto &placeholder : m_tabs) {
+        if (!placeholder)
+            continue;
+
+        const auto c = placeholder->browser();
+        QVariantMap tab;
+        tab["name"] = placeholder->tabName();
+        tab["loaded"] = c != nullptr;
+        tab["items"] = c ? c->length() : 0;
+        tab["bytes"] = c ? c->memoryUsage() : 0;
+        result.append(tab);
+    }
+
+    return result;
+}
+
+void TabResidencyManager::onBrowserUsed(ClipboardBrowserPlaceholder *placeholder)
+{
+    const int i = m_tabs.indexOf(placeholder);
+    if (i > 0)
+        m_tabs.move(i, 0);
+
+    if (m_memoryLimit > 0 && !m_timerUnloadTabs.isActive())
+        m_timerUnloadTabs.start();
+}
+
+void TabResidencyManager::unloadTabsOverLimit()
+{
+    if (m_memoryLimit <= 0)
+        return;
+
+    removeDeletedTabs();
+
+    QVector<qint64> sizes;
+    sizes.reserve( m_tabs.size() );
+    qint64 totalSize = 0;
+    for (const auto &placeholder : m_tabs) {
+        const auto c = placeholder->browser();
+        const qint64 size = c ? c->memoryUsage() : 0;
+        sizes.append(size);
+        totalSize += size;
+    }
+
+    // Drop items read in advance first.
+    const qint64 preloadedSize = preloadedItemsMemoryUsage();
+    totalSize += preloadedSize;
+    if (preloadedSize > 0 && totalSize > m_memoryLimit) {
+        dropPreloadedItems();
+        totalSize -= preloadedSize;
+    }
+
+    for (int i = m_tabs.size() - 1; i >= 0 && totalSize > m_memoryLimit; --i) {
+        if ( sizes[i] > 0 && m_tabs[i]->unloadUnmodifiedBrowser() ) {
+            COPYQ_LOG( QString("Tab \"%1\": Unloaded to free memory (%2 bytes)")
+                       .arg(m_tabs[i]->tabName())
+                       .arg(sizes[i]) );
+            totalSize -= sizes[i];
+        }
+    }
+}
+
+void TabResidencyManager::startPreloading()
+{
+    if (m_preloadThread)
+        return;
+
+    removeDeletedTabs();
+
+    QVector<ClipboardBrowserPlaceholder*> candidates;
+    for (const auto &placeholder : m_tabs) {
+        const QString tabName = placeholder->tabName();
+        if ( !placeholder->browser()
+             && m_tabUseCounts.value(tabName) > 0
+             && !hasPreloadedItems(tabName) )
+        {
+            candidates.append(placeholder);
+        }
+    }
+
+    std::stable_sort(
+        std::begin(candidates), std::end(candidates),
+        [this](const ClipboardBrowserPlaceholder *lhs, const ClipboardBrowserPlaceholder *rhs) {
+            return m_tabUseCounts.value(lhs->tabName()) > m_tabUseCounts.value(rhs->tabName());
+        });
+
+    qint64 totalSize = loadedTabsMemoryUsage() + preloadedItemsMemoryUsage();
+    QStringList tabNames;
+    QStringList fileNames;
+    for (const auto placeholder : candidates) {
+        if ( tabNames.size() >= preloadTabCount )
+            break;
+
+        const QString tabName = placeholder->tabName();
+        const QString fileName = itemFileName(tabName);
+        const QFileInfo info(fileName);
+        if ( !info.exists() )
+            continue;
+
+        totalSize += info.size();
+        if (m_memoryLimit > 0 && totalSize > m_memoryLimit)
+            break;
+
+        tabNames.append(tabName);
+        fileNames.append(fileName);
+    }
+
+    if ( tabNames.isEmpty() )
+        return;
+
+    COPYQ_LOG( QString("Preloading tabs: %1").arg(tabNames.join(", ")) );
+
+    // Stored data used by items are read only up to the memory limit.
+    const qint64 maxBlobBytes = m_memoryLimit > 0 ? m_memoryLimit - totalSize : -1;
+    auto reader = new ItemFileReader(
+                tabNames, fileNames, BlobStore::instance(), m_maxItems, maxBlobBytes);
+    m_preloadThread = new QThread(this);
+    reader->moveToThread(m_preloadThread);
+    connect( m_preloadThread, SIGNAL(started()), reader, SLOT(readFiles()) );
+    connect( m_preloadThread, SIGNAL(finished()), reader, SLOT(deleteLater()) );
+    connect( m_preloadThread, SIGNAL(finished()), m_preloadThread, SLOT(deleteLater()) );
+    connect( reader, SIGNAL(finished()), m_preloadThread, SLOT(quit()) );
+    connect( reader, SIGNAL(fileRead(QString,PreloadedItems)),
+             this, SLOT(onItemFileRead(QString,PreloadedItems)) );
+    m_preloadThread->start();
+}
+
+void TabResidencyManager::onItemFileRead(const QString &tabName, const PreloadedItems &items)
+{
+    // Skip if the tab was loaded in the meantime.
+    for (const auto &placeholder : m_tabs) {
+        if ( placeholder && placeholder->tabName() == tabName && placeholder->browser() )
+            return;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Preloaded %2 bytes and %3 stored data%4")
+               .arg(tabName)
+               .arg(items.bytes.size())
+               .arg(items.blobs.size())
+               .arg(items.deserialized ? QString(" (%1 items)").arg(items.items.size()) : QString()) );
+    setPreloadedItems(tabName, items);
+
+    m_timerDropPreloadedItems.start();
+    if (m_memoryLimit > 0 && !m_timerUnloadTabs.isActive())
+        m_timerUnloadTabs.start();
+}
+
+void TabResidencyManager::dropPreloadedItems()
+{
+    m_timerDropPreloadedItems.stop();
+    COPYQ_LOG( QString("Dropping preloaded items (%1 bytes)").arg(preloadedItemsMemoryUsage()) );
+    clearPreloadedItems();
+}
+
+void TabResidencyManager::removeDeletedTabs()
+{
+    m_tabs.removeAll( QPointer<ClipboardBrowserPlaceholder>() );
+}
+
+qint64 TabResidencyManager::loadedTabsMemoryUsage() const
+{
+    qint64 totalSize = 0;
+    for (const auto &placeholder : m_tabs) {
+        const auto c = placeholder ? placeholder->browser() : nullptr;
+        if (c)
+            totalSize += c->memoryUsage();
+    }
+    return totalSize;
+}
@@ -0,0 +1,136 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TABRESIDENCYMANAGER_H
+#define TABRESIDENCYMANAGER_H
+
+#include "item/itemstore.h"
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
+
+class BlobStore;
+class ClipboardBrowserPlaceholder;
+class QThread;
+
+Q_DECLARE_METATYPE(PreloadedItems)
+
+/**
+ * Reads item files and stored data used by the items in a background thread.
+ *
+ * Items in default format are also deserialized if all their stored data were read.
+ */
+class ItemFileReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Stops reading stored data after given number of bytes (if non-negative).
+    ItemFileReader(
+            const QStringList &tabNames, const QStringList &fileNames,
+            const BlobStore *blobStore, int maxItems, qint64 maxBlobBytes);
+
+public slots:
+    void readFiles();
+
+signals:
+    void fileRead(const QString &tabName, const PreloadedItems &items);
+    void finished();
+
+private:
+    QStringList m_tabNames;
+    QStringList m_fileNames;
+    const BlobStore *m_blobStore;
+    int m_maxItems;
+    qint64 m_maxBlobBytes;
+};
+
+/**
+ * Keeps memory used by loaded tabs under a limit and preloads most used tabs.
+ *
+ * When memory used by items in all loaded tabs exceeds the limit, least
+ * recently used tabs are unloaded (only hidden tabs which are not edited
+ * and have no unsaved changes).
+ *
+ * Item files of the most often opened tabs are read in background shortly
+ * after start so the tabs open faster. Preloaded items count towards the
+ * memory limit and are dropped if not used for a while.
+ */
+class TabResidencyManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TabResidencyManager(QObject *parent = nullptr);
+
+    ~TabResidencyManager();
+
+    void addTab(ClipboardBrowserPlaceholder *placeholder);
+
+    /// Count opening a tab (the counts are stored in configuration after a while).
+    void countTabUse(const QString &tabName);
+
+    /// Read items of most used tabs in background after a while.
+    void preloadTabs(int maxItems);
+
+    /// Set memory limit in bytes (0 to disable).
+    void setMemoryLimit(qint64 bytes);
+
+    /**
+     * Return memory usage of tabs, most recently used first.
+     *
+     * Each map has keys "name", "loaded", "items" and "bytes".
+     */
+    QVariantList memoryUsage() const;
+
+public slots:
+    /// Store changed tab use counts in configuration.
+    void saveTabUseCounts();
+
+private slots:
+    void onBrowserUsed(ClipboardBrowserPlaceholder *placeholder);
+    void unloadTabsOverLimit();
+    void startPreloading();
+    void onItemFileRead(const QString &tabName, const PreloadedItems &items);
+    void dropPreloadedItems();
+
+private:
+    void removeDeletedTabs();
+    qint64 loadedTabsMemoryUsage() const;
+
+    QList< QPointer<ClipboardBrowserPlaceholder> > m_tabs;
+    qint64 m_memoryLimit = 0;
+    QTimer m_timerUnloadTabs;
+
+    QHash<QString, int> m_tabUseCounts;
+    QTimer m_timerSaveTabUseCounts;
+    bool m_tabUseCountsChanged = false;
+    QTimer m_timerPreload;
+    QTimer m_timerDropPreloadedItems;
+    int m_maxItems = 0;
+    QPointer<QThread> m_preloadThread;
+};
+
+#endif // TABRESIDENCYMANAGER_H
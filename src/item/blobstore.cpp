@@ -0,0 +1,620 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "blobstore.h"
+
+#include "common/atomicfile.h"
+#include "common/config.h"
+#include "common/log.h"
+#include "common/mimetypes.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QTemporaryFile>
+
+namespace {
+
+/// Smaller data are stored in tab files.
+const int minBlobSize = 16 * 1024;
+
+const char referencesFileName[] = "references.dat";
+
+/// Owner of stored data which are not saved in any tab yet (tab names are never empty).
+const QString unsavedOwner;
+
+/// Prefix for files with data being written (see BlobWriter).
+const char partialFilePrefix[] = "partial-";
+
+QByteArray blobDigest(const QByteArray &bytes)
+{
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex();
+}
+
+bool isValidDigest(const QByteArray &digest)
+{
+    static const QRegExp re("[0-9a-f]{40}");
+    return re.exactMatch( QString::fromLatin1(digest) );
+}
+
+bool writeFileSafely(const QString &fileName, const QByteArray &bytes)
+{
+    QString error;
+    if ( !writeFileAtomically(fileName, bytes, &error) ) {
+        log( QString("Failed to write \"%1\": %2").arg(fileName, error), LogError );
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+BlobStore *BlobStore::instance()
+{
+    static BlobStore store( getConfigurationFilePath("_blobs") );
+    return &store;
+}
+
+BlobStore::BlobStore(const QString &path)
+    : m_path(path)
+{
+}
+
+QByteArray BlobStore::addBlob(const QByteArray &bytes)
+{
+    if (bytes.size() < minBlobSize)
+        return QByteArray();
+
+    // Avoid calculating digest again for data already in store.
+    QByteArray digest = m_digests.value( bytes.constData() );
+    if ( digest.isEmpty() || m_blobs.value(digest).constData() != bytes.constData() )
+        digest = blobDigest(bytes);
+
+    // Files exist for all referenced data.
+    if ( !isReferenced(digest) && !QFile::exists(blobFilePath(digest)) ) {
+        if ( !writeBlob(digest, bytes) )
+            return QByteArray();
+    }
+
+    if ( !m_blobs.contains(digest) )
+        cacheBlob(digest, bytes);
+
+    return digest;
+}
+
+bool BlobStore::blob(const QByteArray &digest, QByteArray *bytes)
+{
+    const auto it = m_blobs.constFind(digest);
+    if ( it != m_blobs.constEnd() ) {
+        *bytes = it.value();
+        return true;
+    }
+
+    if ( !readBlob(digest, bytes) )
+        return false;
+
+    cacheBlob(digest, *bytes);
+    return true;
+}
+
+void BlobStore::keepBlob(const QByteArray &digest, const QByteArray &bytes)
+{
+    if ( !m_blobs.contains(digest) )
+        cacheBlob(digest, bytes);
+}
+
+QByteArray BlobStore::storeBlob(const QByteArray &bytes)
+{
+    const QByteArray digest = blobDigest(bytes);
+    if ( !QFile::exists(blobFilePath(digest)) && !writeBlob(digest, bytes) )
+        return QByteArray();
+
+    addUnsavedReference(digest);
+    return digest;
+}
+
+void BlobStore::storeDataFiles(QVariantMap *data)
+{
+    if ( !data->contains(mimeDataFiles) )
+        return;
+
+    const QByteArray files = data->value(mimeDataFiles).toByteArray();
+    QByteArray newFiles;
+    for ( const auto &line : files.split('\n') ) {
+        const int i = line.indexOf('\t');
+        if (i == -1)
+            continue;
+
+        const QString format = QString::fromUtf8( line.left(i) );
+        QByteArray digest = line.mid(i + 1);
+        if ( digest.isEmpty() ) {
+            digest = storeBlob( data->value(format).toByteArray() );
+            if ( digest.isEmpty() )
+                continue;
+            data->remove(format);
+        }
+
+        newFiles.append( line.left(i) + '\t' + digest + '\n' );
+    }
+
+    if ( newFiles.isEmpty() )
+        data->remove(mimeDataFiles);
+    else
+        data->insert(mimeDataFiles, newFiles);
+}
+
+void BlobStore::loadDataFiles(QVariantMap *data) const
+{
+    if ( !data->contains(mimeDataFiles) )
+        return;
+
+    const QByteArray files = data->value(mimeDataFiles).toByteArray();
+    for ( const auto &line : files.split('\n') ) {
+        const int i = line.indexOf('\t');
+        if (i == -1)
+            continue;
+
+        const QString format = QString::fromUtf8( line.left(i) );
+        if ( data->contains(format) )
+            continue;
+
+        // Only data in the store can be loaded (digest is validated).
+        QByteArray bytes;
+        if ( readBlob(line.mid(i + 1), &bytes) )
+            data->insert(format, bytes);
+    }
+}
+
+void BlobStore::removeUnsavedReferences()
+{
+    setReferences( unsavedOwner, QSet<QByteArray>() );
+
+    // Remove data which were being written when the application exited.
+    QDir dir(m_path);
+    for ( const auto &fileName : dir.entryList(QStringList(QString(partialFilePrefix) + "*"), QDir::Files) )
+        dir.remove(fileName);
+}
+
+bool BlobStore::readBlob(const QByteArray &digest, QByteArray *bytes) const
+{
+    if ( !isValidDigest(digest) ) {
+        log( QString("Invalid data digest \"%1\"").arg(QString::fromLatin1(digest)), LogError );
+        return false;
+    }
+
+    QFile file( blobFilePath(digest) );
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        log( QString("Failed to read \"%1\": %2")
+             .arg(file.fileName(), file.errorString()), LogError );
+        return false;
+    }
+
+    const QByteArray fileBytes = file.readAll();
+    if ( blobDigest(fileBytes) != digest ) {
+        log( QString("Data in \"%1\" are corrupted").arg(file.fileName()), LogError );
+        return false;
+    }
+
+    *bytes = fileBytes;
+    return true;
+}
+
+void BlobStore::setReferences(const QString &owner, const QSet<QByteArray> &digests)
+{
+    clearPendingReferences(owner);
+    replaceReferences(owner, digests);
+}
+
+void BlobStore::addPendingReferences(const QString &owner, const QSet<QByteArray> &digests)
+{
+    loadReferences();
+
+    if ( !m_pendingReferences.contains(owner) )
+        m_savedReferences.insert( owner, m_references.value(owner) );
+
+    const int id = ++m_lastPendingReferencesId;
+    m_pendingReferences[owner].append( PendingReferences{id, digests} );
+    m_newPendingReferencesIds.insert(owner, id);
+
+    updateReferences(owner);
+}
+
+int BlobStore::takePendingReferencesId(const QString &owner)
+{
+    return m_newPendingReferencesIds.take(owner);
+}
+
+void BlobStore::finishPendingReferences(const QString &owner, int id, bool saved)
+{
+    const auto it = m_pendingReferences.find(owner);
+    if ( it == m_pendingReferences.end() )
+        return;
+
+    auto &pending = it.value();
+    int i = 0;
+    while ( i < pending.size() && pending[i].id != id )
+        ++i;
+
+    // References were replaced in the meantime.
+    if ( i == pending.size() )
+        return;
+
+    // Older pending references belong to writes which were replaced or failed.
+    if (saved) {
+        m_savedReferences[owner] = pending[i].digests;
+        pending.erase( pending.begin(), pending.begin() + i + 1 );
+    } else {
+        pending.remove(i);
+    }
+
+    updateReferences(owner);
+
+    if ( pending.isEmpty() )
+        clearPendingReferences(owner);
+}
+
+void BlobStore::replaceReferences(const QString &owner, const QSet<QByteArray> &digests)
+{
+    loadReferences();
+
+    const QSet<QByteArray> oldDigests = m_references.value(owner);
+    if (digests.isEmpty())
+        m_references.remove(owner);
+    else
+        m_references.insert(owner, digests);
+
+    if (oldDigests != digests)
+        saveReferences();
+
+    collectGarbage(oldDigests);
+    releaseUnusedBlobs();
+}
+
+void BlobStore::updateReferences(const QString &owner)
+{
+    QSet<QByteArray> digests = m_savedReferences.value(owner);
+    for ( const auto &pending : m_pendingReferences.value(owner) )
+        digests.unite(pending.digests);
+
+    replaceReferences(owner, digests);
+}
+
+void BlobStore::clearPendingReferences(const QString &owner)
+{
+    m_savedReferences.remove(owner);
+    m_pendingReferences.remove(owner);
+    m_newPendingReferencesIds.remove(owner);
+}
+
+void BlobStore::moveReferences(const QString &oldOwner, const QString &newOwner)
+{
+    loadReferences();
+
+    if ( oldOwner == newOwner || !m_references.contains(oldOwner) )
+        return;
+
+    // Keep all references (including pending) with the new owner.
+    clearPendingReferences(oldOwner);
+    clearPendingReferences(newOwner);
+
+    const QSet<QByteArray> oldDigests = m_references.value(newOwner);
+    m_references.insert( newOwner, m_references.take(oldOwner) );
+    saveReferences();
+
+    collectGarbage(oldDigests);
+}
+
+void BlobStore::removeReferences(const QString &owner)
+{
+    setReferences(owner, QSet<QByteArray>());
+}
+
+QString BlobStore::blobFilePath(const QByteArray &digest) const
+{
+    return m_path + '/' + QString::fromLatin1(digest);
+}
+
+bool BlobStore::isReferenced(const QByteArray &digest) const
+{
+    for (const auto &digests : m_references) {
+        if ( digests.contains(digest) )
+            return true;
+    }
+
+    return false;
+}
+
+bool BlobStore::writeBlob(const QByteArray &digest, const QByteArray &bytes)
+{
+    if ( !QDir(m_path).mkpath(".") ) {
+        log( QString("Failed to create directory \"%1\"").arg(m_path), LogError );
+        return false;
+    }
+
+    return writeFileSafely( blobFilePath(digest), bytes );
+}
+
+bool BlobStore::moveBlobFile(QTemporaryFile *file, const QByteArray &digest, const QByteArray &bytes)
+{
+    // Same data can be already stored.
+    const QString fileName = blobFilePath(digest);
+    if ( !QFile::exists(fileName) ) {
+        file->setAutoRemove(false);
+        if ( !file->rename(fileName) ) {
+            log( QString("Failed to write \"%1\": %2").arg(fileName, file->errorString()), LogError );
+            file->setAutoRemove(true);
+            return false;
+        }
+    }
+
+    addUnsavedReference(digest);
+    keepBlob(digest, bytes);
+    return true;
+}
+
+void BlobStore::addUnsavedReference(const QByteArray &digest)
+{
+    // Keep data for items which were not saved yet.
+    loadReferences();
+    auto &digests = m_references[unsavedOwner];
+    if ( !digests.contains(digest) ) {
+        digests.insert(digest);
+        saveReferences();
+    }
+}
+
+void BlobStore::cacheBlob(const QByteArray &digest, const QByteArray &bytes)
+{
+    m_blobs.insert(digest, bytes);
+    m_digests.insert(bytes.constData(), digest);
+}
+
+void BlobStore::collectGarbage(const QSet<QByteArray> &digests)
+{
+    for (const auto &digest : digests) {
+        if ( isReferenced(digest) )
+            continue;
+
+        COPYQ_LOG_VERBOSE( QString("Removing unreferenced data %1").arg(QString::fromLatin1(digest)) );
+        QFile::remove( blobFilePath(digest) );
+
+        const auto it = m_blobs.find(digest);
+        if ( it != m_blobs.end() ) {
+            m_digests.remove( it.value().constData() );
+            m_blobs.erase(it);
+        }
+    }
+}
+
+void BlobStore::releaseUnusedBlobs()
+{
+    for (auto it = m_blobs.begin(); it != m_blobs.end(); ) {
+        if ( it.value().isDetached() ) {
+            m_digests.remove( it.value().constData() );
+            it = m_blobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BlobStore::loadReferences()
+{
+    if (m_referencesLoaded)
+        return;
+
+    m_referencesLoaded = true;
+
+    QFile file(m_path + '/' + referencesFileName);
+    if ( !file.exists() )
+        return;
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        log( QString("Failed to read \"%1\": %2")
+             .arg(file.fileName(), file.errorString()), LogError );
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream >> m_references;
+    if ( stream.status() != QDataStream::Ok ) {
+        log( QString("Data references in \"%1\" are corrupted").arg(file.fileName()), LogError );
+        m_references.clear();
+    }
+}
+
+void BlobStore::saveReferences()
+{
+    if ( !QDir(m_path).mkpath(".") ) {
+        log( QString("Failed to create directory \"%1\"").arg(m_path), LogError );
+        return;
+    }
+
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_4_7);
+        stream << m_references;
+    }
+
+    writeFileSafely(m_path + '/' + referencesFileName, bytes);
+}
+
+TabBlobReferences::TabBlobReferences(BlobStore *store)
+    : m_store(store)
+{
+}
+
+QByteArray TabBlobReferences::addBlob(const QByteArray &bytes)
+{
+    const QByteArray digest = m_store->addBlob(bytes);
+    if ( !digest.isEmpty() )
+        m_digests.insert(digest);
+    return digest;
+}
+
+bool TabBlobReferences::blob(const QByteArray &digest, QByteArray *bytes)
+{
+    if ( !m_store->blob(digest, bytes) )
+        return false;
+
+    m_digests.insert(digest);
+    return true;
+}
+
+void TabBlobReferences::addBlobReference(const QByteArray &digest)
+{
+    // Digest is used as file name so it must not be arbitrary.
+    if ( isValidDigest(digest) )
+        m_digests.insert(digest);
+}
+
+void TabBlobReferences::commit(const QString &tabName)
+{
+    m_store->setReferences(tabName, m_digests);
+}
+
+void TabBlobReferences::commitWhenSaved(const QString &tabName)
+{
+    m_store->addPendingReferences(tabName, m_digests);
+}
+
+BlobWriter::BlobWriter(BlobStore *store)
+    : m_store(store)
+{
+}
+
+BlobWriter::~BlobWriter() = default;
+
+void BlobWriter::append(const QByteArray &chunk)
+{
+    if (m_file) {
+        writeToFile(chunk);
+        return;
+    }
+
+    m_bytes.append(chunk);
+    if ( m_bytes.size() >= minBlobSize && openFile() ) {
+        writeToFile(m_bytes);
+        m_bytes.clear();
+    }
+}
+
+bool BlobWriter::take(QByteArray *bytes)
+{
+    if (!m_file) {
+        bytes->swap(m_bytes);
+        return true;
+    }
+
+    if (m_failed)
+        return false;
+
+    const qint64 size = m_file->size();
+    if ( !m_file->flush() || !m_file->seek(0) ) {
+        log( QString("Failed to write \"%1\": %2").arg(m_file->fileName(), m_file->errorString()), LogError );
+        return false;
+    }
+
+    *bytes = m_file->readAll();
+    if (bytes->size() != size) {
+        log( QString("Failed to read \"%1\": %2").arg(m_file->fileName(), m_file->errorString()), LogError );
+        bytes->clear();
+        return false;
+    }
+
+    const QByteArray digest = m_hash->result().toHex();
+    m_file->close();
+    return m_store->moveBlobFile( m_file.get(), digest, *bytes );
+}
+
+bool BlobWriter::openFile()
+{
+    if ( !QDir(m_store->path()).mkpath(".") ) {
+        log( QString("Failed to create directory \"%1\"").arg(m_store->path()), LogError );
+        return false;
+    }
+
+    std::unique_ptr<QTemporaryFile> file(
+                new QTemporaryFile(m_store->path() + '/' + partialFilePrefix + "XXXXXX") );
+    if ( !file->open() ) {
+        log( QString("Failed to create \"%1\": %2").arg(file->fileTemplate(), file->errorString()), LogError );
+        return false;
+    }
+
+    m_file = std::move(file);
+    m_hash.reset( new QCryptographicHash(QCryptographicHash::Sha1) );
+    return true;
+}
+
+void BlobWriter::writeToFile(const QByteArray &bytes)
+{
+    if (m_failed)
+        return;
+
+    m_hash->addData(bytes);
+    if ( m_file->write(bytes) != bytes.size() ) {
+        log( QString("Failed to write \"%1\": %2").arg(m_file->fileName(), m_file->errorString()), LogError );
+        m_failed = true;
+    }
+}
+
+BlobReader::BlobReader(const BlobStore *store, qint64 maxBytes)
+    : m_store(store)
+    , m_maxBytes(maxBytes)
+{
+}
+
+QByteArray BlobReader::addBlob(const QByteArray &)
+{
+    return QByteArray();
+}
+
+bool BlobReader::blob(const QByteArray &digest, QByteArray *bytes)
+{
+    const auto it = m_blobs.constFind(digest);
+    if ( it != m_blobs.constEnd() ) {
+        *bytes = it.value();
+        return true;
+    }
+
+    // Skipping is not an error but the items cannot be used then.
+    if ( m_maxBytes >= 0 && m_bytes >= m_maxBytes ) {
+        m_skipped = true;
+        return true;
+    }
+
+    if ( !m_store->readBlob(digest, bytes) )
+        return false;
+
+    m_bytes += bytes->size();
+    m_blobs.insert(digest, *bytes);
+    m_references.insert(digest);
+    return true;
+}
+
+void BlobReader::addBlobReference(const QByteArray &digest)
+{
+    if ( isValidDigest(digest) )
+        m_references.insert(digest);
+}
@@ -0,0 +1,258 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include "item/serialize.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class QCryptographicHash;
+class QTemporaryFile;
+
+/**
+ * Content-addressed storage for big item data.
+ *
+ * Each unique data is stored in a single file named by SHA-1 digest of its
+ * content and kept in memory only once for all loaded items.
+ *
+ * Tabs (owners) reference the stored data. A file is removed when the last
+ * reference to it is dropped (tab saved without the data or removed).
+ * References are persisted with the files so that data for tabs which
+ * are not loaded are kept.
+ */
+class BlobStore final
+{
+public:
+    /// Store in application configuration directory.
+    static BlobStore *instance();
+
+    explicit BlobStore(const QString &path);
+
+    /**
+     * Store data if big enough and return digest.
+     *
+     * Digest is not calculated again for data returned by blob()
+     * or previously passed to addBlob().
+     */
+    QByteArray addBlob(const QByteArray &bytes);
+
+    /// Load data (data in memory are shared with other items).
+    bool blob(const QByteArray &digest, QByteArray *bytes);
+
+    /**
+     * Store data of any size without keeping them in memory and return digest.
+     *
+     * Data are kept until the application exits even if no tab references
+     * them (see TabBlobReferences::addBlobReference() and removeUnsavedReferences()).
+     */
+    QByteArray storeBlob(const QByteArray &bytes);
+
+    /**
+     * Store data which are over the clipboard data limit with "file" policy.
+     *
+     * Data of formats listed in mimeDataFiles without digest are stored and
+     * replaced by the digest (see applyClipboardDataLimits()).
+     */
+    void storeDataFiles(QVariantMap *data);
+
+    /// Load data stored with storeDataFiles() (only from the store).
+    void loadDataFiles(QVariantMap *data) const;
+
+    /// Remove data stored with storeBlob() in last session which no tab references.
+    void removeUnsavedReferences();
+
+    /// Load data without keeping them in memory (can be called from other thread).
+    bool readBlob(const QByteArray &digest, QByteArray *bytes) const;
+
+    /// Keep data loaded with readBlob() in memory until no item uses them.
+    void keepBlob(const QByteArray &digest, const QByteArray &bytes);
+
+    /// Replace references of owner and remove unreferenced data.
+    void setReferences(const QString &owner, const QSet<QByteArray> &digests);
+
+    /**
+     * Add references of owner whose data are being saved.
+     *
+     * References of last saved data are kept until finishPendingReferences()
+     * is called so no data used by saved owner are removed before new owner
+     * data are written.
+     */
+    void addPendingReferences(const QString &owner, const QSet<QByteArray> &digests);
+
+    /// Return ID of references last added for owner (or 0) and forget it.
+    int takePendingReferencesId(const QString &owner);
+
+    /**
+     * Replace references of owner with pending references with given ID
+     * if the owner data were saved, otherwise drop the pending references.
+     */
+    void finishPendingReferences(const QString &owner, int id, bool saved);
+
+    void moveReferences(const QString &oldOwner, const QString &newOwner);
+
+    void removeReferences(const QString &owner);
+
+    QString path() const { return m_path; }
+
+private:
+    friend class BlobWriter;
+
+    struct PendingReferences {
+        int id;
+        QSet<QByteArray> digests;
+    };
+
+    void replaceReferences(const QString &owner, const QSet<QByteArray> &digests);
+    void updateReferences(const QString &owner);
+    void clearPendingReferences(const QString &owner);
+    QString blobFilePath(const QByteArray &digest) const;
+    bool isReferenced(const QByteArray &digest) const;
+    bool writeBlob(const QByteArray &digest, const QByteArray &bytes);
+    bool moveBlobFile(QTemporaryFile *file, const QByteArray &digest, const QByteArray &bytes);
+    void addUnsavedReference(const QByteArray &digest);
+    void cacheBlob(const QByteArray &digest, const QByteArray &bytes);
+    void collectGarbage(const QSet<QByteArray> &digests);
+    void releaseUnusedBlobs();
+    void loadReferences();
+    void saveReferences();
+
+    QString m_path;
+    QMap<QString, QSet<QByteArray>> m_references;
+    bool m_referencesLoaded = false;
+
+    // References of owners with data being saved.
+    QHash<QString, QSet<QByteArray>> m_savedReferences;
+    QHash<QString, QVector<PendingReferences>> m_pendingReferences;
+    QHash<QString, int> m_newPendingReferencesIds;
+    int m_lastPendingReferencesId = 0;
+
+    // Data in memory are dropped once no item uses them.
+    QHash<QByteArray, QByteArray> m_blobs;
+    QHash<const char *, QByteArray> m_digests;
+};
+
+/**
+ * References to stored data collected while loading or saving a tab.
+ */
+class TabBlobReferences final : public ItemDataBlobs
+{
+public:
+    explicit TabBlobReferences(BlobStore *store);
+
+    QByteArray addBlob(const QByteArray &bytes) override;
+
+    bool blob(const QByteArray &digest, QByteArray *bytes) override;
+
+    void addBlobReference(const QByteArray &digest) override;
+
+    /// Set the collected references for tab.
+    void commit(const QString &tabName);
+
+    /// Set the collected references for tab once the tab is saved.
+    void commitWhenSaved(const QString &tabName);
+
+private:
+    BlobStore *m_store;
+    QSet<QByteArray> m_digests;
+};
+
+/**
+ * Writes data to the store in chunks (e.g. streamed standard input).
+ *
+ * Big data are written to a file in the store right away instead of being
+ * collected in memory.
+ */
+class BlobWriter final
+{
+public:
+    explicit BlobWriter(BlobStore *store);
+
+    ~BlobWriter();
+
+    void append(const QByteArray &chunk);
+
+    /**
+     * Finish writing and return the data or false on error.
+     *
+     * Big data are kept in the store as if stored with storeBlob().
+     */
+    bool take(QByteArray *bytes);
+
+    BlobWriter(const BlobWriter &) = delete;
+    BlobWriter &operator=(const BlobWriter &) = delete;
+
+private:
+    bool openFile();
+    void writeToFile(const QByteArray &bytes);
+
+    BlobStore *m_store;
+    QByteArray m_bytes;
+    std::unique_ptr<QTemporaryFile> m_file;
+    std::unique_ptr<QCryptographicHash> m_hash;
+    bool m_failed = false;
+};
+
+/**
+ * Reads stored data referenced by deserialized items without changing the store.
+ *
+ * This allows to read the data ahead in other thread.
+ */
+class BlobReader final : public ItemDataBlobs
+{
+public:
+    /// Stops reading after given number of bytes (if non-negative).
+    BlobReader(const BlobStore *store, qint64 maxBytes);
+
+    QByteArray addBlob(const QByteArray &bytes) override;
+
+    bool blob(const QByteArray &digest, QByteArray *bytes) override;
+
+    void addBlobReference(const QByteArray &digest) override;
+
+    /// Return read data by digest.
+    const QHash<QByteArray, QByteArray> &blobs() const { return m_blobs; }
+
+    /// Return size of read data.
+    qint64 bytes() const { return m_bytes; }
+
+    /// Return digests of all data referenced by items.
+    const QSet<QByteArray> &references() const { return m_references; }
+
+    /// Return true if some data were not read because of the limit.
+    bool hasSkippedBlobs() const { return m_skipped; }
+
+private:
+    const BlobStore *m_store;
+    qint64 m_maxBytes;
+    qint64 m_bytes = 0;
+    QHash<QByteArray, QByteArray> m_blobs;
+    QSet<QByteArray> m_references;
+    bool m_skipped = false;
+};
+
+#endif // BLOBSTORE_H
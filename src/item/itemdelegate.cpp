@@ -170,6 +170,16 @@ bool ItemDelegate::hasCache(const QModelIndex &index) const
     return cacheOrNull(row) != nullptr;
 }
 
+int ItemDelegate::cachedItemCount() const
+{
+    int count = 0;
+    for (const auto &w : m_cache) {
+        if (w)
+            ++count;
+    }
+    return count;
+}
+
 void ItemDelegate::setItemSizes(QSize size, int idealWidth)
 {
     const auto margins = m_sharedData->theme.margins();
@@ -208,7 +218,8 @@ ItemEditorWidget *ItemDelegate::createCustomEditor(
 {
     cache(index);
     const int row = index.row();
-    auto editor = new ItemEditorWidget(m_cache[row], index, editNotes, parent);
+    auto editor = new ItemEditorWidget(
+                m_cache[row], index, editNotes, m_sharedData->pagedEditorThreshold, parent);
     editor->setEditorPalette( m_sharedData->theme.editorPalette() );
     editor->setEditorFont( m_sharedData->theme.editorFont() );
     editor->setSaveOnReturnKey(m_sharedData->saveOnReturnKey);
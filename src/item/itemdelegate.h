@@ -88,6 +88,9 @@ class ItemDelegate : public QItemDelegate
         /** Return true only if item at index is already in cache. */
         bool hasCache(const QModelIndex &index) const;
 
+        /** Return number of cached items. */
+        int cachedItemCount() const;
+
         /** Set maximum size for all items. */
         void setItemSizes(QSize size, int idealWidth);
 
@@ -20,7 +20,9 @@
 #include "item/itemeditorwidget.h"
 
 #include "common/contenttype.h"
+#include "common/mimetypes.h"
 #include "item/itemwidget.h"
+#include "item/pagedtexteditor.h"
 
 #include "gui/iconfactory.h"
 #include "gui/icons.h"
@@ -62,17 +64,28 @@ const QIcon iconSearch() { return getIcon("edit-find", IconSearch); }
 
 ItemEditorWidget::ItemEditorWidget(
         const std::shared_ptr<ItemWidget> &itemWidget,
-        const QModelIndex &index, bool editNotes, QWidget *parent)
+        const QModelIndex &index, bool editNotes,
+        int pagedEditorThreshold, QWidget *parent)
     : QWidget(parent)
     , m_itemWidget(itemWidget)
     , m_index(index)
     , m_editor(nullptr)
     , m_noteEditor(nullptr)
+    , m_pagedEditor(nullptr)
     , m_toolBar(nullptr)
     , m_saveOnReturnKey(false)
 {
+    if (!editNotes) {
+        // Avoid decoding whole big text and creating huge text document.
+        const QByteArray text = index.data(contentType::data).toMap().value(mimeText).toByteArray();
+        if (text.size() > pagedEditorThreshold)
+            m_pagedEditor = new PagedTextEditor(text, this);
+    }
+
     m_noteEditor = editNotes ? new QPlainTextEdit(parent) : nullptr;
-    QWidget *editor = editNotes ? m_noteEditor : createEditor();
+    QWidget *editor = editNotes ? m_noteEditor
+                    : m_pagedEditor ? m_pagedEditor
+                    : createEditor();
 
     if (editor == nullptr) {
         m_itemWidget = nullptr;
@@ -80,6 +93,8 @@ ItemEditorWidget::ItemEditorWidget(
         initEditor(editor);
         if (m_noteEditor != nullptr)
             m_noteEditor->setPlainText( index.data(contentType::notes).toString() );
+        else if (m_pagedEditor != nullptr)
+            m_pagedEditor->textEdit()->installEventFilter(this);
         else
             itemWidget->setEditorData(editor, index);
     }
@@ -98,6 +113,15 @@ void ItemEditorWidget::commitData(QAbstractItemModel *model) const
         if (m_noteEditor != nullptr) {
             model->setData(m_index, m_noteEditor->toPlainText(), contentType::notes);
             m_noteEditor->document()->setModified(false);
+        } else if (m_pagedEditor != nullptr) {
+            // Clear text.
+            model->setData(m_index, QString());
+
+            QVariantMap data;
+            data[mimeText] = m_pagedEditor->text();
+            model->setData(m_index, data, contentType::updateData);
+
+            m_pagedEditor->setModified(false);
         } else {
             m_itemWidget->setModelData(m_editor, model, m_index);
         }
@@ -110,6 +134,8 @@ bool ItemEditorWidget::hasChanges() const
         return false;
     if (m_noteEditor != nullptr)
         return m_noteEditor->document()->isModified();
+    if (m_pagedEditor != nullptr)
+        return m_pagedEditor->hasChanges();
     return m_itemWidget != nullptr && m_itemWidget->hasChanges(m_editor);
 }
 
@@ -158,7 +184,9 @@ void ItemEditorWidget::findPrevious(const QRegExp &re)
 
 bool ItemEditorWidget::eventFilter(QObject *object, QEvent *event)
 {
-    if ( object == m_editor && event->type() == QEvent::KeyPress ) {
+    const bool isEditor = object == m_editor
+            || (m_pagedEditor != nullptr && object == m_pagedEditor->textEdit());
+    if ( isEditor && event->type() == QEvent::KeyPress ) {
         QKeyEvent *keyevent = static_cast<QKeyEvent *>(event);
         int k = keyevent->key();
 
@@ -420,6 +448,11 @@ void ItemEditorWidget::search(const QRegExp &re, bool backwards)
     if ( !re.isValid() )
         return;
 
+    if (m_pagedEditor != nullptr) {
+        m_pagedEditor->search(re, backwards);
+        return;
+    }
+
     auto tc = textCursor();
     if ( tc.isNull() )
         return;
@@ -27,6 +27,7 @@
 #include <memory>
 
 class ItemWidget;
+class PagedTextEditor;
 class QAbstractItemModel;
 class QPlainTextEdit;
 class QTextCursor;
@@ -40,9 +41,15 @@ class ItemEditorWidget : public QWidget
 {
     Q_OBJECT
 public:
+    /**
+     * Creates editor for item or its notes.
+     *
+     * Text bigger than @a pagedEditorThreshold bytes is edited in pages.
+     */
     ItemEditorWidget(
             const std::shared_ptr<ItemWidget> &itemWidget,
-            const QModelIndex &index, bool editNotes, QWidget *parent = nullptr);
+            const QModelIndex &index, bool editNotes,
+            int pagedEditorThreshold, QWidget *parent = nullptr);
 
     bool isValid() const;
 
@@ -103,6 +110,7 @@ private:
     QPersistentModelIndex m_index;
     QWidget *m_editor;
     QPlainTextEdit *m_noteEditor;
+    PagedTextEditor *m_pagedEditor;
     QToolBar *m_toolBar;
     bool m_saveOnReturnKey;
 };
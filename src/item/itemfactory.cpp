@@ -26,6 +26,7 @@
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "item/blobstore.h"
 #include "item/itemstore.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
@@ -168,9 +169,15 @@ private:
 class DummySaver : public ItemSaverInterface
 {
 public:
-    bool saveItems(const QString & /* tabName */, const QAbstractItemModel &model, QIODevice *file) override
+    bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file) override
     {
-        return serializeData(model, file);
+        TabBlobReferences blobs( BlobStore::instance() );
+        if ( !serializeData(model, file, &blobs) )
+            return false;
+
+        // Data used by previously saved items are kept until the items are written.
+        blobs.commitWhenSaved(tabName);
+        return true;
     }
 };
 
@@ -191,13 +198,25 @@ public:
 
     bool canSaveItems(const QString &) const override { return true; }
 
-    ItemSaverPtr loadItems(const QString &, QAbstractItemModel *model, QIODevice *file, int maxItems) override
+    ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel *model, QIODevice *file, int maxItems) override
     {
         if ( file->size() > 0 ) {
-            if ( !deserializeData(model, file, maxItems) ) {
+            TabBlobReferences blobs( BlobStore::instance() );
+            QVector<QVariantMap> items;
+            QSet<QByteArray> blobReferences;
+            if ( takeDeserializedItems(tabName, &items, &blobReferences) ) {
+                const int count = qMin( items.size(), maxItems );
+                if ( count > 0 && !model->insertRows(0, count) )
+                    return nullptr;
+                for (int i = 0; i < count; ++i)
+                    model->setData( model->index(i, 0), items[i], contentType::data );
+                for (const auto &digest : blobReferences)
+                    blobs.addBlobReference(digest);
+            } else if ( !deserializeData(model, file, maxItems, &blobs) ) {
                 model->removeRows(0, model->rowCount());
                 return nullptr;
             }
+            blobs.commit(tabName);
         }
 
         return std::make_shared<DummySaver>();
@@ -426,6 +445,18 @@ bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re) const
     return false;
 }
 
+QVariant ItemFactory::queryTab(
+        const QString &loaderId, const QAbstractItemModel &model,
+        const QString &query, const QVariantList &arguments) const
+{
+    for ( const auto &loader : enabledLoaders() ) {
+        if ( loader->id() == loaderId )
+            return loader->queryTab(model, query, arguments);
+    }
+
+    return QVariant();
+}
+
 QList<ItemScriptable*> ItemFactory::scriptableObjects() const
 {
     QList<ItemScriptable*> scriptables;
@@ -130,6 +130,13 @@ public:
      */
     bool matches(const QModelIndex &index, const QRegExp &re) const;
 
+    /**
+     * Pass query to enabled plugin with given ID (see ItemLoaderInterface::queryTab()).
+     */
+    QVariant queryTab(
+            const QString &loaderId, const QAbstractItemModel &model,
+            const QString &query, const QVariantList &arguments) const;
+
     QList<ItemScriptable*> scriptableObjects() const;
 
     /**
@@ -19,23 +19,69 @@
 
 #include "itemstore.h"
 
+#include "common/atomicfile.h"
 #include "common/config.h"
+#include "common/contenttype.h"
 #include "common/log.h"
 #include "common/textdata.h"
+#include "item/blobstore.h"
 #include "item/itemfactory.h"
+#include "item/serialize.h"
 
 #include <QAbstractItemModel>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QEvent>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <cstdlib>
+#include <functional>
 
 namespace {
 
-/// @return File name for data file with items.
-QString itemFileName(const QString &id)
+QHash<QString, PreloadedItems> &preloadedItems()
 {
-    QString part( id.toUtf8().toBase64() );
-    part.replace( QChar('/'), QString('-') );
-    return getConfigurationFilePath("_tab_") + part + QString(".dat");
+    static QHash<QString, PreloadedItems> items;
+    return items;
+}
+
+/// Items deserialized in advance for tabs being currently loaded.
+QHash<QString, PreloadedItems> &deserializedItems()
+{
+    static QHash<QString, PreloadedItems> items;
+    return items;
+}
+
+/// Take preloaded file content if the file didn't change since.
+bool takePreloadedItems(const QString &tabName, const QString &tabFileName, PreloadedItems *preloaded)
+{
+    const auto it = preloadedItems().find(tabName);
+    if ( it == preloadedItems().end() )
+        return false;
+
+    const PreloadedItems items = it.value();
+    preloadedItems().erase(it);
+
+    const QFileInfo info(tabFileName);
+    if ( info.lastModified() != items.lastModified || info.size() != items.bytes.size() )
+        return false;
+
+    *preloaded = items;
+
+    // Avoid reading the stored data again while loading the items.
+    for (auto it = items.blobs.constBegin(); it != items.blobs.constEnd(); ++it)
+        BlobStore::instance()->keepBlob( it.key(), it.value() );
+
+    return true;
 }
 
 bool createItemDirectory()
@@ -63,14 +109,176 @@ void printItemFileError(
          , LogError );
 }
 
-void printSaveItemFileError(const QString &id, const QString &fileName, const QFile &file)
+void printLoadItemFileError(const QString &id, const QString &fileName, const QFile &file)
 {
-    printItemFileError("save", id, fileName, file);
+    printItemFileError("load", id, fileName, file);
 }
 
-void printLoadItemFileError(const QString &id, const QString &fileName, const QFile &file)
+#ifdef HAS_TESTS
+int itemFileWriteCrashAfterBytes = -1;
+#endif
+
+struct ItemFileWrite {
+    QString tabName;
+    QString fileName;
+    QByteArray bytes;
+    /// Called in main thread after the file is written or the write failed or was replaced.
+    std::function<void(bool)> written;
+#ifdef HAS_TESTS
+    int crashAfterBytes;
+#endif
+};
+
+bool writeItemFile(const ItemFileWrite &fileWrite)
 {
-    printItemFileError("load", id, fileName, file);
+    QString error;
+#ifdef HAS_TESTS
+    if (fileWrite.crashAfterBytes >= 0) {
+        // Leave partially written temporary file behind and exit immediately.
+        QFile tmpFile(fileWrite.fileName + ".tmp");
+        if ( tmpFile.open(QIODevice::WriteOnly) ) {
+            tmpFile.write( fileWrite.bytes.left(fileWrite.crashAfterBytes) );
+            tmpFile.flush();
+        }
+        log( QString("Simulated crash while saving tab %1").arg(quoteString(fileWrite.tabName)), LogWarning );
+        std::_Exit(1);
+    }
+#endif
+
+    if ( writeFileAtomically(fileWrite.fileName, fileWrite.bytes, &error) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Items saved").arg(fileWrite.tabName) );
+        return true;
+    }
+
+    log( QString("Cannot save tab %1 to %2 (%3)!")
+         .arg(quoteString(fileWrite.tabName),
+              quoteString(fileWrite.fileName),
+              error)
+         , LogError );
+    return false;
+}
+
+class ItemFileWrittenEvent final : public QEvent
+{
+public:
+    ItemFileWrittenEvent(const std::function<void(bool)> &written, bool saved)
+        : QEvent(QEvent::User)
+        , m_written(written)
+        , m_saved(saved)
+    {
+    }
+
+    void notify() { m_written(m_saved); }
+
+private:
+    std::function<void(bool)> m_written;
+    bool m_saved;
+};
+
+/**
+ * Writes item files in order in a background thread.
+ *
+ * Content waiting to be written is replaced with newer content for the same file.
+ */
+class ItemFileWriter final : public QThread
+{
+public:
+    explicit ItemFileWriter(QObject *parent)
+        : QThread(parent)
+    {
+        start();
+    }
+
+    ~ItemFileWriter()
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_stopped = true;
+            m_fileWriteAdded.wakeOne();
+        }
+        wait();
+    }
+
+    void write(const ItemFileWrite &fileWrite)
+    {
+        QMutexLocker lock(&m_mutex);
+
+        for (auto &pending : m_pending) {
+            if (pending.fileName == fileWrite.fileName) {
+                notifyWritten(pending, false);
+                pending = fileWrite;
+                return;
+            }
+        }
+
+        m_pending.append(fileWrite);
+        m_fileWriteAdded.wakeOne();
+    }
+
+    void waitForFinished()
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            while ( !m_pending.isEmpty() || m_writing )
+                m_allWritten.wait(&m_mutex);
+        }
+
+        // Finish pending writes now instead of later in event loop.
+        QCoreApplication::sendPostedEvents(this, QEvent::User);
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker lock(&m_mutex);
+        for (;;) {
+            while ( m_pending.isEmpty() && !m_stopped )
+                m_fileWriteAdded.wait(&m_mutex);
+
+            if ( m_pending.isEmpty() )
+                break;
+
+            const ItemFileWrite fileWrite = m_pending.takeFirst();
+            m_writing = true;
+            lock.unlock();
+
+            const bool saved = writeItemFile(fileWrite);
+            notifyWritten(fileWrite, saved);
+
+            lock.relock();
+            m_writing = false;
+            if ( m_pending.isEmpty() )
+                m_allWritten.wakeAll();
+        }
+    }
+
+    void customEvent(QEvent *event) override
+    {
+        if ( event->type() == QEvent::User )
+            static_cast<ItemFileWrittenEvent*>(event)->notify();
+    }
+
+private:
+    void notifyWritten(const ItemFileWrite &fileWrite, bool saved)
+    {
+        if (fileWrite.written)
+            QCoreApplication::postEvent( this, new ItemFileWrittenEvent(fileWrite.written, saved) );
+    }
+
+    QMutex m_mutex;
+    QWaitCondition m_fileWriteAdded;
+    QWaitCondition m_allWritten;
+    QList<ItemFileWrite> m_pending;
+    bool m_writing = false;
+    bool m_stopped = false;
+};
+
+ItemFileWriter *itemFileWriter()
+{
+    static QPointer<ItemFileWriter> writer;
+    if (!writer)
+        writer = new ItemFileWriter(qApp);
+    return writer;
 }
 
 ItemSaverPtr loadItems(
@@ -79,6 +287,19 @@ ItemSaverPtr loadItems(
 {
     COPYQ_LOG( QString("Tab \"%1\": Loading items").arg(tabName) );
 
+    PreloadedItems preloaded;
+    if ( takePreloadedItems(tabName, tabFileName, &preloaded) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Using preloaded items").arg(tabName) );
+        if (preloaded.deserialized)
+            deserializedItems().insert(tabName, preloaded);
+        QBuffer buffer(&preloaded.bytes);
+        buffer.open(QIODevice::ReadOnly);
+        auto saver = itemFactory->loadItems(tabName, &model, &buffer, maxItems);
+        // Items are not used if the file is loaded by a plugin.
+        deserializedItems().remove(tabName);
+        return saver;
+    }
+
     QFile tabFile(tabFileName);
     if ( !tabFile.open(QIODevice::ReadOnly) ) {
         printLoadItemFileError(tabName, tabFileName, tabFile);
@@ -107,11 +328,62 @@ ItemSaverPtr createTab(
 
 } // namespace
 
+QString itemFileName(const QString &id)
+{
+    QString part( id.toUtf8().toBase64() );
+    part.replace( QChar('/'), QString('-') );
+    return getConfigurationFilePath("_tab_") + part + QString(".dat");
+}
+
+void setPreloadedItems(const QString &tabName, const PreloadedItems &items)
+{
+    preloadedItems().insert(tabName, items);
+}
+
+bool hasPreloadedItems(const QString &tabName)
+{
+    return preloadedItems().contains(tabName);
+}
+
+qint64 preloadedItemsMemoryUsage()
+{
+    qint64 size = 0;
+    for (const auto &items : preloadedItems()) {
+        size += items.bytes.size();
+        for (const auto &bytes : items.blobs)
+            size += bytes.size();
+        // Deserialized items share stored data but copy the rest of the file.
+        if (items.deserialized)
+            size += items.bytes.size();
+    }
+    return size;
+}
+
+void clearPreloadedItems()
+{
+    preloadedItems().clear();
+}
+
+bool takeDeserializedItems(
+        const QString &tabName, QVector<QVariantMap> *items, QSet<QByteArray> *blobReferences)
+{
+    const auto it = deserializedItems().find(tabName);
+    if ( it == deserializedItems().end() )
+        return false;
+
+    *items = it.value().items;
+    *blobReferences = it.value().blobReferences;
+    deserializedItems().erase(it);
+    return true;
+}
+
 ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model, ItemFactory *itemFactory, int maxItems)
 {
     if ( !createItemDirectory() )
         return nullptr;
 
+    waitForSavedItems();
+
     const QString tabFileName = itemFileName(tabName);
 
     // If tab file doesn't exist, try to restore data from temporary file.
@@ -144,64 +416,94 @@ ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model, ItemFa
 bool saveItems(const QString &tabName, const QAbstractItemModel &model, const ItemSaverPtr &saver)
 {
     const QString tabFileName = itemFileName(tabName);
+    preloadedItems().remove(tabName);
 
     if ( !createItemDirectory() )
         return false;
 
-    // Save to temp file.
-    QFile tmpFile( tabFileName + ".tmp" );
-    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
-        printSaveItemFileError(tabName, tabFileName, tmpFile);
-        return false;
-    }
-
     COPYQ_LOG( QString("Tab \"%1\": Saving %2 items").arg(tabName).arg(model.rowCount()) );
 
-    if ( !saver->saveItems(tabName, model, &tmpFile) ) {
-        COPYQ_LOG( QString("Tab \"%1\": Failed to save items!").arg(tabName) );
-        return false;
+    // Serialize items now and write them to the file in background.
+    ItemFileWrite fileWrite;
+    fileWrite.tabName = tabName;
+    fileWrite.fileName = tabFileName;
+#ifdef HAS_TESTS
+    fileWrite.crashAfterBytes = itemFileWriteCrashAfterBytes;
+#endif
+    QBuffer buffer(&fileWrite.bytes);
+    buffer.open(QIODevice::WriteOnly);
+    const bool saved = saver->saveItems(tabName, model, &buffer);
+    buffer.close();
+
+    // Data referenced only by the old file content are removed after the file is replaced.
+    int referencesId = BlobStore::instance()->takePendingReferencesId(tabName);
+
+    // Plugins don't reference stored data so keep all data stored for items (see mimeDataFiles).
+    if (saved && referencesId == 0) {
+        TabBlobReferences blobs( BlobStore::instance() );
+        for (int row = 0; row < model.rowCount(); ++row)
+            addDataFileReferences( model.index(row, 0).data(contentType::data).toMap(), &blobs );
+        blobs.commitWhenSaved(tabName);
+        referencesId = BlobStore::instance()->takePendingReferencesId(tabName);
     }
 
-    // 1. Safely flush all data to temporary file.
-    tmpFile.flush();
-
-    // 2. Remove old tab file.
-    {
-        QFile oldTabFile(tabFileName);
-        if (oldTabFile.exists() && !oldTabFile.remove()) {
-            printSaveItemFileError(tabName, tabFileName, oldTabFile);
-            return false;
-        }
+    if (!saved) {
+        COPYQ_LOG( QString("Tab \"%1\": Failed to save items!").arg(tabName) );
+        if (referencesId != 0)
+            BlobStore::instance()->finishPendingReferences(tabName, referencesId, false);
+        return false;
     }
 
-    // 3. Overwrite previous file.
-    if ( !tmpFile.rename(tabFileName) ) {
-        printSaveItemFileError(tabName, tabFileName, tmpFile);
-        return false;
+    if (referencesId != 0) {
+        fileWrite.written = [tabName, referencesId](bool written) {
+            BlobStore::instance()->finishPendingReferences(tabName, referencesId, written);
+        };
     }
 
-    COPYQ_LOG( QString("Tab \"%1\": Items saved").arg(tabName) );
+    itemFileWriter()->write(fileWrite);
 
     return true;
 }
 
+void waitForSavedItems()
+{
+    itemFileWriter()->waitForFinished();
+}
+
 void removeItems(const QString &tabName)
 {
+    waitForSavedItems();
+
     const QString tabFileName = itemFileName(tabName);
     QFile::remove(tabFileName);
     QFile::remove(tabFileName + ".tmp");
+    preloadedItems().remove(tabName);
+    BlobStore::instance()->removeReferences(tabName);
 }
 
 void moveItems(const QString &oldId, const QString &newId)
 {
+    waitForSavedItems();
+
     const QString oldFileName = itemFileName(oldId);
     const QString newFileName = itemFileName(newId);
+    preloadedItems().remove(oldId);
+    preloadedItems().remove(newId);
 
     if ( oldFileName != newFileName && QFile::copy(oldFileName, newFileName) ) {
         QFile::remove(oldFileName);
+        BlobStore::instance()->moveReferences(oldId, newId);
     } else {
         COPYQ_LOG( QString("Failed to move items from \"%1\" (tab \"%2\") to \"%3\" (tab \"%4\")")
                    .arg(oldFileName, oldId,
                         newFileName, newId) );
     }
 }
+
+#ifdef HAS_TESTS
+void setItemFileWriteCrashAfter(int bytes)
+{
+    waitForSavedItems();
+    itemFileWriteCrashAfterBytes = bytes;
+}
+#endif
@@ -21,18 +21,70 @@
 
 #include "item/itemwidget.h"
 
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+#include <QVector>
+
 class QAbstractItemModel;
 class ItemFactory;
 class QString;
 
+/** Content of item file read in advance. */
+struct PreloadedItems {
+    QByteArray bytes;
+    QDateTime lastModified;
+    /// Stored data by digest (see BlobStore).
+    QHash<QByteArray, QByteArray> blobs;
+    /// Deserialized items (only if the file uses default format and all stored data were read).
+    QVector<QVariantMap> items;
+    /// Digests of stored data referenced by deserialized items.
+    QSet<QByteArray> blobReferences;
+    bool deserialized = false;
+};
+
+/** Return path to file with items. */
+QString itemFileName(const QString &id //!< See ClipboardBrowser::getID().
+        );
+
+/**
+ * Use content of item file and stored data (by digest, see BlobStore)
+ * read in advance next time items are loaded.
+ *
+ * The content is used only if the file was not modified since.
+ */
+void setPreloadedItems(const QString &tabName, const PreloadedItems &items);
+
+/** Return true if content of item file was read in advance and not used yet. */
+bool hasPreloadedItems(const QString &tabName);
+
+/** Return approximate memory used by content read in advance and not used yet. */
+qint64 preloadedItemsMemoryUsage();
+
+/** Drop all content read in advance and not used yet. */
+void clearPreloadedItems();
+
+/**
+ * Take items deserialized in advance for tab being currently loaded.
+ *
+ * Loaders of default item format use these instead of deserializing the file again.
+ */
+bool takeDeserializedItems(
+        const QString &tabName, QVector<QVariantMap> *items, QSet<QByteArray> *blobReferences);
+
 /** Load items from configuration file. */
 ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model //!< Model for items.
         , ItemFactory *itemFactory, int maxItems);
 
-/** Save items to configuration file. */
+/** Save items to configuration file (file is written in background). */
 bool saveItems(const QString &tabName, const QAbstractItemModel &model //!< Model containing items to save.
         , const ItemSaverPtr &saver);
 
+/** Wait until all saved items are written to configuration files. */
+void waitForSavedItems();
+
 /** Remove configuration file for items. */
 void removeItems(const QString &tabName //!< See ClipboardBrowser::getID().
         );
@@ -43,4 +95,17 @@ void moveItems(
         const QString &newId //!< See ClipboardBrowser::getID().
         );
 
+#ifdef HAS_TESTS
+/**
+ * Simulate crash while writing item files saved next.
+ *
+ * The application exits immediately after given number of bytes is written
+ * to the temporary file (the file is never renamed). Negative value disables
+ * the simulation.
+ *
+ * Waits for items saved earlier to be written.
+ */
+void setItemFileWriteCrashAfter(int bytes);
+#endif
+
 #endif // ITEMSTORE_H
@@ -295,6 +295,18 @@ QVariantList ItemScriptable::currentArguments()
     return arguments;
 }
 
+QVariant ItemScriptable::queryTab(const QString &query, const QVariantList &arguments)
+{
+    QVariant result;
+    QMetaObject::invokeMethod(
+                m_scriptable, "queryTab", Qt::DirectConnection,
+                Q_RETURN_ARG(QVariant, result),
+                Q_ARG(QString, objectName()),
+                Q_ARG(QString, query),
+                Q_ARG(QVariantList, arguments) );
+    return result;
+}
+
 bool ItemSaverInterface::saveItems(const QString &, const QAbstractItemModel &, QIODevice *)
 {
     return false;
@@ -359,6 +371,11 @@ bool ItemLoaderInterface::matches(const QModelIndex &, const QRegExp &) const
     return false;
 }
 
+QVariant ItemLoaderInterface::queryTab(const QAbstractItemModel &, const QString &, const QVariantList &) const
+{
+    return QVariant();
+}
+
 QObject *ItemLoaderInterface::tests(const TestInterfacePtr &) const
 {
     return nullptr;
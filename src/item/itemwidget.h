@@ -213,6 +213,17 @@ protected:
      */
     QVariantList currentArguments();
 
+    /**
+     * Query plugin loader in server about items in current tab.
+     *
+     * Avoids fetching all items to client.
+     *
+     * Shouldn't be called before start().
+     *
+     * @see ItemLoaderInterface::queryTab()
+     */
+    QVariant queryTab(const QString &query, const QVariantList &arguments = QVariantList());
+
 private:
     QObject *m_scriptable = nullptr;
 };
@@ -415,6 +426,15 @@ public:
      */
     virtual bool matches(const QModelIndex &index, const QRegExp &re) const;
 
+    /**
+     * Answer query from plugin script about items in a tab (@a model).
+     *
+     * Called in server for ItemScriptable::queryTab().
+     * Returns invalid value by default.
+     */
+    virtual QVariant queryTab(
+            const QAbstractItemModel &model, const QString &query, const QVariantList &arguments) const;
+
     /**
      * Return object with tests.
      *
@@ -0,0 +1,312 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "item/pagedtexteditor.h"
+
+#include "common/common.h"
+
+#include "gui/iconfactory.h"
+#include "gui/icons.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+#include <cstring>
+
+namespace {
+
+/// Approximate size of a page in bytes.
+const int pageSize = 256 * 1024;
+
+/// Maximum number of bytes to search for line end after page size is reached.
+const int maxPageEndSearchSize = 4 * 1024;
+
+int pageEnd(const QByteArray &text, int start)
+{
+    int end = start + pageSize;
+    if ( end >= text.size() )
+        return text.size();
+
+    // Prefer ending pages at line end.
+    const int searchSize = qMin(maxPageEndSearchSize, text.size() - end);
+    const auto lineEnd = static_cast<const char*>(
+                std::memchr(text.constData() + end, '\n', static_cast<size_t>(searchSize)) );
+    if (lineEnd)
+        return static_cast<int>(lineEnd - text.constData()) + 1;
+
+    // Avoid splitting UTF-8 sequences.
+    while ( end > start && (static_cast<uchar>(text.at(end)) & 0xC0) == 0x80 )
+        --end;
+
+    return end;
+}
+
+QVector<int> pageOffsets(const QByteArray &text)
+{
+    QVector<int> offsets;
+    offsets.reserve(text.size() / pageSize + 2);
+
+    int offset = 0;
+    do {
+        offsets.append(offset);
+        offset = pageEnd(text, offset);
+    } while ( offset < text.size() );
+
+    offsets.append(text.size());
+    return offsets;
+}
+
+} // namespace
+
+PagedTextEditor::PagedTextEditor(const QByteArray &utf8Text, QWidget *parent)
+    : QWidget(parent)
+    , m_utf8Text(utf8Text)
+    , m_pageOffsets(pageOffsets(utf8Text))
+    , m_textEdit(new QPlainTextEdit(this))
+    , m_pageLabel(new QLabel(this))
+    , m_buttonPrevious(new QToolButton(this))
+    , m_buttonNext(new QToolButton(this))
+{
+    m_textEdit->setFrameShape(QFrame::NoFrame);
+
+    m_buttonPrevious->setIcon( getIcon("go-previous", IconAngleLeft) );
+    m_buttonPrevious->setToolTip( tr("Previous Page") );
+    m_buttonPrevious->setAutoRaise(true);
+    connect( m_buttonPrevious, SIGNAL(clicked()),
+             this, SLOT(previousPage()) );
+
+    m_buttonNext->setIcon( getIcon("go-next", IconAngleRight) );
+    m_buttonNext->setToolTip( tr("Next Page") );
+    m_buttonNext->setAutoRaise(true);
+    connect( m_buttonNext, SIGNAL(clicked()),
+             this, SLOT(nextPage()) );
+
+    auto pageLayout = new QHBoxLayout;
+    pageLayout->setContentsMargins(QMargins(0, 0, 0, 0));
+    pageLayout->addWidget(m_buttonPrevious);
+    pageLayout->addWidget(m_pageLabel);
+    pageLayout->addWidget(m_buttonNext);
+    pageLayout->addStretch(1);
+
+    auto layout = new QVBoxLayout(this);
+    layout->setSpacing(0);
+    layout->setContentsMargins(QMargins(0, 0, 0, 0));
+    layout->addWidget(m_textEdit);
+    layout->addLayout(pageLayout);
+
+    setFocusProxy(m_textEdit);
+
+    initSingleShotTimer( &m_timerSearch, 0, this, SLOT(searchNextPage()) );
+
+    setPage(0);
+}
+
+bool PagedTextEditor::hasChanges() const
+{
+    return !m_changedPages.isEmpty() || m_textEdit->document()->isModified();
+}
+
+void PagedTextEditor::setModified(bool modified)
+{
+    if (modified) {
+        m_textEdit->document()->setModified(true);
+        return;
+    }
+
+    if ( !hasChanges() )
+        return;
+
+    // Changes are now part of the original text.
+    stopSearch();
+    m_utf8Text = text();
+    m_pageOffsets = pageOffsets(m_utf8Text);
+    m_changedPages.clear();
+
+    const int page = qMin(m_currentPage, pageCount() - 1);
+    m_currentPage = -1;
+    setPage(page);
+}
+
+QByteArray PagedTextEditor::text() const
+{
+    if ( !hasChanges() )
+        return m_utf8Text;
+
+    QByteArray result;
+    result.reserve( m_utf8Text.size() );
+
+    for (int page = 0; page < pageCount(); ++page) {
+        if ( page == m_currentPage && m_textEdit->document()->isModified() ) {
+            result.append( m_textEdit->toPlainText().toUtf8() );
+        } else {
+            const auto it = m_changedPages.constFind(page);
+            if ( it != m_changedPages.constEnd() ) {
+                result.append( it.value().toUtf8() );
+            } else {
+                const int start = m_pageOffsets[page];
+                const int end = m_pageOffsets[page + 1];
+                result.append( m_utf8Text.constData() + start, end - start );
+            }
+        }
+    }
+
+    return result;
+}
+
+void PagedTextEditor::search(const QRegExp &re, bool backwards)
+{
+    stopSearch();
+
+    if ( !re.isValid() || re.isEmpty() )
+        return;
+
+    // Search rest of the current page first.
+    QTextDocument::FindFlags flags;
+    if (backwards)
+        flags = QTextDocument::FindBackward;
+
+    const auto tc = m_textEdit->document()->find( re, m_textEdit->textCursor(), flags );
+    if ( !tc.isNull() ) {
+        m_textEdit->setTextCursor(tc);
+        return;
+    }
+
+    // Search other pages and finally the current page from the beginning.
+    m_searchRe = re;
+    m_searchBackwards = backwards;
+    m_searchPagesLeft = pageCount();
+    m_searchPage = m_currentPage;
+    searchNextPage();
+}
+
+void PagedTextEditor::previousPage()
+{
+    stopSearch();
+    if (m_currentPage > 0)
+        setPage(m_currentPage - 1);
+}
+
+void PagedTextEditor::nextPage()
+{
+    stopSearch();
+    if (m_currentPage + 1 < pageCount())
+        setPage(m_currentPage + 1);
+}
+
+void PagedTextEditor::searchNextPage()
+{
+    if (m_searchPagesLeft <= 0)
+        return;
+
+    --m_searchPagesLeft;
+    const int count = pageCount();
+    m_searchPage = (m_searchPage + (m_searchBackwards ? count - 1 : 1)) % count;
+
+    const auto text = pageText(m_searchPage);
+    const int position = m_searchBackwards
+            ? m_searchRe.lastIndexIn(text)
+            : m_searchRe.indexIn(text);
+
+    if (position != -1) {
+        const int page = m_searchPage;
+        const int length = m_searchRe.matchedLength();
+        stopSearch();
+        setPage(page);
+        selectMatch(position, length);
+        return;
+    }
+
+    if (m_searchPagesLeft > 0)
+        m_timerSearch.start();
+    else
+        stopSearch();
+
+    updatePageLabel();
+}
+
+QString PagedTextEditor::pageText(int page) const
+{
+    if (page == m_currentPage)
+        return m_textEdit->toPlainText();
+
+    const auto it = m_changedPages.constFind(page);
+    if ( it != m_changedPages.constEnd() )
+        return it.value();
+
+    const int start = m_pageOffsets[page];
+    const int end = m_pageOffsets[page + 1];
+    return QString::fromUtf8( m_utf8Text.constData() + start, end - start );
+}
+
+void PagedTextEditor::setPage(int page)
+{
+    if (page == m_currentPage)
+        return;
+
+    storeCurrentPage();
+
+    const auto text = pageText(page);
+    const bool changed = m_changedPages.contains(page);
+    m_currentPage = page;
+    m_textEdit->setPlainText(text);
+    m_textEdit->document()->setModified(changed);
+    m_changedPages.remove(page);
+
+    m_buttonPrevious->setEnabled(page > 0);
+    m_buttonNext->setEnabled(page + 1 < pageCount());
+    updatePageLabel();
+}
+
+void PagedTextEditor::storeCurrentPage()
+{
+    if ( m_currentPage != -1 && m_textEdit->document()->isModified() )
+        m_changedPages[m_currentPage] = m_textEdit->toPlainText();
+}
+
+void PagedTextEditor::stopSearch()
+{
+    m_timerSearch.stop();
+    m_searchPagesLeft = 0;
+    updatePageLabel();
+}
+
+void PagedTextEditor::selectMatch(int position, int length)
+{
+    auto tc = m_textEdit->textCursor();
+    tc.setPosition(position);
+    tc.setPosition(position + length, QTextCursor::KeepAnchor);
+    m_textEdit->setTextCursor(tc);
+}
+
+void PagedTextEditor::updatePageLabel()
+{
+    if (m_searchPagesLeft > 0) {
+        m_pageLabel->setText( tr("Searching page %1 of %2...")
+                              .arg(m_searchPage + 1).arg(pageCount()) );
+    } else {
+        m_pageLabel->setText( tr("Page %1 of %2")
+                              .arg(m_currentPage + 1).arg(pageCount()) );
+    }
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef PAGEDTEXTEDITOR_H
+#define PAGEDTEXTEDITOR_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QRegExp>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+class QLabel;
+class QPlainTextEdit;
+class QToolButton;
+
+/**
+ * Editor for big text items.
+ *
+ * Only single page of the text is decoded and shown at a time. Pages are
+ * decoded from UTF-8 item data on demand and only changed pages are kept
+ * separately.
+ */
+class PagedTextEditor : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit PagedTextEditor(const QByteArray &utf8Text, QWidget *parent = nullptr);
+
+    QPlainTextEdit *textEdit() const { return m_textEdit; }
+
+    bool hasChanges() const;
+
+    void setModified(bool modified);
+
+    /// Returns UTF-8 encoded text including changes in all pages.
+    QByteArray text() const;
+
+    /**
+     * Select next or previous match.
+     *
+     * Other pages are searched incrementally without blocking UI.
+     */
+    void search(const QRegExp &re, bool backwards);
+
+private slots:
+    void previousPage();
+    void nextPage();
+    void searchNextPage();
+
+private:
+    int pageCount() const { return m_pageOffsets.size() - 1; }
+    QString pageText(int page) const;
+    void setPage(int page);
+    void storeCurrentPage();
+    void stopSearch();
+    void selectMatch(int position, int length);
+    void updatePageLabel();
+
+    QByteArray m_utf8Text;
+    /// Start of each page in m_utf8Text and end of text.
+    QVector<int> m_pageOffsets;
+    QMap<int, QString> m_changedPages;
+    int m_currentPage = -1;
+
+    QPlainTextEdit *m_textEdit;
+    QLabel *m_pageLabel;
+    QToolButton *m_buttonPrevious;
+    QToolButton *m_buttonNext;
+
+    QRegExp m_searchRe;
+    bool m_searchBackwards = false;
+    int m_searchPage = -1;
+    int m_searchPagesLeft = 0;
+    QTimer m_timerSearch;
+};
+
+#endif // PAGEDTEXTEDITOR_H
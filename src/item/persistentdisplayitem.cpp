@@ -21,6 +21,8 @@
 
 #include "item/itemdelegate.h"
 
+#include <QWidget>
+
 PersistentDisplayItem::PersistentDisplayItem(ItemDelegate *delegate,
         const QVariantMap &data,
         QWidget *widget)
@@ -38,6 +40,15 @@ bool PersistentDisplayItem::isValid()
     return !m_delegate->invalidateHidden( m_widget.data() );
 }
 
+bool PersistentDisplayItem::isGone() const
+{
+    if ( m_widget.isNull() || m_delegate.isNull() )
+        return true;
+
+    // Widgets not yet painted are hidden too, only explicitly hidden ones are gone.
+    return m_widget->isHidden() && m_widget->testAttribute(Qt::WA_WState_ExplicitShowHide);
+}
+
 void PersistentDisplayItem::setData(const QVariantMap &data)
 {
     if ( !data.isEmpty() && isValid() && m_delegate && data != m_data )
@@ -55,6 +55,14 @@ public:
      */
     bool isValid();
 
+    /**
+     * Returns true if display item widget was destroyed or hidden after it
+     * was shown (e.g. scrolled out of view or replaced by a new one).
+     *
+     * Unlike isValid() this does not invalidate the widget.
+     */
+    bool isGone() const;
+
     /**
      * Sets display data.
      *
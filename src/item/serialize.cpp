@@ -31,11 +31,52 @@
 #include <QObject>
 #include <QPair>
 #include <QStringList>
+#include <QVector>
 
 #include <cstring>
 
 namespace {
 
+/// Storage of format data in serialized item (version 3).
+enum DataStorage {
+    DataInline = 0,
+    DataCompressed = 1,
+    DataBlob = 2
+};
+
+/**
+ * Replaces item count in serialized items with checksums (see serializeModelWithChecksums()).
+ *
+ * Negative item count is format version. Versions of the application before
+ * this format was introduced fail to load such items, lower values are
+ * reserved for future formats.
+ */
+const qint32 checksummedItemsMarker = -1;
+
+struct Crc32Table {
+    quint32 values[256];
+};
+
+quint32 crc32(const QByteArray &bytes)
+{
+    // Initialization of local static is thread-safe (items are also read in background).
+    static const Crc32Table table = []() {
+        Crc32Table t;
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t.values[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (const char byte : bytes)
+        crc = table.values[(crc ^ static_cast<uchar>(byte)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
 template <typename Fn>
 bool mimeIdApply(Fn fn)
 {
@@ -127,9 +168,50 @@ bool deserializeDataV2(QDataStream *out, QVariantMap *data)
     return out->status() == QDataStream::Ok;
 }
 
-} // namespace
+bool deserializeDataV3(QDataStream *out, QVariantMap *data, ItemDataBlobs *blobs)
+{
+    qint32 size;
+    *out >> size;
 
-void serializeData(QDataStream *stream, const QVariantMap &data)
+    QString mime;
+    QByteArray tmpBytes;
+    QByteArray missingFiles;
+    qint8 storage;
+    for (qint32 i = 0; i < size && out->status() == QDataStream::Ok; ++i) {
+        *out >> mime >> storage >> tmpBytes;
+        mime = decompressMime(mime);
+
+        if (storage == DataCompressed) {
+            tmpBytes = qUncompress(tmpBytes);
+            if ( tmpBytes.isEmpty() ) {
+                out->setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+        } else if (storage == DataBlob) {
+            QByteArray blobBytes;
+            if ( !blobs || !blobs->blob(tmpBytes, &blobBytes) ) {
+                log( QString("Data for format \"%1\" are missing (%2)")
+                     .arg(mime, QString::fromLatin1(tmpBytes)), LogError );
+                // Keep the reference so the data are not lost when the item is saved again.
+                missingFiles.append( mime.toUtf8() + '\t' + tmpBytes + '\n' );
+                continue;
+            }
+            tmpBytes = blobBytes;
+        } else if (storage != DataInline) {
+            out->setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+
+        data->insert(mime, tmpBytes);
+    }
+
+    if ( !missingFiles.isEmpty() )
+        data->insert( mimeDataFiles, data->value(mimeDataFiles).toByteArray() + missingFiles );
+
+    return out->status() == QDataStream::Ok;
+}
+
+void serializeDataV2(QDataStream *stream, const QVariantMap &data)
 {
     *stream << static_cast<qint32>(-2);
 
@@ -145,7 +227,51 @@ void serializeData(QDataStream *stream, const QVariantMap &data)
     }
 }
 
-void deserializeData(QDataStream *stream, QVariantMap *data)
+void serializeItemData(QDataStream *stream, const QVariantMap &data, ItemDataBlobs *blobs)
+{
+    if ( blobs && data.contains(mimeDataFiles) )
+        addDataFileReferences(data, blobs);
+
+    // Items without big data are stored in format readable by older versions.
+    QVector<QByteArray> digests;
+    bool hasBlobs = false;
+    if (blobs) {
+        digests.reserve( data.size() );
+        for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+            const auto digest = blobs->addBlob( it.value().toByteArray() );
+            hasBlobs = hasBlobs || !digest.isEmpty();
+            digests.append(digest);
+        }
+    }
+
+    if (!hasBlobs) {
+        serializeDataV2(stream, data);
+        return;
+    }
+
+    *stream << static_cast<qint32>(-3);
+
+    const qint32 size = data.size();
+    *stream << size;
+
+    QByteArray bytes;
+    int i = 0;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it, ++i) {
+        const auto &mime = it.key();
+        const auto &digest = digests[i];
+        if ( !digest.isEmpty() ) {
+            *stream << compressMime(mime) << static_cast<qint8>(DataBlob) << digest;
+        } else {
+            bytes = it.value().toByteArray();
+            const bool compress = shouldCompress(bytes, mime);
+            *stream << compressMime(mime)
+                    << static_cast<qint8>(compress ? DataCompressed : DataInline)
+                    << ( compress ? qCompress(bytes) : bytes );
+        }
+    }
+}
+
+void deserializeItemData(QDataStream *stream, QVariantMap *data, ItemDataBlobs *blobs)
 {
     try {
         qint32 length;
@@ -159,6 +285,11 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
             return;
         }
 
+        if (length == -3) {
+            deserializeDataV3(stream, data, blobs);
+            return;
+        }
+
         if (length < 0) {
             stream->setStatus(QDataStream::ReadCorruptData);
             return;
@@ -185,33 +316,44 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
     }
 }
 
-QByteArray serializeData(const QVariantMap &data)
+bool serializeModel(const QAbstractItemModel &model, QDataStream *stream, ItemDataBlobs *blobs)
 {
-    QByteArray bytes;
-    QDataStream out(&bytes, QIODevice::WriteOnly);
-    serializeData(&out, data);
-    return bytes;
-}
+    qint32 length = model.rowCount();
+    *stream << length;
 
-bool deserializeData(QVariantMap *data, const QByteArray &bytes)
-{
-    QDataStream out(bytes);
-    deserializeData(&out, data);
-    return out.status() == QDataStream::Ok;
+    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
+        serializeItemData( stream, model.data(model.index(i, 0), contentType::data).toMap(), blobs );
+
+    return stream->status() == QDataStream::Ok;
 }
 
-bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
+bool serializeModelWithChecksums(const QAbstractItemModel &model, QDataStream *stream, ItemDataBlobs *blobs)
 {
+    *stream << checksummedItemsMarker;
+
     qint32 length = model.rowCount();
     *stream << length;
 
-    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
-        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
+    QByteArray itemBytes;
+    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
+        itemBytes.clear();
+        {
+            QDataStream itemStream(&itemBytes, QIODevice::WriteOnly);
+            itemStream.setVersion( stream->version() );
+            serializeItemData( &itemStream, model.data(model.index(i, 0), contentType::data).toMap(), blobs );
+        }
+        *stream << itemBytes << crc32(itemBytes);
+    }
 
     return stream->status() == QDataStream::Ok;
 }
 
-bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems)
+/**
+ * Load items until first damaged one.
+ *
+ * Returns false only if no items can be loaded.
+ */
+bool deserializeModelWithChecksums(QAbstractItemModel *model, QDataStream *stream, int maxItems, ItemDataBlobs *blobs)
 {
     qint32 length;
     *stream >> length;
@@ -227,27 +369,133 @@ bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItem
     // Limit the loaded number of items to model's maximum.
     length = qMin(length, maxItems) - model->rowCount();
 
+    if ( length != 0 && !model->insertRows(0, length) )
+        return false;
+
+    qint32 i = 0;
+    try {
+        QByteArray itemBytes;
+        quint32 checksum;
+        for (; i < length; ++i) {
+            *stream >> itemBytes >> checksum;
+            if ( stream->status() != QDataStream::Ok || checksum != crc32(itemBytes) )
+                break;
+
+            QDataStream itemStream(itemBytes);
+            itemStream.setVersion( stream->version() );
+            QVariantMap data;
+            deserializeItemData(&itemStream, &data, blobs);
+            if ( itemStream.status() != QDataStream::Ok )
+                break;
+
+            if ( blobs && data.contains(mimeDataFiles) )
+                addDataFileReferences(data, blobs);
+
+            model->setData( model->index(i, 0), data, contentType::data );
+        }
+    } catch (const std::exception &e) {
+        log( QObject::tr("Data deserialization failed: %1").arg(e.what()), LogError );
+    }
+
+    if (i < length) {
+        log( QString("Items are damaged, recovered %1 of %2 items").arg(i).arg(length), LogError );
+        model->removeRows(i, length - i);
+    }
+
+    return true;
+}
+
+bool deserializeModel(QAbstractItemModel *model, QDataStream *stream, int maxItems, ItemDataBlobs *blobs)
+{
+    qint32 length;
+    *stream >> length;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    if (length == checksummedItemsMarker)
+        return deserializeModelWithChecksums(model, stream, maxItems, blobs);
+
+    if (length < checksummedItemsMarker) {
+        log( QString("Items were saved in unsupported format %1 (by newer version of the application?)")
+             .arg(-length), LogError );
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    // Limit the loaded number of items to model's maximum.
+    length = qMin(length, maxItems) - model->rowCount();
+
     if ( length != 0 && !model->insertRows(0, length) )
         return false;
 
     for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
         QVariantMap data;
-        deserializeData(stream, &data);
+        deserializeItemData(stream, &data, blobs);
+        if ( blobs && data.contains(mimeDataFiles) )
+            addDataFileReferences(data, blobs);
         model->setData( model->index(i, 0), data, contentType::data );
     }
 
     return stream->status() == QDataStream::Ok;
 }
 
-bool serializeData(const QAbstractItemModel &model, QIODevice *file)
+} // namespace
+
+void addDataFileReferences(const QVariantMap &data, ItemDataBlobs *blobs)
+{
+    const auto files = data.value(mimeDataFiles).toByteArray();
+    for ( const auto &line : files.split('\n') ) {
+        const int i = line.indexOf('\t');
+        if (i != -1)
+            blobs->addBlobReference( line.mid(i + 1) );
+    }
+}
+
+void serializeData(QDataStream *stream, const QVariantMap &data)
+{
+    serializeDataV2(stream, data);
+}
+
+void deserializeData(QDataStream *stream, QVariantMap *data)
+{
+    deserializeItemData(stream, data, nullptr);
+}
+
+QByteArray serializeData(const QVariantMap &data)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    serializeData(&out, data);
+    return bytes;
+}
+
+bool deserializeData(QVariantMap *data, const QByteArray &bytes)
+{
+    QDataStream out(bytes);
+    deserializeData(&out, data);
+    return out.status() == QDataStream::Ok;
+}
+
+bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
+{
+    return serializeModel(model, stream, nullptr);
+}
+
+bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems)
+{
+    return deserializeModel(model, stream, maxItems, nullptr);
+}
+
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, ItemDataBlobs *blobs)
 {
     QDataStream stream(file);
     stream.setVersion(QDataStream::Qt_4_7);
-    return serializeData(model, &stream);
+    return serializeModelWithChecksums(model, &stream, blobs);
 }
 
-bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems)
+bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems, ItemDataBlobs *blobs)
 {
     QDataStream stream(file);
-    return deserializeData(model, &stream, maxItems);
+    return deserializeModel(model, &stream, maxItems, blobs);
 }
@@ -27,6 +27,35 @@ class QByteArray;
 class QDataStream;
 class QIODevice;
 
+/**
+ * Storage for big item data shared by items in all tabs.
+ *
+ * Serialized items reference the stored data by digest instead of
+ * containing the data.
+ */
+class ItemDataBlobs
+{
+public:
+    virtual ~ItemDataBlobs() = default;
+
+    /**
+     * Store data and return its digest.
+     *
+     * Returns empty digest if the data should be serialized with the item
+     * (e.g. data too small or failed to store).
+     */
+    virtual QByteArray addBlob(const QByteArray &bytes) = 0;
+
+    /// Retrieve data for digest, returns false if data are not available.
+    virtual bool blob(const QByteArray &digest, QByteArray *bytes) = 0;
+
+    /// Keep data referenced from item data (see mimeDataFiles) in storage.
+    virtual void addBlobReference(const QByteArray &digest) = 0;
+};
+
+/// Reference data left out from item by clipboard data limits ("FORMAT\tDIGEST" lines in mimeDataFiles).
+void addDataFileReferences(const QVariantMap &data, ItemDataBlobs *blobs);
+
 void serializeData(QDataStream *stream, const QVariantMap &data);
 void deserializeData(QDataStream *stream, QVariantMap *data);
 QByteArray serializeData(const QVariantMap &data);
@@ -34,7 +63,7 @@ bool deserializeData(QVariantMap *data, const QByteArray &bytes);
 
 bool serializeData(const QAbstractItemModel &model, QDataStream *stream);
 bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems);
-bool serializeData(const QAbstractItemModel &model, QIODevice *file);
-bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems);
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, ItemDataBlobs *blobs = nullptr);
+bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems, ItemDataBlobs *blobs = nullptr);
 
 #endif // SERIALIZE_H
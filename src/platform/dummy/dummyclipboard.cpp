@@ -19,6 +19,7 @@
 
 #include "dummyclipboard.h"
 
+#include "common/clipboarddatalimits.h"
 #include "common/common.h"
 
 #include <QApplication>
@@ -52,7 +53,12 @@ DummyClipboard::DummyClipboard(bool connectClipboardSignal)
 QVariantMap DummyClipboard::data(ClipboardMode mode, const QStringList &formats) const
 {
     const QMimeData *data = clipboardData(mode);
-    return data ? cloneData(*data, formats) : QVariantMap();
+    if (!data)
+        return QVariantMap();
+
+    QVariantMap dataMap = cloneData(*data, formats);
+    applyClipboardDataLimits(clipboardDataLimits(), &dataMap);
+    return dataMap;
 }
 
 void DummyClipboard::setData(ClipboardMode mode, const QVariantMap &dataMap)
@@ -0,0 +1,109 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "dummyclipboardload.h"
+
+#include "common/log.h"
+#include "common/mimetypes.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QDateTime>
+#include <QMimeData>
+
+namespace {
+
+int envInt(const char *name, int defaultValue)
+{
+    bool ok;
+    const int value = qgetenv(name).toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+QByteArray padded(QByteArray bytes, int size)
+{
+    if (bytes.size() < size)
+        bytes.append( QByteArray(size - bytes.size(), 'x') );
+    return bytes;
+}
+
+} // namespace
+
+void DummyClipboardLoad::startFromEnvironment(QObject *parent)
+{
+    const int count = envInt("COPYQ_DUMMY_CLIPBOARD_LOAD", 0);
+    if (count <= 0)
+        return;
+
+    const int interval = envInt("COPYQ_DUMMY_CLIPBOARD_LOAD_INTERVAL", 100);
+    const int delay = envInt("COPYQ_DUMMY_CLIPBOARD_LOAD_DELAY", 1000);
+    const int size = envInt("COPYQ_DUMMY_CLIPBOARD_LOAD_SIZE", 100);
+
+    QString formatList = QString::fromUtf8( qgetenv("COPYQ_DUMMY_CLIPBOARD_LOAD_FORMATS") );
+    if ( formatList.isEmpty() )
+        formatList = mimeText;
+
+    const QStringList formats = formatList.split(',', QString::SkipEmptyParts);
+
+    log( QString("Generating %1 clipboard changes (interval %2 ms, size %3 bytes, formats %4)")
+         .arg(count).arg(interval).arg(size).arg(formats.join(", ")), LogNote );
+
+    auto load = new DummyClipboardLoad(count, size, formats, parent);
+    load->m_timer.setInterval(interval);
+    QTimer::singleShot( delay, &load->m_timer, SLOT(start()) );
+}
+
+void DummyClipboardLoad::changeClipboard()
+{
+    if (m_sequence >= m_count) {
+        m_timer.stop();
+        log("Finished generating clipboard changes", LogNote);
+        return;
+    }
+
+    QApplication::clipboard()->setMimeData( createMimeData() );
+    ++m_sequence;
+}
+
+DummyClipboardLoad::DummyClipboardLoad(int count, int size, const QStringList &formats, QObject *parent)
+    : QObject(parent)
+    , m_count(count)
+    , m_size(size)
+    , m_formats(formats)
+{
+    connect( &m_timer, SIGNAL(timeout()),
+             this, SLOT(changeClipboard()) );
+}
+
+QMimeData *DummyClipboardLoad::createMimeData() const
+{
+    const QByteArray header = QString("copyq-load %1 %2\n")
+            .arg(m_sequence)
+            .arg(QDateTime::currentMSecsSinceEpoch())
+            .toUtf8();
+
+    auto data = new QMimeData();
+    data->setData( mimeText, padded(header, m_size) );
+
+    const QString &format = m_formats[m_sequence % m_formats.size()];
+    if (format != mimeText)
+        data->setData( format, padded(header, m_size) );
+
+    return data;
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DUMMYCLIPBOARDLOAD_H
+#define DUMMYCLIPBOARDLOAD_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+class QMimeData;
+
+/**
+ * Generates synthetic clipboard changes in clipboard monitor process.
+ *
+ * Used for stress testing (see "tests/stress-clipboard.sh").
+ *
+ * Each change contains text "copyq-load {sequence} {msecs since epoch}"
+ * padded to requested size and one additional format from the list
+ * (formats are used in turns).
+ *
+ * Configured with environment variables:
+ * - COPYQ_DUMMY_CLIPBOARD_LOAD: number of changes (generator is disabled if unset)
+ * - COPYQ_DUMMY_CLIPBOARD_LOAD_INTERVAL: milliseconds between changes
+ * - COPYQ_DUMMY_CLIPBOARD_LOAD_DELAY: milliseconds before first change
+ * - COPYQ_DUMMY_CLIPBOARD_LOAD_SIZE: size of data in each format
+ * - COPYQ_DUMMY_CLIPBOARD_LOAD_FORMATS: comma-separated list of formats
+ */
+class DummyClipboardLoad final : public QObject
+{
+    Q_OBJECT
+public:
+    /** Start generating changes if enabled in environment. */
+    static void startFromEnvironment(QObject *parent);
+
+private slots:
+    void changeClipboard();
+
+private:
+    DummyClipboardLoad(int count, int size, const QStringList &formats, QObject *parent);
+
+    QMimeData *createMimeData() const;
+
+    int m_count;
+    int m_size;
+    QStringList m_formats;
+    int m_sequence = 0;
+    QTimer m_timer;
+};
+
+#endif // DUMMYCLIPBOARDLOAD_H
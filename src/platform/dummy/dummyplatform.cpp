@@ -20,6 +20,7 @@
 #include "dummyplatform.h"
 
 #include "dummyclipboard.h"
+#include "dummyclipboardload.h"
 
 #include "app/applicationexceptionhandler.h"
 
@@ -45,7 +46,9 @@ QApplication *DummyPlatform::createServerApplication(int &argc, char **argv)
 
 QApplication *DummyPlatform::createMonitorApplication(int &argc, char **argv)
 {
-    return new ApplicationExceptionHandler<QApplication>(argc, argv);
+    auto app = new ApplicationExceptionHandler<QApplication>(argc, argv);
+    DummyClipboardLoad::startFromEnvironment(app);
+    return app;
 }
 
 QCoreApplication *DummyPlatform::createClientApplication(int &argc, char **argv)
@@ -5,7 +5,13 @@ if (UNIX)
     file(GLOB copyq_SOURCES ${copyq_SOURCES} platform/unix/*.cpp)
 endif()
 
-if (X11_FOUND)
+if (WITH_DUMMY_PLATFORM)
+    message(STATUS "Using dummy platform.")
+    file(GLOB copyq_SOURCES ${copyq_SOURCES}
+        platform/dummy/*.cpp
+        )
+    set(USE_QXT FALSE)
+elseif (X11_FOUND)
     include(platform/x11/x11platform.cmake)
 elseif (Q_WS_WIN OR WIN32)
     include(platform/win/winplatform.cmake)
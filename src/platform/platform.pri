@@ -1,18 +1,27 @@
-unix:!macx:!android {
-    include(x11/x11platform.pri)
+CONFIG(dummy_platform) {
+    DUMMY_PLATFORM = 1
+} else {
+    unix:!macx:!android {
+        include(x11/x11platform.pri)
+    }
+    win32 {
+        include(win/winplatform.pri)
+    }
+    macx {
+        include(mac/macplatform.pri)
+    }
+    !unix|android:!win32 {
+        DUMMY_PLATFORM = 1
+    }
 }
-win32 {
-    include(win/winplatform.pri)
-}
-macx {
-    include(mac/macplatform.pri)
-}
-!unix|android:!win32 {
+equals(DUMMY_PLATFORM,1) {
     SOURCES += \
         $$PWD/dummy/dummyplatform.cpp \
-        $$PWD/dummy/dummyclipboard.cpp
+        $$PWD/dummy/dummyclipboard.cpp \
+        $$PWD/dummy/dummyclipboardload.cpp
     HEADERS += \
-        $$PWD/dummy/dummyclipboard.h
+        $$PWD/dummy/dummyclipboard.h \
+        $$PWD/dummy/dummyclipboardload.h
 }
 unix {
     SOURCES += $$PWD/unix/unixsignalhandler.cpp
@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "x11activewindowtracker.h"
+
+#include "x11displayguard.h"
+#include "x11platformwindow.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+#include <X11/Xatom.h>
+
+namespace {
+
+int ignoreX11Errors(Display *, XErrorEvent *)
+{
+    return 0;
+}
+
+/**
+ * Ignores errors from requests made while the object exists.
+ *
+ * Tracked window can be destroyed any time.
+ */
+class X11ErrorTrap {
+public:
+    explicit X11ErrorTrap(Display *display)
+        : m_display(display)
+    {
+        XSync(m_display, False);
+        m_oldHandler = XSetErrorHandler(ignoreX11Errors);
+    }
+
+    ~X11ErrorTrap()
+    {
+        XSync(m_display, False);
+        XSetErrorHandler(m_oldHandler);
+    }
+
+    X11ErrorTrap(const X11ErrorTrap &) = delete;
+    X11ErrorTrap &operator=(const X11ErrorTrap &) = delete;
+
+private:
+    Display *m_display;
+    XErrorHandler m_oldHandler;
+};
+
+} // namespace
+
+X11ActiveWindowTracker *X11ActiveWindowTracker::instance()
+{
+    static QPointer<X11ActiveWindowTracker> tracker;
+    static bool failed = false;
+
+    if ( !tracker && !failed && QCoreApplication::instance() ) {
+        auto d = std::make_shared<X11DisplayGuard>();
+        if ( d->display() )
+            tracker = new X11ActiveWindowTracker(d, QCoreApplication::instance());
+        else
+            failed = true;
+    }
+
+    return tracker;
+}
+
+Window X11ActiveWindowTracker::activeWindow()
+{
+    // Handle events not yet delivered to the socket notifier.
+    processEvents();
+    return m_window;
+}
+
+void X11ActiveWindowTracker::processEvents()
+{
+    Display *display = d->display();
+    const Window root = DefaultRootWindow(display);
+
+    bool activeWindowChanged = false;
+    bool titleChanged = false;
+
+    while ( XEventsQueued(display, QueuedAfterReading) > 0 ) {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type != PropertyNotify)
+            continue;
+
+        const XPropertyEvent &propertyEvent = event.xproperty;
+        if (propertyEvent.window == root && propertyEvent.atom == m_atomActiveWindow)
+            activeWindowChanged = true;
+        else if (propertyEvent.window == m_window && propertyEvent.atom == m_atomName)
+            titleChanged = true;
+    }
+
+    if (activeWindowChanged)
+        updateActiveWindow();
+    else if (titleChanged)
+        updateTitle();
+
+    // Events read while updating won't trigger the socket notifier.
+    if ( XEventsQueued(display, QueuedAlready) > 0 )
+        QMetaObject::invokeMethod(this, "processEvents", Qt::QueuedConnection);
+}
+
+X11ActiveWindowTracker::X11ActiveWindowTracker(const std::shared_ptr<X11DisplayGuard> &d, QObject *parent)
+    : QObject(parent)
+    , d(d)
+    , m_notifier(ConnectionNumber(d->display()), QSocketNotifier::Read)
+    , m_atomActiveWindow(XInternAtom(d->display(), "_NET_ACTIVE_WINDOW", False))
+    , m_atomName(XInternAtom(d->display(), "_NET_WM_NAME", False))
+{
+    connect( &m_notifier, SIGNAL(activated(int)),
+             this, SLOT(processEvents()) );
+
+    Display *display = d->display();
+    XSelectInput(display, DefaultRootWindow(display), PropertyChangeMask);
+    updateActiveWindow();
+}
+
+void X11ActiveWindowTracker::updateActiveWindow()
+{
+    Display *display = d->display();
+    const Window window = getCurrentWindow(display);
+    if (window != m_window) {
+        X11ErrorTrap errorTrap(display);
+        if (m_window != 0)
+            XSelectInput(display, m_window, NoEventMask);
+        if (window != 0)
+            XSelectInput(display, window, PropertyChangeMask);
+        m_window = window;
+    }
+
+    updateTitle();
+}
+
+void X11ActiveWindowTracker::updateTitle()
+{
+    if (m_window == 0) {
+        m_title.clear();
+        return;
+    }
+
+    X11ErrorTrap errorTrap(d->display());
+    m_title = getWindowTitle(d->display(), m_window);
+}
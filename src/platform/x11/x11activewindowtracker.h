@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2018, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef X11ACTIVEWINDOWTRACKER_H
+#define X11ACTIVEWINDOWTRACKER_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QString>
+
+#include <X11/Xlib.h>
+
+#include <memory>
+
+class X11DisplayGuard;
+
+/**
+ * Keeps track of active window and its title.
+ *
+ * Uses single X11 connection for the whole application and listens to
+ * property changes of root window (_NET_ACTIVE_WINDOW) and of active window
+ * (_NET_WM_NAME) so reading current values doesn't need to query X server.
+ */
+class X11ActiveWindowTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Returns tracker for the application.
+     *
+     * Returns nullptr if there is no application instance or X11 display cannot be opened.
+     */
+    static X11ActiveWindowTracker *instance();
+
+    const std::shared_ptr<X11DisplayGuard> &display() const { return d; }
+
+    /// Returns active window or 0 if unknown.
+    Window activeWindow();
+
+    /// Returns title of active window.
+    const QString &activeWindowTitle() const { return m_title; }
+
+private slots:
+    void processEvents();
+
+private:
+    X11ActiveWindowTracker(const std::shared_ptr<X11DisplayGuard> &d, QObject *parent);
+
+    void updateActiveWindow();
+    void updateTitle();
+
+    std::shared_ptr<X11DisplayGuard> d;
+    QSocketNotifier m_notifier;
+
+    Atom m_atomActiveWindow;
+    Atom m_atomName;
+
+    Window m_window = 0;
+    QString m_title;
+};
+
+#endif // X11ACTIVEWINDOWTRACKER_H
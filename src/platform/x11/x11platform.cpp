@@ -30,6 +30,7 @@
 #include <QVariant>
 #include <QWidget>
 
+#include "x11activewindowtracker.h"
 #include "x11platformwindow.h"
 #include "x11platformclipboard.h"
 #include "x11displayguard.h"
@@ -84,7 +85,8 @@ X11Platform::~X11Platform() = default;
 
 PlatformWindowPtr X11Platform::getWindow(WId winId)
 {
-    auto d = std::make_shared<X11DisplayGuard>();
+    auto tracker = X11ActiveWindowTracker::instance();
+    auto d = tracker ? tracker->display() : std::make_shared<X11DisplayGuard>();
     if (!d->display())
         return PlatformWindowPtr();
 
@@ -94,6 +96,17 @@ PlatformWindowPtr X11Platform::getWindow(WId winId)
 
 PlatformWindowPtr X11Platform::getCurrentWindow()
 {
+    // Use cached active window and title if possible.
+    auto tracker = X11ActiveWindowTracker::instance();
+    if (tracker) {
+        const Window window = tracker->activeWindow();
+        if (window == 0)
+            return PlatformWindowPtr();
+
+        return PlatformWindowPtr(
+                    new X11PlatformWindow(tracker->display(), window, tracker->activeWindowTitle()) );
+    }
+
     auto d = std::make_shared<X11DisplayGuard>();
     if (!d->display())
         return PlatformWindowPtr();
@@ -2,6 +2,7 @@ DEFINES += COPYQ_WS_X11 HAS_X11TEST
 LIBS    += -lX11 -lXfixes -lXtst
 SOURCES += \
     ../qxt/qxtglobalshortcut_x11.cpp \
+    $$PWD/x11activewindowtracker.cpp \
     $$PWD/x11platform.cpp \
     $$PWD/x11platformwindow.cpp \
     $$PWD/x11platformclipboard.cpp \
@@ -14,6 +15,7 @@ greaterThan(QT_MAJOR_VERSION, 4) {
 }
 
 HEADERS += \
+    $$PWD/x11activewindowtracker.h \
     $$PWD/x11platformwindow.h \
     $$PWD/x11platformclipboard.h \
     platform/dummy/dummyclipboard.h
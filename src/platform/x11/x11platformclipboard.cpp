@@ -31,9 +31,20 @@
 #include <X11/Xatom.h>
 
 #include <QClipboard>
+#include <QMimeData>
 
 namespace {
 
+const int clipboardCheckIntervalMs = 50;
+const int selectionCheckIntervalMs = 100;
+const int maxCheckIntervalMs = 1000;
+/// Maximum time to postpone the check while clipboard/selection keeps changing.
+const int maxCheckDelayMs = 2000;
+
+const char mimeFormats[] = COPYQ_MIME_PREFIX "x11-formats";
+const char mimeOwner[] = COPYQ_MIME_PREFIX "x11-owner";
+const char mimeTimestamp[] = COPYQ_MIME_PREFIX "x11-timestamp";
+
 /// Return true only if selection is incomplete, i.e. mouse button or shift key is pressed.
 bool isSelectionIncomplete(Display *display)
 {
@@ -48,10 +59,15 @@ bool isSelectionIncomplete(Display *display)
     return event.xbutton.state & (Button1Mask | ShiftMask);
 }
 
-bool isClipboardEmpty(Display *display)
+Window clipboardOwner(Display *display)
 {
     static Atom atom = XInternAtom(display, "CLIPBOARD", False);
-    return XGetSelectionOwner(display, atom) == None;
+    return XGetSelectionOwner(display, atom);
+}
+
+bool isClipboardEmpty(Display *display)
+{
+    return clipboardOwner(display) == None;
 }
 
 bool isSelectionEmpty(Display *display)
@@ -60,13 +76,37 @@ bool isSelectionEmpty(Display *display)
     return XGetSelectionOwner(display, atom) == None;
 }
 
+/**
+ * Return clipboard owner, available formats (TARGETS) and time when owner
+ * acquired the clipboard (TIMESTAMP).
+ *
+ * These are cheap to fetch compared to the data, which can be big.
+ */
+QVariantMap clipboardFingerprint(Display *display, const QMimeData &data)
+{
+    QVariantMap fingerprint;
+    fingerprint.insert( mimeFormats, data.formats() );
+
+    if (display)
+        fingerprint.insert( mimeOwner, static_cast<qulonglong>(clipboardOwner(display)) );
+
+    // Not listed in formats() but provided by most apps (required by ICCCM).
+    // Some apps always return zero (CurrentTime) which cannot be used to
+    // detect changes.
+    const QByteArray timestamp = data.data("TIMESTAMP");
+    if ( timestamp.count('\0') != timestamp.size() )
+        fingerprint.insert(mimeTimestamp, timestamp);
+
+    return fingerprint;
+}
+
 } // namespace
 
 X11PlatformClipboard::X11PlatformClipboard(const std::shared_ptr<X11DisplayGuard> &d)
     : d(d)
 {
-    initSingleShotTimer( &m_timerCheckClipboard, 50, this, SLOT(onClipboardChanged()) );
-    initSingleShotTimer( &m_timerCheckSelection, 100, this, SLOT(onSelectionChanged()) );
+    initSingleShotTimer( &m_timerCheckClipboard, clipboardCheckIntervalMs, this, SLOT(onClipboardChanged()) );
+    initSingleShotTimer( &m_timerCheckSelection, selectionCheckIntervalMs, this, SLOT(onSelectionChanged()) );
     initSingleShotTimer( &m_timerResetClipboard, 500, this, SLOT(resetClipboard()) );
     initSingleShotTimer( &m_timerResetSelection, 500, this, SLOT(resetSelection()) );
 }
@@ -90,19 +130,39 @@ void X11PlatformClipboard::onChanged(int mode)
 {
     // Omit checking clipboard and selection too fast.
     if (mode == QClipboard::Clipboard)
-        m_timerCheckClipboard.start();
+        scheduleCheck(&m_timerCheckClipboard, &m_clipboardChangedSince, clipboardCheckIntervalMs);
     else
-        m_timerCheckSelection.start();
+        scheduleCheck(&m_timerCheckSelection, &m_selectionChangedSince, selectionCheckIntervalMs);
 }
 
 void X11PlatformClipboard::onClipboardChanged()
 {
     m_timerResetClipboard.stop();
+
+    const QMimeData *mimeData = clipboardData(ClipboardMode::Clipboard);
+    const QVariantMap fingerprint = mimeData
+            ? clipboardFingerprint(d->display(), *mimeData) : QVariantMap();
+    if ( !isClipboardStable(fingerprint) )
+        return;
+
+    m_timerCheckClipboard.setInterval(clipboardCheckIntervalMs);
+
+    // Same owner and valid timestamp means that the clipboard content was not
+    // set again since last fetched data, so skip fetching the data.
+    // Any other change (including older timestamp) results in full read.
+    if ( fingerprint.contains(mimeTimestamp) && fingerprint == m_clipboardDataFingerprint ) {
+        COPYQ_LOG_VERBOSE("Clipboard owner and timestamp are unchanged");
+        return;
+    }
+
     const QVariantMap data = DummyClipboard::data(ClipboardMode::Clipboard, m_formats);
+
     const bool foreignData = !ownsClipboardData(data);
     if ( foreignData && maybeResetClipboard() )
         return;
 
+    m_clipboardDataFingerprint = fingerprint;
+
     if (m_clipboardData == data)
         return;
 
@@ -121,6 +181,8 @@ void X11PlatformClipboard::onSelectionChanged()
     if ( waitIfSelectionIncomplete() )
         return;
 
+    m_timerCheckSelection.setInterval(selectionCheckIntervalMs);
+
     // Always assume that only plain text can be in primary selection buffer.
     // Asking a app for bigger data when mouse selection changes can make the app hang for a moment.
     const QVariantMap data = DummyClipboard::data( ClipboardMode::Selection, QStringList(mimeText) );
@@ -155,6 +217,37 @@ void X11PlatformClipboard::resetSelection()
 
 }
 
+void X11PlatformClipboard::scheduleCheck(QTimer *timer, QElapsedTimer *changedSince, int intervalMs)
+{
+    if ( !timer->isActive() ) {
+        timer->setInterval(intervalMs);
+        changedSince->start();
+    } else if ( changedSince->elapsed() < maxCheckDelayMs ) {
+        timer->setInterval( qMin(timer->interval() * 2, maxCheckIntervalMs) );
+    } else {
+        // Let the pending check run.
+        return;
+    }
+
+    timer->start();
+}
+
+bool X11PlatformClipboard::isClipboardStable(const QVariantMap &fingerprint)
+{
+    if (m_clipboardFingerprint == fingerprint)
+        return true;
+
+    m_clipboardFingerprint = fingerprint;
+
+    const bool changingQuickly = m_timerCheckClipboard.interval() > clipboardCheckIntervalMs;
+    if ( !changingQuickly || m_clipboardChangedSince.elapsed() >= maxCheckDelayMs )
+        return true;
+
+    COPYQ_LOG_VERBOSE("Clipboard is still changing");
+    m_timerCheckClipboard.start();
+    return false;
+}
+
 bool X11PlatformClipboard::waitIfSelectionIncomplete()
 {
     if (!d->display())
@@ -22,6 +22,7 @@
 
 #include "platform/dummy/dummyclipboard.h"
 
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QTimer>
 
@@ -52,6 +53,22 @@ private slots:
     void resetSelection();
 
 private:
+    /**
+     * Start timer to check clipboard/selection.
+     *
+     * Interval grows while changes keep coming (e.g. user is selecting text)
+     * but the check is not postponed indefinitely.
+     */
+    void scheduleCheck(QTimer *timer, QElapsedTimer *changedSince, int intervalMs);
+
+    /**
+     * Return true if clipboard owner, formats and timestamp did not change since last check.
+     *
+     * If changes were coming quickly, waits for another check before
+     * fetching all formats.
+     */
+    bool isClipboardStable(const QVariantMap &fingerprint);
+
     bool waitIfSelectionIncomplete();
 
     /**
@@ -71,6 +88,14 @@ private:
     QTimer m_timerResetClipboard;
     QTimer m_timerResetSelection;
 
+    QElapsedTimer m_clipboardChangedSince;
+    QElapsedTimer m_selectionChangedSince;
+
+    /// Owner, available formats and timestamp from last clipboard check.
+    QVariantMap m_clipboardFingerprint;
+    /// Owner, available formats and timestamp of m_clipboardData.
+    QVariantMap m_clipboardDataFingerprint;
+
     QVariantMap m_clipboardData;
     QVariantMap m_selectionData;
 };
@@ -178,6 +178,8 @@ public:
     unsigned char *data;
 };
 
+} // namespace
+
 Window getCurrentWindow(Display *display)
 {
     Q_ASSERT(display);
@@ -194,7 +196,22 @@ Window getCurrentWindow(Display *display)
     return 0L;
 }
 
-} // namespace
+QString getWindowTitle(Display *display, Window window)
+{
+    Q_ASSERT(display);
+
+    static Atom atomName = XInternAtom(display, "_NET_WM_NAME", false);
+    static Atom atomUTF8 = XInternAtom(display, "UTF8_STRING", false);
+
+    X11WindowProperty property(display, window, atomName, 0, (~0L), atomUTF8);
+    if ( property.isValid() ) {
+        const auto len = static_cast<int>(property.len);
+        QByteArray result(reinterpret_cast<const char *>(property.data), len);
+        return QString::fromUtf8(result);
+    }
+
+    return QString();
+}
 
 
 X11PlatformWindow::X11PlatformWindow(const std::shared_ptr<X11DisplayGuard> &d)
@@ -211,21 +228,24 @@ X11PlatformWindow::X11PlatformWindow(const std::shared_ptr<X11DisplayGuard> &d,
     Q_ASSERT(d->display());
 }
 
+X11PlatformWindow::X11PlatformWindow(
+        const std::shared_ptr<X11DisplayGuard> &d, Window winId, const QString &title)
+    : m_window(winId)
+    , m_title(title)
+    , m_hasTitle(true)
+    , d(d)
+{
+    Q_ASSERT(d->display());
+}
+
 QString X11PlatformWindow::getTitle()
 {
     Q_ASSERT( isValid() );
 
-    static Atom atomName = XInternAtom(d->display(), "_NET_WM_NAME", false);
-    static Atom atomUTF8 = XInternAtom(d->display(), "UTF8_STRING", false);
+    if (m_hasTitle)
+        return m_title;
 
-    X11WindowProperty property(d->display(), m_window, atomName, 0, (~0L), atomUTF8);
-    if ( property.isValid() ) {
-        const auto len = static_cast<int>(property.len);
-        QByteArray result(reinterpret_cast<const char *>(property.data), len);
-        return QString::fromUtf8(result);
-    }
-
-    return QString();
+    return getWindowTitle(d->display(), m_window);
 }
 
 void X11PlatformWindow::raise()
@@ -29,6 +29,12 @@
 class QWidget;
 class X11DisplayGuard;
 
+/// Returns active window (_NET_ACTIVE_WINDOW property of root window) or 0.
+Window getCurrentWindow(Display *display);
+
+/// Returns window title (_NET_WM_NAME property).
+QString getWindowTitle(Display *display, Window window);
+
 class X11PlatformWindow : public PlatformWindow
 {
 public:
@@ -36,6 +42,9 @@ public:
 
     X11PlatformWindow(const std::shared_ptr<X11DisplayGuard> &d, Window winId);
 
+    /// Creates window with already known title so getTitle() doesn't need to query it.
+    X11PlatformWindow(const std::shared_ptr<X11DisplayGuard> &d, Window winId, const QString &title);
+
     QString getTitle() override;
 
     void raise() override;
@@ -52,6 +61,8 @@ private:
     void sendKeyPress(int modifier, int key);
 
     Window m_window;
+    QString m_title;
+    bool m_hasTitle = false;
     std::shared_ptr<X11DisplayGuard> d;
 };
 
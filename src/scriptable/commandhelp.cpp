@@ -179,6 +179,10 @@ QList<CommandHelp> commandHelp()
                                           "Arguments are accessible using with \"arguments[0..N]\"."))
                .addArg("[" + Scriptable::tr("SCRIPT") + "]")
                .addArg("[" + Scriptable::tr("ARGUMENTS") + "]...")
+            << CommandHelp("--in-server",
+                           Scriptable::tr("\nRun COMMAND in server process instead of client.\n"
+                                          "Functions changing clipboard monitoring or environment are not available."))
+               .addArg(Scriptable::tr("COMMAND"))
             << CommandHelp("session, -s, --session",
                            Scriptable::tr("\nStarts or connects to application instance with given session name."))
                .addArg(Scriptable::tr("SESSION"))
@@ -511,6 +511,25 @@ QStringList monitorFormatsToSave()
     return factory.formatsToSave();
 }
 
+/**
+ * Returns true if standard input ("-" argument) can be passed to server in
+ * chunks instead of reading it whole in client.
+ */
+bool canStreamInput(const QStringList &args)
+{
+    const int inputIndex = args.indexOf("-");
+    if ( inputIndex == -1 || args.lastIndexOf("-") != inputIndex )
+        return false;
+
+    const int rawIndex = args.indexOf("--");
+    if ( rawIndex != -1 && rawIndex < inputIndex )
+        return false;
+
+    const int commandIndex = args.value(0) == "tab" ? 2 : 0;
+    const auto &command = args.value(commandIndex);
+    return command == "add" || command == "insert" || command == "write" || command == "change";
+}
+
 } // namespace
 
 Scriptable::Scriptable(
@@ -705,13 +724,18 @@ QScriptValue Scriptable::getPlugins()
 {
     // Load plugins on demand.
     if ( !m_plugins.isValid() ) {
-        ItemFactory factory;
-        factory.loadPlugins();
+        QList<ItemScriptable*> scriptableObjects;
+        if (m_sandboxed) {
+            scriptableObjects = m_pluginScriptables;
+        } else {
+            ItemFactory factory;
+            factory.loadPlugins();
 
-        QSettings settings;
-        factory.loadItemFactorySettings(&settings);
+            QSettings settings;
+            factory.loadItemFactorySettings(&settings);
 
-        const auto scriptableObjects = factory.scriptableObjects();
+            scriptableObjects = factory.scriptableObjects();
+        }
 
         m_plugins = m_engine->newObject();
 
@@ -1464,6 +1488,11 @@ QScriptValue Scriptable::info()
                 );
 
     const QString name = arg(0);
+
+    // Startup profile is fetched from server only if needed.
+    if ( m_proxy && (name.isEmpty() || name == "startup") )
+        info.insert("startup", m_proxy->startupProfile());
+
     if (!name.isEmpty())
         return info.value(name);
 
@@ -1475,6 +1504,21 @@ QScriptValue Scriptable::info()
     return result;
 }
 
+QScriptValue Scriptable::actionHistory()
+{
+    return toScriptValue( m_proxy->actionHistory(), this );
+}
+
+QScriptValue Scriptable::tabMemoryUsage()
+{
+    return toScriptValue( m_proxy->tabMemoryUsage(), this );
+}
+
+void Scriptable::saveTabs()
+{
+    m_proxy->saveTabs();
+}
+
 QScriptValue Scriptable::eval()
 {
     const auto script = arg(0);
@@ -1687,6 +1731,19 @@ void Scriptable::resetTestSession()
     m_skipArguments = 1;
     m_proxy->resetTestSession( arg(0) );
 }
+
+void Scriptable::simulateTabWriteCrash()
+{
+    m_skipArguments = 1;
+
+    int bytes;
+    if ( !toInt(argument(0), &bytes) ) {
+        throwError(argumentError());
+        return;
+    }
+
+    m_proxy->simulateTabWriteCrash(bytes);
+}
 #else // HAS_TESTS
 void Scriptable::keys()
 {
@@ -1703,6 +1760,11 @@ void Scriptable::resetTestSession()
 {
     m_skipArguments = 1;
 }
+
+void Scriptable::simulateTabWriteCrash()
+{
+    m_skipArguments = 1;
+}
 #endif // HAS_TESTS
 
 void Scriptable::serverLog()
@@ -2034,6 +2096,9 @@ QScriptValue Scriptable::env()
 QScriptValue Scriptable::setEnv()
 {
     m_skipArguments = 2;
+    if ( !verifyNotSandboxed() )
+        return false;
+
     const QString name = arg(0);
     const QByteArray value = makeByteArray(argument(1));
     return qputenv(name.toUtf8().constData(), value);
@@ -2400,9 +2465,15 @@ void Scriptable::onProvidedSelectionChanged()
         emit finished();
 }
 
+QVariant Scriptable::queryTab(const QString &loaderId, const QString &query, const QVariantList &arguments)
+{
+    return m_proxy->browserQueryTab(loaderId, query, arguments);
+}
+
 bool Scriptable::sourceScriptCommands()
 {
     const auto commands = m_proxy->scriptCommands();
+    m_hasScriptCommands = !commands.isEmpty();
     for (const auto &command : commands) {
         eval(command.cmd, command.name);
         if ( engine()->hasUncaughtException() ) {
@@ -2418,8 +2489,9 @@ bool Scriptable::sourceScriptCommands()
 
 void Scriptable::executeArguments(const QStringList &args)
 {
-    bool hasData;
-    m_actionId = qgetenv("COPYQ_ACTION_ID").toInt(&hasData);
+    bool hasData = m_hasAction && m_actionId != -1;
+    if (!m_hasAction)
+        m_actionId = qgetenv("COPYQ_ACTION_ID").toInt(&hasData);
     const auto actionData = hasData ? m_proxy->getActionData(m_actionId) : QVariantMap();
     m_data = actionData;
 
@@ -2436,11 +2508,17 @@ void Scriptable::executeArguments(const QStringList &args)
              */
         QScriptValueList fnArgs;
         bool readRaw = false;
+        const bool streamInput = canStreamInput(args)
+                && receivers(SIGNAL(streamInput())) > 0
+                && m_proxy->canStreamInput();
         for (const auto &arg : args) {
             if (readRaw) {
                 fnArgs.append( newByteArray(arg.toUtf8()) );
             } else if (arg == "--") {
                 readRaw = true;
+            } else if (arg == "-" && streamInput) {
+                m_streamedInput = newByteArray(QByteArray());
+                fnArgs.append(m_streamedInput);
             } else if (arg == "-") {
                 fnArgs.append( input() );
             } else if (arg == "-e") {
@@ -2455,6 +2533,15 @@ void Scriptable::executeArguments(const QStringList &args)
         if ( !sourceScriptCommands() )
             return;
 
+        // Script commands can override functions which accept streamed input.
+        if ( m_streamedInput.isValid() && m_hasScriptCommands ) {
+            for (auto &arg : fnArgs) {
+                if ( isStreamedInput(arg) )
+                    arg = input();
+            }
+            m_streamedInput = QScriptValue();
+        }
+
         QString cmd;
         QScriptValue result;
 
@@ -2477,6 +2564,10 @@ void Scriptable::executeArguments(const QStringList &args)
             result = result.call( QScriptValue(), fnArgs.mid(skipArguments) );
 
         if ( m_engine->hasUncaughtException() ) {
+            // Server keeps streamed input if the call using it was not reached.
+            if (m_inputStreamed)
+                m_proxy->clearStreamedInput();
+
             const auto exceptionText = processUncaughtException(cmd);
             response = createScriptErrorMessage(exceptionText).toUtf8();
             exitCode = CommandException;
@@ -2498,6 +2589,20 @@ void Scriptable::executeArguments(const QStringList &args)
     COPYQ_LOG("DONE");
 }
 
+void Scriptable::setAction(int actionId, const QString &actionName)
+{
+    m_actionId = actionId;
+    m_actionName = actionName;
+    m_hasAction = true;
+}
+
+void Scriptable::setPluginScriptables(const QList<ItemScriptable*> &scriptables)
+{
+    for (auto obj : scriptables)
+        obj->setParent(this);
+    m_pluginScriptables = scriptables;
+}
+
 void Scriptable::setInput(const QByteArray &input)
 {
     m_input = newByteArray(input);
@@ -2539,7 +2644,7 @@ void Scriptable::showExceptionMessage(const QString &message)
     if (!m_proxy)
         return;
 
-    const auto actionName = getTextData( qgetenv("COPYQ_ACTION_NAME") );
+    const auto actionName = m_hasAction ? m_actionName : getTextData( qgetenv("COPYQ_ACTION_NAME") );
     const auto title = actionName.isEmpty()
         ? tr("Exception")
         : tr("Exception in %1").arg( quoteString(actionName) );
@@ -2658,7 +2763,11 @@ void Scriptable::changeItem(bool create)
         // MIME
         const QString mime = toString(argument(i), this);
         // DATA
-        toItemData( argument(i + 1), mime, &data );
+        const auto value = argument(i + 1);
+        if ( isStreamedInput(value) )
+            setStreamedInputMime(mime, &data);
+        else
+            toItemData(value, mime, &data);
     }
 
     if (create) {
@@ -2869,8 +2978,34 @@ bool Scriptable::canExecuteCommandFilter(const QString &matchCommand)
     return runAction(&action) && action.exitCode() == 0;
 }
 
+bool Scriptable::isStreamedInput(const QScriptValue &value) const
+{
+    return m_streamedInput.isValid() && value.strictlyEquals(m_streamedInput);
+}
+
+void Scriptable::setStreamedInputMime(const QString &mime, QVariantMap *data)
+{
+    // Server sets the format to data received with appendStreamedInput().
+    data->insert(mimeStreamedInput, mime);
+    emit streamInput();
+    m_streamedInput = QScriptValue();
+    m_inputStreamed = true;
+}
+
+bool Scriptable::verifyNotSandboxed()
+{
+    if (!m_sandboxed)
+        return true;
+
+    throwError("Function is not available in server");
+    return false;
+}
+
 bool Scriptable::verifyClipboardAccess()
 {
+    if ( !verifyNotSandboxed() )
+        return false;
+
     if ( qobject_cast<QApplication*>(qApp) != nullptr )
         return true;
 
@@ -2918,7 +3053,10 @@ void Scriptable::insert(int row, int argumentsBegin, int argumentsEnd)
 
     for (int i = argumentsBegin; i < argumentsEnd; ++i) {
         const auto arg = argument(i);
-        if ( arg.isObject() && arg.scriptClass() != byteArrayClass() && !arg.isArray() )
+        if ( isStreamedInput(arg) ) {
+            items.append(QVariantMap());
+            setStreamedInputMime(mimeText, &items.last());
+        } else if ( arg.isObject() && arg.scriptClass() != byteArrayClass() && !arg.isArray() )
             items.append( fromScriptValue<QVariantMap>(arg, this) );
         else
             items.append( createDataMap(mimeText, toString(arg, this)) );
@@ -37,6 +37,7 @@ class ClipboardBrowser;
 class DirClass;
 class FileClass;
 class ItemFactory;
+class ItemScriptable;
 class ScriptableProxy;
 class TemporaryFileClass;
 
@@ -151,6 +152,24 @@ public:
 
     void executeArguments(const QStringList &args);
 
+    /**
+     * Set action instead of using COPYQ_ACTION_ID and COPYQ_ACTION_NAME
+     * environment variables (used if script runs in server).
+     */
+    void setAction(int actionId, const QString &actionName);
+
+    /**
+     * Disallow functions which would change the process running the script
+     * (e.g. environment variables, providing or monitoring clipboard).
+     */
+    void setSandboxed(bool sandboxed) { m_sandboxed = sandboxed; }
+
+    /**
+     * Use given plugin script objects instead of loading plugins again
+     * (used if script runs in server). Takes ownership of the objects.
+     */
+    void setPluginScriptables(const QList<ItemScriptable*> &scriptables);
+
 public slots:
     void setInput(const QByteArray &input);
 
@@ -224,6 +243,10 @@ public slots:
 
     QScriptValue info();
 
+    QScriptValue actionHistory();
+    QScriptValue tabMemoryUsage();
+    void saveTabs();
+
     QScriptValue eval();
 
     QScriptValue source();
@@ -247,6 +270,7 @@ public slots:
     void keys();
     QScriptValue testSelected();
     void resetTestSession();
+    void simulateTabWriteCrash();
     void serverLog();
 
     void setCurrentTab();
@@ -357,6 +381,7 @@ signals:
     void dataReceived();
     void finished();
     void readInput();
+    void streamInput();
 
 private slots:
     void onExecuteOutput(const QByteArray &output);
@@ -364,6 +389,9 @@ private slots:
     void onProvidedClipboardChanged();
     void onProvidedSelectionChanged();
 
+    // Called from plugin scripts (ItemScriptable::queryTab()).
+    QVariant queryTab(const QString &loaderId, const QString &query, const QVariantList &arguments);
+
 private:
     bool sourceScriptCommands();
     void callDisplayFunctions(QScriptValueList displayFunctions);
@@ -372,6 +400,9 @@ private:
     QVector<int> getRows() const;
     QScriptValue copy(ClipboardMode mode);
     bool setClipboard(QVariantMap *data, ClipboardMode mode);
+    bool verifyNotSandboxed();
+    bool isStreamedInput(const QScriptValue &value) const;
+    void setStreamedInputMime(const QString &mime, QVariantMap *data);
     void changeItem(bool create);
     void nextToClipboard(int where);
     QScriptValue screenshot(bool select);
@@ -396,8 +427,14 @@ private:
     TemporaryFileClass *m_temporaryFileClass;
     QString m_inputSeparator;
     QScriptValue m_input;
+    /// Placeholder for "-" argument which is passed directly to server.
+    QScriptValue m_streamedInput;
+    bool m_hasScriptCommands = false;
     QVariantMap m_data;
     int m_actionId = -1;
+    QString m_actionName;
+    bool m_hasAction = false;
+    bool m_sandboxed = false;
     bool m_connected;
     int m_skipArguments = 0;
 
@@ -409,6 +446,8 @@ private:
     bool m_displayFunctionsLock = false;
 
     QScriptValue m_plugins;
+    QList<ItemScriptable*> m_pluginScriptables;
+    bool m_inputStreamed = false;
 };
 
 class NetworkReply : public QObject {
@@ -21,6 +21,7 @@
 
 #include "common/appconfig.h"
 #include "common/command.h"
+#include "common/commandstatus.h"
 #include "common/commandstore.h"
 #include "common/common.h"
 #include "common/config.h"
@@ -38,6 +39,8 @@
 #include "gui/notification.h"
 #include "gui/tabicons.h"
 #include "gui/windowgeometryguard.h"
+#include "item/blobstore.h"
+#include "item/itemstore.h"
 #include "item/serialize.h"
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
@@ -57,6 +60,7 @@
 #include <QDialogButtonBox>
 #include <QFile>
 #include <QFileDialog>
+#include <QHash>
 #include <QWidget>
 #include <QLabel>
 #include <QLineEdit>
@@ -72,6 +76,8 @@
 #include <QSpinBox>
 #include <QTextEdit>
 
+#include <memory>
+#include <tuple>
 #include <type_traits>
 
 #define BROWSER(call) \
@@ -81,20 +87,54 @@
 
 #define STR(str) str
 
+#define FUNCTION_CALL_ID(function, arguments) \
+    std::integral_constant<quint32, functionCallId( \
+        STR(#function), std::tuple_size<decltype(std::make_tuple arguments)>::value )>::value
+
 #define INVOKE(function, arguments) \
     if (!m_wnd) { \
         using Result = decltype(function arguments); \
+        if (m_callFunctionsInMainThread) { \
+            const auto result = std::make_shared<Result>(); \
+            const QString tabName = m_tabName; \
+            emit callInMainThread([=](ScriptableProxy *proxy) { \
+                proxy->m_tabName = tabName; \
+                *result = proxy->function arguments; \
+            }); \
+            return *result; \
+        } \
+        if ( hasTypedFunctionCalls() ) { \
+            TypedFunctionCallSerializer f(FUNCTION_CALL_ID(function, arguments), m_tabName); \
+            f.setArguments arguments; \
+            emit sendFunctionCall(f.serialize(), CommandTypedFunctionCall); \
+            return typedReturnValue<Result>(); \
+        } \
         FunctionCallSerializer f(m_tabName, STR(#function), QVariant::fromValue(Result())); \
         f.setArguments arguments; \
-        emit sendFunctionCall(f.serialize()); \
-        return m_returnValue.value<Result>(); \
+        emit sendFunctionCall(f.serialize(), CommandFunctionCall); \
+        return legacyReturnValue<Result>(); \
     }
 
 #define INVOKE2(function, arguments) \
     if (!m_wnd) { \
+        if (m_callFunctionsInMainThread) { \
+            const QString tabName = m_tabName; \
+            emit callInMainThread([=](ScriptableProxy *proxy) { \
+                proxy->m_tabName = tabName; \
+                proxy->function arguments; \
+            }); \
+            return; \
+        } \
+        if ( hasTypedFunctionCalls() ) { \
+            TypedFunctionCallSerializer f(FUNCTION_CALL_ID(function, arguments), m_tabName); \
+            f.setArguments arguments; \
+            emit sendFunctionCall(f.serialize(), CommandTypedFunctionCall); \
+            return; \
+        } \
         FunctionCallSerializer f(m_tabName, STR(#function)); \
         f.setArguments arguments; \
-        emit sendFunctionCall(f.serialize()); \
+        emit sendFunctionCall(f.serialize(), CommandFunctionCall); \
+        legacyReturnVariant(); \
         return; \
     }
 
@@ -230,6 +270,9 @@ const char propertyWidgetProperty[] = "CopyQ_widget_property";
 
 const int noReturnType = -1;
 
+/// Increase when layout of typed function calls changes.
+const int typedFunctionCallProtocolVersion = 1;
+
 struct InputDialog {
     QDialog dialog;
     QString defaultChoice; /// Default text for list widgets.
@@ -264,6 +307,283 @@ private:
     QVector<QVariant> m_args;
 };
 
+/**
+ * Function call ID computed at compile time from function name and number of
+ * arguments (FNV-1a hash).
+ */
+constexpr quint32 functionCallIdHash(const char *name, quint32 hash)
+{
+    return *name == '\0'
+            ? hash
+            : functionCallIdHash( name + 1, (hash ^ static_cast<quint8>(*name)) * 16777619u );
+}
+
+constexpr quint32 functionCallId(const char *functionName, std::size_t argumentCount)
+{
+    return (functionCallIdHash(functionName, 2166136261u) ^ static_cast<quint32>(argumentCount)) * 16777619u;
+}
+
+template <typename T>
+void writeValue(QDataStream *out, const T &value)
+{
+    *out << value;
+}
+
+template <typename T>
+void writeValue(QDataStream *out, const QFlags<T> &value)
+{
+    *out << static_cast<int>(value);
+}
+
+template <typename T>
+void readValue(QDataStream *in, T *value)
+{
+    *in >> *value;
+}
+
+template <typename T>
+void readValue(QDataStream *in, QFlags<T> *value)
+{
+    int flags = 0;
+    *in >> flags;
+    *value = QFlags<T>(QFlag(flags));
+}
+
+/**
+ * Serializes function call without wrapping arguments in QVariant.
+ *
+ * Server reads the arguments with types from ScriptableProxy member function
+ * with the same ID (see TypedFunctionCall).
+ */
+class TypedFunctionCallSerializer {
+public:
+    TypedFunctionCallSerializer(quint32 functionId, const QString &tabName)
+        : m_stream(&m_bytes, QIODevice::WriteOnly)
+    {
+        m_stream << functionId << tabName;
+    }
+
+    QByteArray serialize() const
+    {
+        return m_bytes;
+    }
+
+    void setArguments() {}
+
+    template<typename T, typename ...Ts>
+    void setArguments(const T &head, const Ts&... args)
+    {
+        writeValue(&m_stream, head);
+        setArguments(args...);
+    }
+
+private:
+    QByteArray m_bytes;
+    QDataStream m_stream;
+};
+
+template <int...>
+struct IndexSequence {};
+
+template <int N, int ...Is>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Is...> {};
+
+template <int ...Is>
+struct MakeIndexSequence<0, Is...> {
+    using Type = IndexSequence<Is...>;
+};
+
+template <typename Tuple, int ...Is>
+void readArguments(QDataStream *in, Tuple *args, IndexSequence<Is...>)
+{
+    const int unused[] = {0, (readValue(in, &std::get<Is>(*args)), 0)...};
+    Q_UNUSED(unused);
+}
+
+template <typename Function>
+struct FunctionArity;
+
+template <typename Result, typename ...Arguments>
+struct FunctionArity<Result (ScriptableProxy::*)(Arguments...)> {
+    static constexpr std::size_t value = sizeof...(Arguments);
+};
+
+/// Reads arguments, calls ScriptableProxy member function and writes the result.
+template <typename Function, Function function>
+struct TypedFunctionCall;
+
+template <typename Result, typename ...Arguments, Result (ScriptableProxy::*function)(Arguments...)>
+struct TypedFunctionCall<Result (ScriptableProxy::*)(Arguments...), function> {
+    using Indexes = typename MakeIndexSequence<sizeof...(Arguments)>::Type;
+    using ArgumentTuple = std::tuple<typename std::decay<Arguments>::type...>;
+
+    static bool call(ScriptableProxy *proxy, QDataStream *in, QDataStream *out)
+    {
+        ArgumentTuple args;
+        readArguments(in, &args, Indexes());
+        if (in->status() != QDataStream::Ok)
+            return false;
+
+        writeValue( out, callWithArguments(proxy, &args, Indexes()) );
+        return true;
+    }
+
+    template <int ...Is>
+    static Result callWithArguments(ScriptableProxy *proxy, ArgumentTuple *args, IndexSequence<Is...>)
+    {
+        return (proxy->*function)(std::get<Is>(*args)...);
+    }
+};
+
+template <typename ...Arguments, void (ScriptableProxy::*function)(Arguments...)>
+struct TypedFunctionCall<void (ScriptableProxy::*)(Arguments...), function> {
+    using Indexes = typename MakeIndexSequence<sizeof...(Arguments)>::Type;
+    using ArgumentTuple = std::tuple<typename std::decay<Arguments>::type...>;
+
+    static bool call(ScriptableProxy *proxy, QDataStream *in, QDataStream *)
+    {
+        ArgumentTuple args;
+        readArguments(in, &args, Indexes());
+        if (in->status() != QDataStream::Ok)
+            return false;
+
+        callWithArguments(proxy, &args, Indexes());
+        return true;
+    }
+
+    template <int ...Is>
+    static void callWithArguments(ScriptableProxy *proxy, ArgumentTuple *args, IndexSequence<Is...>)
+    {
+        (proxy->*function)(std::get<Is>(*args)...);
+    }
+};
+
+using TypedFunction = bool (*)(ScriptableProxy *proxy, QDataStream *in, QDataStream *out);
+
+// Asserts that function call IDs (hashes) do not collide.
+#define TYPED_OVERLOADED_FUNCTION(name, ...) \
+    do { \
+        const quint32 id = functionCallId(STR(#name), FunctionArity<__VA_ARGS__>::value); \
+        Q_ASSERT( !functions.contains(id) ); \
+        functions.insert( id, &TypedFunctionCall<__VA_ARGS__, &ScriptableProxy::name>::call ); \
+    } while (false)
+
+#define TYPED_FUNCTION(name) \
+    TYPED_OVERLOADED_FUNCTION(name, decltype(&ScriptableProxy::name))
+
+/// Creates map from function call IDs to functions callable from client.
+QHash<quint32, TypedFunction> createTypedFunctions()
+{
+    QHash<quint32, TypedFunction> functions;
+
+    TYPED_FUNCTION(getActionData);
+    TYPED_FUNCTION(setActionData);
+    TYPED_FUNCTION(exit);
+    TYPED_FUNCTION(close);
+    TYPED_FUNCTION(showWindow);
+    TYPED_FUNCTION(showWindowAt);
+    TYPED_FUNCTION(pasteToCurrentWindow);
+    TYPED_FUNCTION(copyFromCurrentWindow);
+    TYPED_FUNCTION(isMonitoringEnabled);
+    TYPED_FUNCTION(isMainWindowVisible);
+    TYPED_FUNCTION(isMainWindowFocused);
+    TYPED_FUNCTION(disableMonitoring);
+    TYPED_FUNCTION(setClipboard);
+    TYPED_FUNCTION(renameTab);
+    TYPED_FUNCTION(removeTab);
+    TYPED_FUNCTION(tabIcon);
+    TYPED_FUNCTION(setTabIcon);
+    TYPED_FUNCTION(showBrowser);
+    TYPED_FUNCTION(showBrowserAt);
+    TYPED_FUNCTION(showCurrentBrowser);
+    TYPED_FUNCTION(action);
+    TYPED_FUNCTION(showMessage);
+    TYPED_FUNCTION(nextItem);
+    TYPED_FUNCTION(browserMoveToClipboard);
+    TYPED_FUNCTION(browserSetCurrent);
+    TYPED_FUNCTION(browserRemoveRows);
+    TYPED_FUNCTION(browserEditRow);
+    TYPED_FUNCTION(browserEditNew);
+    TYPED_FUNCTION(tabs);
+    TYPED_FUNCTION(toggleVisible);
+    TYPED_FUNCTION(toggleMenu);
+    TYPED_FUNCTION(toggleCurrentMenu);
+    TYPED_FUNCTION(findTabIndex);
+    TYPED_FUNCTION(openActionDialog);
+    TYPED_FUNCTION(loadTab);
+    TYPED_FUNCTION(saveTab);
+    TYPED_FUNCTION(importData);
+    TYPED_FUNCTION(exportData);
+    TYPED_FUNCTION(config);
+    TYPED_FUNCTION(toggleConfig);
+    TYPED_FUNCTION(getClipboardData);
+    TYPED_FUNCTION(hasClipboardFormat);
+    TYPED_FUNCTION(browserLength);
+    TYPED_FUNCTION(browserOpenEditor);
+    TYPED_FUNCTION(appendStreamedInput);
+    TYPED_FUNCTION(clearStreamedInput);
+    TYPED_FUNCTION(browserInsert);
+    TYPED_FUNCTION(browserChange);
+    TYPED_OVERLOADED_FUNCTION(browserItemData, QByteArray (ScriptableProxy::*)(int, const QString &));
+    TYPED_OVERLOADED_FUNCTION(browserItemData, QVariantMap (ScriptableProxy::*)(int));
+    TYPED_FUNCTION(browserQueryTab);
+    TYPED_FUNCTION(setCurrentTab);
+    TYPED_FUNCTION(tab);
+    TYPED_FUNCTION(currentItem);
+    TYPED_FUNCTION(selectItems);
+    TYPED_FUNCTION(selectedItems);
+    TYPED_FUNCTION(selectedItemsDataCount);
+    TYPED_FUNCTION(selectedItemData);
+    TYPED_FUNCTION(setSelectedItemData);
+    TYPED_FUNCTION(selectedItemsData);
+    TYPED_OVERLOADED_FUNCTION(setSelectedItemsData, void (ScriptableProxy::*)(const QVector<QVariantMap> &));
+#ifdef HAS_TESTS
+    TYPED_FUNCTION(sendKeys);
+    TYPED_FUNCTION(keysSent);
+    TYPED_FUNCTION(testSelected);
+    TYPED_FUNCTION(resetTestSession);
+    TYPED_FUNCTION(simulateTabWriteCrash);
+#endif // HAS_TESTS
+    TYPED_FUNCTION(serverLog);
+    TYPED_FUNCTION(currentWindowTitle);
+    TYPED_FUNCTION(inputDialog);
+    TYPED_FUNCTION(setUserValue);
+    TYPED_OVERLOADED_FUNCTION(setSelectedItemsData, void (ScriptableProxy::*)(const QString &, const QVariant &));
+    TYPED_FUNCTION(filter);
+    TYPED_FUNCTION(commands);
+    TYPED_FUNCTION(setCommands);
+    TYPED_FUNCTION(addCommands);
+    TYPED_FUNCTION(screenshot);
+    TYPED_FUNCTION(screenNames);
+    TYPED_FUNCTION(queryKeyboardModifiers);
+    TYPED_FUNCTION(pluginsPath);
+    TYPED_FUNCTION(themesPath);
+    TYPED_FUNCTION(translationsPath);
+    TYPED_FUNCTION(startupProfile);
+    TYPED_FUNCTION(actionHistory);
+    TYPED_FUNCTION(tabMemoryUsage);
+    TYPED_FUNCTION(saveTabs);
+    TYPED_FUNCTION(iconColor);
+    TYPED_FUNCTION(setIconColor);
+    TYPED_FUNCTION(iconTag);
+    TYPED_FUNCTION(setIconTag);
+    TYPED_FUNCTION(iconTagColor);
+    TYPED_FUNCTION(setIconTagColor);
+    TYPED_FUNCTION(setClipboardData);
+    TYPED_FUNCTION(setTitle);
+    TYPED_FUNCTION(setTitleForData);
+    TYPED_FUNCTION(saveData);
+    TYPED_FUNCTION(showDataNotification);
+    TYPED_FUNCTION(menuItemMatchCommands);
+    TYPED_FUNCTION(enableMenuItem);
+    TYPED_FUNCTION(setDisplayData);
+    TYPED_FUNCTION(automaticCommands);
+    TYPED_FUNCTION(displayCommands);
+    TYPED_FUNCTION(scriptCommands);
+
+    return functions;
+}
+
 class ScreenshotRectWidget : public QLabel {
 public:
     explicit ScreenshotRectWidget(const QPixmap &pixmap)
@@ -548,6 +868,14 @@ void raiseWindow(QWidget *window)
         platformWindow->raise();
 }
 
+/// Sets streamed input for format given by mimeStreamedInput.
+void setStreamedInput(QVariantMap *data, const QByteArray &streamedInput)
+{
+    const auto mime = data->take(mimeStreamedInput).toString();
+    if ( !mime.isEmpty() )
+        data->insert(mime, streamedInput);
+}
+
 } // namespace
 
 ScriptableProxy::ScriptableProxy(MainWindow *mainWindow, QObject *parent)
@@ -605,19 +933,121 @@ QByteArray ScriptableProxy::callFunction(const QByteArray &serializedFunctionCal
         Q_ASSERT(ok);
     }
 
+    // Older clients ignore the protocol version after the return value.
     QByteArray bytes;
     {
         QDataStream stream(&bytes, QIODevice::WriteOnly);
-        stream << returnValue;
+        stream << returnValue << typedFunctionCallProtocolVersion;
     }
 
     return bytes;
 }
 
+bool ScriptableProxy::callTypedFunction(const QByteArray &serializedFunctionCall, QByteArray *result)
+{
+    static const QHash<quint32, TypedFunction> functions = createTypedFunctions();
+
+    QDataStream in(serializedFunctionCall);
+    quint32 functionId;
+    in >> functionId >> m_tabName;
+    if (in.status() != QDataStream::Ok) {
+        log("Failed to read function call from client", LogError);
+        return false;
+    }
+
+    const auto function = functions.value(functionId);
+    if (!function) {
+        log( QString("Unknown function call ID: %1").arg(functionId), LogError );
+        return false;
+    }
+
+    QDataStream out(result, QIODevice::WriteOnly);
+    if ( !function(this, &in, &out) ) {
+        log( QString("Failed to read arguments for function call ID: %1").arg(functionId), LogError );
+        return false;
+    }
+
+    return true;
+}
+
 void ScriptableProxy::setReturnValue(const QByteArray &returnValue)
 {
-    QDataStream stream(returnValue);
-    stream >> m_returnValue;
+    m_returnValue = returnValue;
+}
+
+bool ScriptableProxy::canStreamInput()
+{
+    if (m_wnd || m_callFunctionsInMainThread)
+        return true;
+
+    // Ask server explicitly only if no function was called yet.
+    if (m_functionCallProtocolVersion == -1)
+        setFunctionCallProtocolVersion( functionCallProtocolVersion() );
+
+    return hasTypedFunctionCalls();
+}
+
+bool ScriptableProxy::takeStreamedInput(QByteArray *streamedInput)
+{
+    const auto writer = std::move(m_streamedInput);
+    return !writer || writer->take(streamedInput);
+}
+
+bool ScriptableProxy::hasTypedFunctionCalls()
+{
+    // Until the server replies with supported protocol version, functions
+    // are called with QVariant-based codec which all servers support.
+    return m_functionCallProtocolVersion == typedFunctionCallProtocolVersion;
+}
+
+void ScriptableProxy::setFunctionCallProtocolVersion(int version)
+{
+    m_functionCallProtocolVersion = qgetenv("COPYQ_LEGACY_FUNCTION_CALLS") == "1" ? 0 : version;
+}
+
+QVariant ScriptableProxy::legacyReturnVariant()
+{
+    QVariant value;
+    QDataStream stream(m_returnValue);
+    stream >> value;
+
+    // Newer servers append supported protocol version (see callFunction()).
+    if (m_functionCallProtocolVersion == -1) {
+        int version = 0;
+        stream >> version;
+        setFunctionCallProtocolVersion(stream.status() == QDataStream::Ok ? version : 0);
+    }
+
+    return value;
+}
+
+template <typename T>
+T ScriptableProxy::typedReturnValue()
+{
+    T value = T();
+    QDataStream stream(m_returnValue);
+    readValue(&stream, &value);
+    return value;
+}
+
+template <typename T>
+T ScriptableProxy::legacyReturnValue()
+{
+    return legacyReturnVariant().value<T>();
+}
+
+int ScriptableProxy::functionCallProtocolVersion()
+{
+    if (!m_wnd) {
+        FunctionCallSerializer f(m_tabName, "functionCallProtocolVersion", QVariant::fromValue(0));
+        emit sendFunctionCall(f.serialize(), CommandFunctionCall);
+        QVariant value;
+        QDataStream stream(m_returnValue);
+        stream >> value;
+        return value.toInt();
+    }
+
+    return typedFunctionCallProtocolVersion;
 }
 
 QVariantMap ScriptableProxy::getActionData(int id)
@@ -1007,10 +1437,31 @@ bool ScriptableProxy::browserOpenEditor(const QByteArray &arg1, bool changeClipb
     return c && c->openEditor(arg1, changeClipboard);
 }
 
+void ScriptableProxy::appendStreamedInput(const QByteArray &chunk)
+{
+    INVOKE2(appendStreamedInput, (chunk));
+
+    // Big input is written to data store right away instead of keeping it in memory.
+    if (!m_streamedInput)
+        m_streamedInput = std::make_shared<BlobWriter>( BlobStore::instance() );
+    m_streamedInput->append(chunk);
+}
+
+void ScriptableProxy::clearStreamedInput()
+{
+    INVOKE2(clearStreamedInput, ());
+    m_streamedInput.reset();
+}
+
 QString ScriptableProxy::browserInsert(int row, const QVector<QVariantMap> &items)
 {
     INVOKE(browserInsert, (row, items));
 
+    // Streamed input belongs to this call even if it fails.
+    QByteArray streamedInput;
+    if ( !takeStreamedInput(&streamedInput) )
+        return "Failed to store input";
+
     ClipboardBrowser *c = fetchBrowser();
     if (!c)
         return "Invalid tab";
@@ -1018,7 +1469,8 @@ QString ScriptableProxy::browserInsert(int row, const QVector<QVariantMap> &item
     if ( !c->allocateSpaceForNewItems(items.size()) )
         return "Tab is full (cannot remove any items)";
 
-    for (const auto &item : items) {
+    for (auto item : items) {
+        setStreamedInput(&item, streamedInput);
         if ( !c->add(item, row) )
             return "Failed to new add items";
     }
@@ -1029,13 +1481,22 @@ QString ScriptableProxy::browserInsert(int row, const QVector<QVariantMap> &item
 bool ScriptableProxy::browserChange(const QVariantMap &data, int row)
 {
     INVOKE(browserChange, (data, row));
+
+    // Streamed input belongs to this call even if it fails.
+    QByteArray streamedInput;
+    if ( !takeStreamedInput(&streamedInput) )
+        return false;
+
     ClipboardBrowser *c = fetchBrowser();
     if (!c)
         return false;
 
+    QVariantMap newData = data;
+    setStreamedInput(&newData, streamedInput);
+
     const auto index = c->index(row);
     QVariantMap itemData = c->model()->data(index, contentType::data).toMap();
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+    for (auto it = newData.constBegin(); it != newData.constEnd(); ++it) {
         if ( it.value().isValid() )
             itemData.insert( it.key(), it.value() );
         else
@@ -1057,6 +1518,13 @@ QVariantMap ScriptableProxy::browserItemData(int arg1)
     return itemData(arg1);
 }
 
+QVariant ScriptableProxy::browserQueryTab(const QString &loaderId, const QString &query, const QVariantList &arguments)
+{
+    INVOKE(browserQueryTab, (loaderId, query, arguments));
+    ClipboardBrowser *c = fetchBrowser();
+    return c ? c->queryTab(loaderId, query, arguments) : QVariant();
+}
+
 void ScriptableProxy::setCurrentTab(const QString &tabName)
 {
     INVOKE2(setCurrentTab, (tabName));
@@ -1253,6 +1721,12 @@ void ScriptableProxy::resetTestSession(const QString &clipboardTabName)
     INVOKE2(resetTestSession, (clipboardTabName));
     m_wnd->resetTestSession(clipboardTabName);
 }
+
+void ScriptableProxy::simulateTabWriteCrash(int bytes)
+{
+    INVOKE2(simulateTabWriteCrash, (bytes));
+    setItemFileWriteCrashAfter(bytes);
+}
 #endif // HAS_TESTS
 
 void ScriptableProxy::serverLog(const QString &text)
@@ -1510,6 +1984,30 @@ QString ScriptableProxy::translationsPath()
     return ::translationsPath();
 }
 
+QString ScriptableProxy::startupProfile()
+{
+    INVOKE(startupProfile, ());
+    return qApp->property("CopyQ_startup_profile").toString();
+}
+
+QVector<QVariantMap> ScriptableProxy::actionHistory()
+{
+    INVOKE(actionHistory, ());
+    return m_wnd->actionHistory();
+}
+
+QVariantList ScriptableProxy::tabMemoryUsage()
+{
+    INVOKE(tabMemoryUsage, ());
+    return m_wnd->tabMemoryUsage();
+}
+
+void ScriptableProxy::saveTabs()
+{
+    INVOKE2(saveTabs, ());
+    m_wnd->saveTabs();
+}
+
 QString ScriptableProxy::iconColor()
 {
     INVOKE(iconColor, ());
@@ -32,8 +32,10 @@
 #include <QVariant>
 #include <QVector>
 
+#include <functional>
 #include <memory>
 
+class BlobWriter;
 class ClipboardBrowser;
 class MainWindow;
 class QPersistentModelIndex;
@@ -76,6 +78,13 @@ QDataStream &operator>>(QDataStream &in, ClipboardMode &mode);
 QDataStream &operator<<(QDataStream &out, const ScriptablePath &path);
 QDataStream &operator>>(QDataStream &in, ScriptablePath &path);
 
+class ScriptableProxy;
+
+/// Function call passed to ScriptableProxy in main thread.
+using ScriptableProxyCall = std::function<void(ScriptableProxy*)>;
+
+Q_DECLARE_METATYPE(ScriptableProxyCall)
+
 class ScriptableProxy : public QObject
 {
     Q_OBJECT
@@ -86,11 +95,41 @@ public:
 
     QByteArray callFunction(const QByteArray &serializedFunctionCall);
 
+    /**
+     * Call function serialized by client with typed function call codec.
+     *
+     * Returns false (and logs the error) if the function is unknown or
+     * the arguments cannot be read.
+     */
+    bool callTypedFunction(const QByteArray &serializedFunctionCall, QByteArray *result);
+
     int actionId() const { return m_actionId; }
 
+    /// Returns true if server handles appendStreamedInput().
+    bool canStreamInput();
+
+    /**
+     * Pass function calls to proxy in main thread of server without
+     * serializing them (see callInMainThread()).
+     *
+     * Used for scripts running in other thread of server.
+     */
+    void setCallFunctionsInMainThread() { m_callFunctionsInMainThread = true; }
+
 public slots:
     void setReturnValue(const QByteArray &returnValue);
 
+    /**
+     * Returns version of typed function call protocol supported by server.
+     *
+     * Older servers cannot call this function and return 0 (only
+     * QVariant-based function calls are supported).
+     *
+     * Client needs to call this only if no other function was called yet,
+     * otherwise the version is read from reply to the first function call.
+     */
+    int functionCallProtocolVersion();
+
     QVariantMap getActionData(int id);
     void setActionData(int id, const QVariantMap &data);
 
@@ -160,11 +199,23 @@ public slots:
     int browserLength();
     bool browserOpenEditor(const QByteArray &arg1, bool changeClipboard);
 
+    /**
+     * Append chunk of client's standard input.
+     *
+     * Data is used for item format given by mimeStreamedInput in next
+     * browserInsert() or browserChange() call.
+     */
+    void appendStreamedInput(const QByteArray &chunk);
+
+    /// Drop streamed input if it won't be used (e.g. script failed).
+    void clearStreamedInput();
+
     QString browserInsert(int row, const QVector<QVariantMap> &items);
     bool browserChange(const QVariantMap &data, int row);
 
     QByteArray browserItemData(int arg1, const QString &arg2);
     QVariantMap browserItemData(int arg1);
+    QVariant browserQueryTab(const QString &loaderId, const QString &query, const QVariantList &arguments);
 
     void setCurrentTab(const QString &tabName);
 
@@ -189,6 +240,7 @@ public slots:
     bool keysSent();
     QString testSelected();
     void resetTestSession(const QString &clipboardTabName);
+    void simulateTabWriteCrash(int bytes);
 #endif // HAS_TESTS
 
     void serverLog(const QString &text);
@@ -216,6 +268,11 @@ public slots:
     QString pluginsPath();
     QString themesPath();
     QString translationsPath();
+    QString startupProfile();
+
+    QVector<QVariantMap> actionHistory();
+    QVariantList tabMemoryUsage();
+    void saveTabs();
 
     QString iconColor();
     bool setIconColor(const QString &name);
@@ -242,7 +299,10 @@ public slots:
     QVector<Command> scriptCommands();
 
 signals:
-    void sendFunctionCall(const QByteArray &bytes);
+    void sendFunctionCall(const QByteArray &bytes, int messageCode);
+
+    /// Function call to be made with proxy in main thread; emitted synchronously.
+    void callInMainThread(const ScriptableProxyCall &call);
 
 private:
     ClipboardBrowser *fetchBrowser(const QString &tabName);
@@ -254,14 +314,30 @@ private:
     ClipboardBrowser *currentBrowser() const;
     QList<QPersistentModelIndex> selectedIndexes() const;
 
+    bool takeStreamedInput(QByteArray *streamedInput);
+
+    bool hasTypedFunctionCalls();
+    void setFunctionCallProtocolVersion(int version);
+
+    QVariant legacyReturnVariant();
+
+    template <typename T>
+    T typedReturnValue();
+
+    template <typename T>
+    T legacyReturnValue();
+
     MainWindow* m_wnd;
     QString m_tabName;
     QVariantMap m_actionData;
+    std::shared_ptr<BlobWriter> m_streamedInput;
     int m_actionId = -1;
 
     uint m_sentKeyClicks = 0;
 
-    QVariant m_returnValue;
+    QByteArray m_returnValue;
+    int m_functionCallProtocolVersion = -1;
+    bool m_callFunctionsInMainThread = false;
 };
 
 QString pluginsPath();
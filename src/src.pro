@@ -32,10 +32,14 @@ HEADERS += \
     app/clipboardclient.h \
     app/clipboardmonitor.h \
     app/clipboardserver.h \
+    app/serverscriptrunner.h \
     common/action.h \
     common/actionoutput.h \
+    common/atomicfile.h \
+    common/builtincommand.h \
     common/client_server.h \
     common/clientsocket.h \
+    common/clipboarddatalimits.h \
     common/command.h \
     common/common.h \
     common/contenttype.h \
@@ -46,6 +50,9 @@ HEADERS += \
     gui/aboutdialog.h \
     gui/actiondialog.h \
     gui/actionhandler.h \
+    gui/actionhistory.h \
+    gui/actionscheduler.h \
+    gui/builtincommandrunner.h \
     gui/clipboardbrowser.h \
     gui/clipboardbrowserplaceholder.h \
     gui/clipboarddialog.h \
@@ -68,14 +75,17 @@ HEADERS += \
     gui/notificationdaemon.h \
     gui/notification.h \
     gui/pluginwidget.h \
+    gui/savescheduler.h \
     gui/shortcutbutton.h \
     gui/shortcutdialog.h \
     gui/shortcutswidget.h \
     gui/tabbar.h \
     gui/tabdialog.h \
+    gui/tabresidencymanager.h \
     gui/tabtree.h \
     gui/tabwidget.h \
     gui/traymenu.h \
+    item/blobstore.h \
     item/clipboarditem.h \
     item/clipboardmodel.h \
     item/itemdelegate.h \
@@ -83,6 +93,7 @@ HEADERS += \
     item/itemeditorwidget.h \
     item/itemfactory.h \
     item/itemwidget.h \
+    item/pagedtexteditor.h \
     item/persistentdisplayitem.h \
     item/serialize.h \
     platform/dummy/dummyplatform.h \
@@ -134,10 +145,14 @@ SOURCES += \
     app/clipboardclient.cpp \
     app/clipboardmonitor.cpp \
     app/clipboardserver.cpp \
+    app/serverscriptrunner.cpp \
     common/action.cpp \
     common/actionoutput.cpp \
+    common/atomicfile.cpp \
+    common/builtincommand.cpp \
     common/client_server.cpp \
     common/clientsocket.cpp \
+    common/clipboarddatalimits.cpp \
     common/common.cpp \
     common/commandstore.cpp \
     common/display.cpp \
@@ -151,6 +166,9 @@ SOURCES += \
     gui/aboutdialog.cpp \
     gui/actiondialog.cpp \
     gui/actionhandler.cpp \
+    gui/actionhistory.cpp \
+    gui/actionscheduler.cpp \
+    gui/builtincommandrunner.cpp \
     gui/clipboardbrowser.cpp \
     gui/clipboardbrowserplaceholder.cpp \
     gui/clipboarddialog.cpp \
@@ -172,14 +190,17 @@ SOURCES += \
     gui/notification.cpp \
     gui/notificationdaemon.cpp \
     gui/pluginwidget.cpp \
+    gui/savescheduler.cpp \
     gui/shortcutbutton.cpp \
     gui/shortcutdialog.cpp \
     gui/shortcutswidget.cpp \
     gui/tabbar.cpp \
     gui/tabdialog.cpp \
+    gui/tabresidencymanager.cpp \
     gui/tabtree.cpp \
     gui/tabwidget.cpp \
     gui/traymenu.cpp \
+    item/blobstore.cpp \
     item/clipboarditem.cpp \
     item/clipboardmodel.cpp \
     item/itemdelegate.cpp \
@@ -187,6 +208,7 @@ SOURCES += \
     item/itemeditorwidget.cpp \
     item/itemfactory.cpp \
     item/itemwidget.cpp \
+    item/pagedtexteditor.cpp \
     item/persistentdisplayitem.cpp \
     item/serialize.cpp \
     main.cpp \
@@ -50,6 +50,9 @@ public:
     /// Stop GUI server and return true if server is was stopped or is not running.
     virtual QByteArray stopServer() = 0;
 
+    /// Wait for GUI server to quit by itself (e.g. after a simulated crash).
+    virtual QByteArray waitForServerToQuit() = 0;
+
     /// Return true if GUI server is not running.
     virtual bool isServerRunning() = 0;
 
@@ -21,22 +21,30 @@
 #include "test_utils.h"
 
 #include "common/client_server.h"
+#include "common/clipboarddatalimits.h"
 #include "common/common.h"
+#include "common/contenttype.h"
 #include "common/mimetypes.h"
 #include "common/shortcuts.h"
 #include "common/textdata.h"
 #include "common/version.h"
+#include "item/blobstore.h"
+#include "item/clipboardmodel.h"
 #include "item/itemfactory.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
 #include "gui/configtabshortcuts.h"
 
 #include <QApplication>
+#include <QBuffer>
 #include <QClipboard>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QDir>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QImage>
 #include <QMap>
 #include <QMimeData>
 #include <QProcess>
@@ -239,6 +247,14 @@ public:
         return waitForAnyServerToQuit();
     }
 
+    QByteArray waitForServerToQuit() override
+    {
+        if ( m_server != nullptr && !m_server->waitForFinished(8000) )
+            return "Server is still running!" + readServerErrors(ReadAllStderr);
+
+        return waitForAnyServerToQuit();
+    }
+
     bool isServerRunning() override
     {
         return m_server != nullptr && m_server->state() == QProcess::Running && isAnyServerRunning();
@@ -654,6 +670,41 @@ void Tests::commandEvalArguments()
         "Test 1, Test 2\n");
 }
 
+void Tests::commandEvalInServer()
+{
+    RUN("--in-server" << "eval" << "str(arguments[1]) + ', ' + str(arguments[2])" << "Test 1" << "Test 2",
+        "Test 1, Test 2\n");
+
+    QByteArray stdoutActual;
+    QByteArray stderrActual;
+    QCOMPARE( run(Args("--in-server") << "eval" << "str(input())", &stdoutActual, &stderrActual, "TEST"), 0 );
+    QVERIFY2( testStderr(stderrActual), stderrActual );
+    QCOMPARE( stdoutActual, QByteArray("TEST\n") );
+
+    RUN("--in-server" << "tab" << testTab(1) << "add" << "A" << "B", "");
+    RUN("--in-server" << "tab" << testTab(1) << "read" << "0" << "1", "B\nA");
+
+    RUN_EXPECT_ERROR_WITH_STDERR(
+                "--in-server" << "setEnv" << "COPYQ_TEST_VARIABLE" << "1",
+                CommandException, "not available in server");
+
+    // Script does not block server while it runs (here waiting for a command started by server).
+    const QString script =
+            "var t = str(arguments[1]); tab(t);"
+            "action('copyq tab \"' + t + '\" add done');"
+            "var start = Date.now();"
+            "while (size() == 0 && Date.now() - start < 10000) {}"
+            "size()";
+    RUN("--in-server" << "eval" << script << testTab(2), "1\n");
+
+    // Script is aborted after timeout.
+    RUN("config" << "in_server_script_timeout" << "1", "1\n");
+    RUN_EXPECT_ERROR_WITH_STDERR(
+                "--in-server" << "eval" << "while (true) {}",
+                CommandException, "timed out");
+    m_test->readServerErrors(TestInterface::ReadAllStderr);
+}
+
 void Tests::commandPrint()
 {
     RUN("print" << "1", "1");
@@ -804,6 +855,9 @@ void Tests::commandChange()
 
     RUN("change(1, 'text/html', undefined)", "");
     RUN("read" << "?" << "1", "text/plain\n");
+
+    TEST( m_test->runClient(Args() << "change" << "1" << "text/plain" << "-", "", "X") );
+    RUN("separator" << " " << "read" << "0" << "1" << "2", "A X C");
 }
 
 void Tests::commandSetCurrentTab()
@@ -1541,6 +1595,19 @@ void Tests::editNotes()
     RUN("read" << mimeText << "0" << mimeItemNotes << "0" << "F2", "A\nA Note");
 }
 
+void Tests::editBigItem()
+{
+    RUN("config" << "paged_editor_threshold" << "1", "1\n");
+
+    // Text spans multiple editor pages.
+    RUN("eval" << "var text = ''; for (var i = 0; i < 40000; ++i) text += 'Line ' + i + '\\n'; add(text)", "");
+    RUN("eval" << "var text = str(read(0)); print(text.length + ' ' + text.slice(-11))", "428890 Line 39999\n");
+
+    RUN("keys" << "F2" << "CTRL+HOME" << ":Edited " << "F2", "");
+    RUN("eval" << "var text = str(read(0)); print(text.length + ' ' + text.slice(0, 13) + ' ' + text.slice(-11))",
+        "428897 Edited Line 0 Line 39999\n");
+}
+
 void Tests::toggleClipboardMonitoring()
 {
     const QByteArray data1 = generateData();
@@ -1609,6 +1676,183 @@ void Tests::itemToClipboard()
     RUN("clipboard", "TESTING1");
 }
 
+void Tests::clipboardDataLimitsParse()
+{
+    const auto limits = parseClipboardDataLimits(
+                "text/*=10M:truncate, *=100:file\n"
+                "image/png=2K:HASH, invalid, x=1Q:skip, y=1:unknown");
+    QCOMPARE( limits.size(), 3 );
+
+    QVERIFY( limits[0].format.exactMatch("text/plain") );
+    QVERIFY( !limits[0].format.exactMatch("image/png") );
+    QCOMPARE( limits[0].maxSize, 10LL * 1024 * 1024 );
+    QVERIFY( limits[0].policy == ClipboardDataPolicy::Truncate );
+
+    QVERIFY( limits[1].format.exactMatch("image/png") );
+    QCOMPARE( limits[1].maxSize, 100LL );
+    QVERIFY( limits[1].policy == ClipboardDataPolicy::StoreToFile );
+
+    QVERIFY( limits[2].format.exactMatch("IMAGE/PNG") );
+    QCOMPARE( limits[2].maxSize, 2048LL );
+    QVERIFY( limits[2].policy == ClipboardDataPolicy::Hash );
+
+    QVERIFY( parseClipboardDataLimits(QString()).isEmpty() );
+}
+
+void Tests::clipboardDataLimitsUtf8Boundary()
+{
+    QCOMPARE( utf8Boundary("abc", 0), 0 );
+    QCOMPARE( utf8Boundary("abc", 2), 2 );
+
+    const QByteArray twoBytes = "a\xc3\xa1" "b";
+    QCOMPARE( utf8Boundary(twoBytes, 1), 1 );
+    QCOMPARE( utf8Boundary(twoBytes, 2), 1 );
+    QCOMPARE( utf8Boundary(twoBytes, 3), 3 );
+
+    const QByteArray threeBytes = "\xe2\x82\xac" "b";
+    QCOMPARE( utf8Boundary(threeBytes, 1), 0 );
+    QCOMPARE( utf8Boundary(threeBytes, 2), 0 );
+    QCOMPARE( utf8Boundary(threeBytes, 3), 3 );
+
+    const QByteArray fourBytes = "\xf0\x9f\x98\x80" "b";
+    QCOMPARE( utf8Boundary(fourBytes, 3), 0 );
+    QCOMPARE( utf8Boundary(fourBytes, 4), 4 );
+}
+
+void Tests::clipboardDataLimitsPolicies()
+{
+    const auto limits = parseClipboardDataLimits(
+                "text/plain=4:truncate, text/html=4:file, image/png=4:hash,"
+                "application/x-big=4:skip, *=100:skip");
+    QCOMPARE( limits.size(), 5 );
+
+    const QByteArray html = "<b>big</b>";
+    const QByteArray htmlDigest = QCryptographicHash::hash(html, QCryptographicHash::Sha1).toHex();
+    const QByteArray image = "PNG DATA";
+    const QByteArray imageDigest = QCryptographicHash::hash(image, QCryptographicHash::Sha1).toHex();
+    const QByteArray internalFormat = COPYQ_MIME_PREFIX "test";
+
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("abc\xc3\xa1") );
+    data.insert( mimeHtml, html );
+    data.insert( "image/png", image );
+    data.insert( "application/x-big", QByteArray("12345") );
+    data.insert( mimeUriList, QByteArray("short") );
+    data.insert( internalFormat, QByteArray(1000, 'x') );
+    applyClipboardDataLimits(limits, &data);
+
+    QCOMPARE( data.value(mimeText).toByteArray(), QByteArray("abc") );
+    QCOMPARE( data.value(mimeHtml).toByteArray(), html );
+    QCOMPARE( data.value(mimeDataFiles).toByteArray(), QByteArray(mimeHtml) + "\t\n" );
+    QVERIFY( !data.contains("image/png") );
+    QCOMPARE( data.value(mimeDataHashes).toByteArray(), QByteArray("image/png\t") + imageDigest + '\n' );
+    QVERIFY( !data.contains("application/x-big") );
+    QCOMPARE( data.value(mimeUriList).toByteArray(), QByteArray("short") );
+    QCOMPARE( data.value(internalFormat).toByteArray(), QByteArray(1000, 'x') );
+
+    // Data are stored in the server once the item is added.
+    QDir blobDir( QDir::tempPath() + "/copyq_test_blobs" );
+    for ( const auto &fileName : blobDir.entryList(QDir::Files) )
+        QVERIFY( blobDir.remove(fileName) );
+    BlobStore store( blobDir.absolutePath() );
+
+    store.storeDataFiles(&data);
+    QVERIFY( !data.contains(mimeHtml) );
+    QCOMPARE( data.value(mimeDataFiles).toByteArray(), QByteArray(mimeHtml) + '\t' + htmlDigest + '\n' );
+
+    const QString blobPath = blobDir.absoluteFilePath( QString::fromLatin1(htmlDigest) );
+    QVERIFY( QFile::exists(blobPath) );
+
+    QVariantMap loadedData = data;
+    store.loadDataFiles(&loadedData);
+    QCOMPARE( loadedData.value(mimeHtml).toByteArray(), html );
+
+    // Data are kept only while a tab references them or until next session.
+    TabBlobReferences blobs(&store);
+    addDataFileReferences(data, &blobs);
+    blobs.commit("test");
+    store.removeUnsavedReferences();
+    QVERIFY( QFile::exists(blobPath) );
+    store.removeReferences("test");
+    QVERIFY( !QFile::exists(blobPath) );
+
+    // Data are loaded only from the store.
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    file.write(html);
+    file.close();
+    for ( const auto &path : {file.fileName(), QString("../") + QString::fromLatin1(htmlDigest)} ) {
+        QVariantMap data2;
+        data2.insert( mimeDataFiles, QByteArray(mimeHtml) + '\t' + path.toUtf8() + '\n' );
+        store.loadDataFiles(&data2);
+        QVERIFY( !data2.contains(mimeHtml) );
+    }
+}
+
+void Tests::clipboardImageConversion()
+{
+    QImage image(16, 8, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    QByteArray png;
+    {
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY( image.save(&buffer, "PNG") );
+    }
+
+    RUN_WITH_INPUT("copy" << "image/png" << "-", "true\n", png);
+    WAIT_FOR_CLIPBOARD2(png, "image/png");
+
+    // Other formats are converted from PNG only when requested.
+    RUN("hasClipboardFormat" << "application/x-qt-image", "true\n");
+
+    QByteArray bmp;
+    TEST( m_test->getClientOutput(Args("clipboard") << "image/bmp", &bmp) );
+    const QImage bmpImage = QImage::fromData(bmp, "BMP");
+    QCOMPARE( bmpImage.size(), image.size() );
+    QCOMPARE( bmpImage.pixel(0, 0), image.pixel(0, 0) );
+}
+
+void Tests::clipboardImageConversionCache()
+{
+    QImage image(16, 8, QImage::Format_RGB32);
+    image.fill(Qt::green);
+    QByteArray png;
+    {
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY( image.save(&buffer, "PNG") );
+    }
+
+    QVariantMap data;
+    data.insert("image/png", png);
+    std::unique_ptr<QMimeData> mimeData( createMimeData(data) );
+
+    QVERIFY( mimeData->formats().contains("application/x-qt-image") );
+    QVERIFY( mimeData->hasFormat("application/x-qt-image") );
+    QCOMPARE( mimeData->imageData().value<QImage>().size(), image.size() );
+    QCOMPARE( mimeData->data("image/png"), png );
+
+    const QByteArray bmp = mimeData->data("image/bmp");
+    QCOMPARE( QImage::fromData(bmp, "BMP").size(), image.size() );
+
+    // Converted data are cached.
+    QVERIFY( mimeData->data("image/bmp").constData() == bmp.constData() );
+
+    const QByteArray ppm = mimeData->data("image/ppm");
+    QVERIFY( !ppm.isEmpty() );
+    QVERIFY( mimeData->data("image/bmp").constData() == bmp.constData() );
+    QVERIFY( mimeData->data("image/ppm").constData() == ppm.constData() );
+
+    // Only two conversions are kept; the oldest is dropped.
+    const QByteArray xpm = mimeData->data("image/xpm");
+    QVERIFY( !xpm.isEmpty() );
+    QVERIFY( mimeData->data("image/ppm").constData() == ppm.constData() );
+    const QByteArray bmp2 = mimeData->data("image/bmp");
+    QCOMPARE( bmp2, bmp );
+    QVERIFY( bmp2.constData() != bmp.constData() );
+}
+
 void Tests::tabAdd()
 {
     const QString tab = testTab(1);
@@ -1656,6 +1900,190 @@ void Tests::tabIcon()
     RUN("tabicon" << tab, "\n");
 }
 
+void Tests::tabMemoryUsage()
+{
+    const QString tab = testTab(1);
+    RUN("tab" << tab << "add" << "A" << "B", "");
+
+    const QString script = QString(
+            "var t = tabMemoryUsage();"
+            "for (var i in t)"
+            "  if (t[i].name == '%1') print([t[i].loaded, t[i].items, t[i].bytes > 0].join(','))"
+            ).arg(tab);
+    RUN("eval" << script, "true,2,true");
+}
+
+void Tests::tabsMemoryLimit()
+{
+    const QString tab1 = testTab(1);
+    const QString tab2 = testTab(2);
+
+    const QByteArray in(700 * 1024, 'x');
+    QCOMPARE( run(Args("tab") << tab1 << "add" << "-", nullptr, nullptr, in), 0 );
+    QCOMPARE( run(Args("tab") << tab2 << "add" << "-", nullptr, nullptr, in + "y"), 0 );
+    RUN("eval" << "saveTabs()", "");
+
+    const QString script = QString(
+            "var t = tabMemoryUsage();"
+            "var loaded = {};"
+            "for (var i in t) loaded[t[i].name] = t[i].loaded;"
+            "print([loaded['%1'], loaded['%2']].join(','))"
+            ).arg(tab1, tab2);
+    RUN("eval" << script, "true,true");
+
+    // Least recently used hidden tab is unloaded to get under the limit.
+    RUN("config" << "tabs_memory_limit" << "1", "1\n");
+    WAIT_ON_OUTPUT("eval" << script, "false,true");
+}
+
+void Tests::saveTabs()
+{
+    const Args args = Args("tab") << testTab(1) << "separator" << ",";
+
+    RUN(args << "add" << "C" << "B" << "A", "");
+    RUN("eval" << "saveTabs()", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    RUN(args << "read" << "0" << "1" << "2", "A,B,C");
+}
+
+void Tests::saveTabsCrashConsistency()
+{
+    qsrand(1);
+
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab;
+
+    // Items with big data are stored in separate files.
+    const auto bigItem = [](int i) {
+        return QString("big %1 ").arg(i).toUtf8() + QByteArray(32 * 1024 + i, 'x');
+    };
+
+    for (int i = 0; i < 4; ++i) {
+        QCOMPARE( run(Args(args) << "add" << "-", nullptr, nullptr, bigItem(i)), 0 );
+        RUN(args << "add" << QString("small %1").arg(i), "");
+    }
+    RUN("eval" << "saveTabs()", "");
+
+    const QString script = QString(
+            "tab('%1');"
+            "var items = [];"
+            "for (var i = 0; i < size(); ++i) {"
+            "  var text = str(read(i));"
+            "  items.push(text.length + ':' + text.substr(0, 8));"
+            "}"
+            "print(items.join(','))"
+            ).arg(tab);
+
+    QByteArray savedItems;
+    QCOMPARE( run(Args("eval") << script, &savedItems), 0 );
+
+    for (int i = 0; i < 6; ++i) {
+        // Server exits after writing random number of bytes of the changed tab.
+        RUN("simulateTabWriteCrash" << QString::number(qrand() % 1024), "");
+        QCOMPARE( run(Args(args) << "remove" << QString::number(qrand() % 8)), 0 );
+        QCOMPARE( run(Args(args) << "add" << "-", nullptr, nullptr, bigItem(10 + i)), 0 );
+        // The client can fail if the server exits before replying.
+        run(Args("eval") << "saveTabs()");
+        TEST( m_test->waitForServerToQuit() );
+        QVERIFY( m_test->readServerErrors(TestInterface::ReadAllStderr).contains("Simulated crash") );
+
+        TEST( m_test->startServer() );
+
+        // Items and their data are the same as after the last successful save.
+        QByteArray items;
+        QCOMPARE( run(Args("eval") << script, &items), 0 );
+        QCOMPARE( QString::fromUtf8(items), QString::fromUtf8(savedItems) );
+
+        RUN(args << "remove" << "0", "");
+        QCOMPARE( run(Args(args) << "add" << "-", nullptr, nullptr, bigItem(20 + i)), 0 );
+        RUN("eval" << "saveTabs()", "");
+        QCOMPARE( run(Args("eval") << script, &savedItems), 0 );
+    }
+
+    // Only undamaged items are loaded from truncated or corrupted tab file.
+    QByteArray configPath;
+    QCOMPARE( run(Args("info") << "config", &configPath), 0 );
+    const QString tabFileName =
+            QString::fromUtf8(configPath).trimmed().replace( QRegExp("\\.ini$"), "_tab_" )
+            + QString( tab.toUtf8().toBase64() ).replace( QChar('/'), QChar('-') )
+            + ".dat";
+
+    const QStringList savedItemList = QString::fromUtf8(savedItems).split(',');
+    for (int i = 0; i < 4; ++i) {
+        TEST( m_test->stopServer() );
+
+        QFile tabFile(tabFileName);
+        QVERIFY( tabFile.open(QIODevice::ReadOnly) );
+        QByteArray bytes = tabFile.readAll();
+        tabFile.close();
+        QVERIFY( bytes.size() > 8 );
+
+        // Skip format marker and item count.
+        if (i % 2 == 0) {
+            bytes.truncate( 8 + qrand() % (bytes.size() - 8) );
+        } else {
+            const int pos = 8 + qrand() % (bytes.size() - 8);
+            bytes[pos] = static_cast<char>(bytes[pos] ^ (1 + qrand() % 255));
+        }
+
+        QVERIFY( tabFile.open(QIODevice::WriteOnly | QIODevice::Truncate) );
+        QCOMPARE( tabFile.write(bytes), static_cast<qint64>(bytes.size()) );
+        tabFile.close();
+
+        TEST( m_test->startServer() );
+
+        QByteArray items;
+        QCOMPARE( run(Args("eval") << script, &items), 0 );
+        m_test->readServerErrors(TestInterface::ReadAllStderr);
+
+        const QStringList itemList = items.isEmpty()
+                ? QStringList() : QString::fromUtf8(items).split(',');
+        QVERIFY( itemList.size() <= savedItemList.size() );
+        QCOMPARE( itemList, savedItemList.mid(0, itemList.size()) );
+    }
+
+    // Items for testing damaged data.
+    ClipboardModel model;
+    QStringList texts;
+    for (int i = 0; i < 20; ++i) {
+        texts.append( QString("item %1 ").arg(i) + QString(qrand() % 200, 'x') );
+        model.insertRow(i);
+        model.setData( model.index(i, 0), createDataMap(mimeText, texts[i]), contentType::data );
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY( serializeData(model, &buffer) );
+    const QByteArray newBytes = buffer.data();
+
+    // Only undamaged items are loaded from truncated or corrupted data.
+    for (int i = 0; i < 50; ++i) {
+        QByteArray bytes = newBytes;
+        if (i % 2 == 0) {
+            bytes.truncate( qrand() % bytes.size() );
+        } else {
+            // Skip format marker and item count.
+            const int pos = 8 + qrand() % (bytes.size() - 8);
+            bytes[pos] = static_cast<char>(bytes[pos] ^ (1 + qrand() % 255));
+        }
+
+        QBuffer damagedBuffer(&bytes);
+        damagedBuffer.open(QIODevice::ReadOnly);
+        ClipboardModel damagedModel;
+        if ( !deserializeData(&damagedModel, &damagedBuffer, texts.size()) )
+            continue;
+
+        QVERIFY( damagedModel.rowCount() <= texts.size() );
+        for (int row = 0; row < damagedModel.rowCount(); ++row) {
+            const QVariantMap data = damagedModel.data( damagedModel.index(row, 0), contentType::data ).toMap();
+            QCOMPARE( getTextData(data), texts[row] );
+        }
+    }
+}
+
 void Tests::action()
 {
     const Args args = Args("tab") << testTab(1);
@@ -1681,6 +2109,32 @@ void Tests::action()
     RUN(argsAction << action.arg("read 0") << ",", "");
     WAIT_ON_OUTPUT(args << "size", "6\n");
     RUN(args << "read" << "0" << "1" << "2", "C\nB\nA");
+
+    // action with pipe between built-in commands
+    RUN(argsAction << action.arg("read 2") + " | " + action.arg("add -") << "", "");
+    WAIT_ON_OUTPUT(args << "size", "7\n");
+    RUN(args << "read" << "0", "A");
+}
+
+void Tests::actionHistory()
+{
+    const Args args = Args("tab") << testTab(1);
+    const QString action = QString("copyq %1 eval 'print(\"ABC\")'").arg(args.join(" "));
+
+    RUN(Args(args) << "action" << action << "", "");
+    WAIT_ON_OUTPUT(args << "size", "1\n");
+
+    const QString script =
+            "var h = actionHistory()[0];"
+            "print([h.exitCode, h.failed, h.bytesIn, h.bytesOut, h.wallTime >= 0].join(','))";
+    WAIT_ON_OUTPUT("eval" << script, "0,false,0,3,true");
+
+    // Data passed between commands in a pipe are not counted.
+    const QString pipe = QString("copyq %1 eval 'print(\"ABC\")' | copyq %1 eval 'print(str(input()) + \"D\")'")
+            .arg(args.join(" "));
+    RUN(Args(args) << "action" << pipe << "", "");
+    WAIT_ON_OUTPUT(args << "size", "2\n");
+    WAIT_ON_OUTPUT("eval" << script, "0,false,0,4,true");
 }
 
 void Tests::insertRemoveItems()
@@ -1702,6 +2156,96 @@ void Tests::insertRemoveItems()
     RUN(args << "read" << "0" << "1" << "2" << "3" << "4", "abc,ABC,ghi,,");
 }
 
+void Tests::insertRemoveBigItem()
+{
+    const Args args = Args("tab") << testTab(1);
+
+    // Big messages are passed between client and server in files.
+    const QByteArray in(4 * 1024 * 1024, 'x');
+    QCOMPARE( run(Args(args) << "insert" << "0" << "-", nullptr, nullptr, in), 0);
+    RUN(args << "size", "1\n");
+
+    QByteArray out;
+    QCOMPARE( run(Args(args) << "read" << "0", &out), 0);
+    QCOMPARE( out.size(), in.size() );
+    QVERIFY( out == in );
+
+    RUN(args << "remove" << "0", "");
+    RUN(args << "size", "0\n");
+
+    // Standard input is passed to server in chunks.
+    const QString mime = COPYQ_MIME_PREFIX "test";
+    QCOMPARE( run(Args(args) << "write" << mime << "-", nullptr, nullptr, in), 0);
+    QCOMPARE( run(Args(args) << "read" << mime << "0", &out), 0);
+    QVERIFY( out == in );
+    RUN(args << "read" << "?" << "0", (mime + "\n").toUtf8());
+
+    // Big message from client to server.
+    RUN(args << "eval" << QString("add(new Array(%1 + 1).join('y'))").arg(in.size()), "");
+    RUN(args << "eval" << "str(read(0)).length", QString::number(in.size()) + "\n");
+    RUN(args << "eval" << "str(read(0)).replace(/y/g, '')", "\n");
+}
+
+void Tests::bigItemInMultipleTabs()
+{
+    const Args args1 = Args("tab") << testTab(1);
+    const Args args2 = Args("tab") << testTab(2);
+
+    // Big data are stored only once and shared by tabs.
+    const QByteArray in(1024 * 1024, 'x');
+    QCOMPARE( run(Args(args1) << "add" << "-", nullptr, nullptr, in), 0);
+    QCOMPARE( run(Args(args2) << "add" << "-", nullptr, nullptr, in), 0);
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    // Removing tab must not remove data used in other tab.
+    RUN("removetab" << testTab(1), "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    QByteArray out;
+    QCOMPARE( run(Args(args2) << "read" << "0", &out), 0);
+    QCOMPARE( out.size(), in.size() );
+    QVERIFY( out == in );
+}
+
+void Tests::removeBigItemWithFailedSave()
+{
+    const Args args = Args("tab") << testTab(1);
+
+    const QByteArray in(1024 * 1024, 'x');
+    QCOMPARE( run(Args(args) << "add" << "-", nullptr, nullptr, in), 0);
+    RUN(args << "add" << "small", "");
+    RUN("eval" << "saveTabs()", "");
+
+    // Writing tab without the big item fails.
+    RUN("simulateTabWriteCrash" << "0", "");
+    QCOMPARE( run(Args(args) << "remove" << "1"), 0 );
+    QCOMPARE( run(Args("eval") << "saveTabs()"), 0 );
+    QCOMPARE( run(Args("simulateTabWriteCrash") << "0"), 0 );
+    QVERIFY( m_test->readServerErrors(TestInterface::ReadAllStderr).contains("Simulated crash") );
+
+    // Saving tab on exit fails too.
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    // Data referenced from the last written tab file must not be removed.
+    RUN(args << "size", "2\n");
+    QByteArray out;
+    QCOMPARE( run(Args(args) << "read" << "1", &out), 0);
+    QCOMPARE( out.size(), in.size() );
+    QVERIFY( out == in );
+
+    RUN(args << "remove" << "1", "");
+    RUN("eval" << "saveTabs()", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "size", "1\n");
+    RUN(args << "read" << "0", "small");
+}
+
 void Tests::renameTab()
 {
     const QString tab1 = testTab(1);
@@ -1976,6 +2520,26 @@ void Tests::openAndSavePreferences()
     RUN("config" << "check_clipboard", "true\n");
 }
 
+void Tests::openPreferencesAppearance()
+{
+#ifdef Q_OS_MAC
+    SKIP("Can't switch configuration tabs with keyboard on OS X");
+#endif
+
+    RUN("add" << "A", "");
+
+    // Open preferences dialog.
+    RUN("keys" << ConfigTabShortcuts::tr("Ctrl+P"), "");
+
+    // Show last tab (Appearance) with preview of items and show it again
+    // so the preview is recreated.
+    RUN("keys" << "CTRL+PGUP" << "CTRL+PGDOWN" << "CTRL+PGUP", "");
+
+    // Close the dialog (destroys the preview).
+    RUN("keys" << "ESCAPE", "");
+    RUN("read" << "0", "A");
+}
+
 void Tests::pasteFromMainWindow()
 {
     RUN("config"
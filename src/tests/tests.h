@@ -53,6 +53,7 @@ private slots:
     void commandEvalThrows();
     void commandEvalSyntaxError();
     void commandEvalArguments();
+    void commandEvalInServer();
     void commandPrint();
     void commandAbort();
     void commandFail();
@@ -141,16 +142,30 @@ private slots:
     void editItems();
     void createNewItem();
     void editNotes();
+    void editBigItem();
 
     void toggleClipboardMonitoring();
 
     void clipboardToItem();
     void itemToClipboard();
+    void clipboardDataLimitsParse();
+    void clipboardDataLimitsUtf8Boundary();
+    void clipboardDataLimitsPolicies();
+    void clipboardImageConversion();
+    void clipboardImageConversionCache();
     void tabAdd();
     void tabRemove();
     void tabIcon();
+    void tabMemoryUsage();
+    void tabsMemoryLimit();
+    void saveTabs();
+    void saveTabsCrashConsistency();
     void action();
+    void actionHistory();
     void insertRemoveItems();
+    void insertRemoveBigItem();
+    void bigItemInMultipleTabs();
+    void removeBigItemWithFailedSave();
     void renameTab();
     void importExportTab();
 
@@ -163,6 +178,7 @@ private slots:
     void nextPreviousTab();
 
     void openAndSavePreferences();
+    void openPreferencesAppearance();
 
     void pasteFromMainWindow();
 
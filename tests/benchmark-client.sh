@@ -0,0 +1,54 @@
+#!/bin/bash
+# Measure number of client invocations per second.
+# Compares simple commands handled directly by server (fast client path)
+# with the same commands run by script engine in client.
+# Server must be already running.
+# usage: [count=200] [tab=benchmark] ./benchmark-client.sh [copyq]
+copyq=${1:-copyq}
+count=${count:-200}
+tab=${tab:-benchmark}
+
+set -e
+
+run() {
+    "$copyq" "$@"
+}
+
+now() {
+    date +%s.%N
+}
+
+# usage: benchmark {label} {command...}
+benchmark() {
+    local label=$1
+    shift
+
+    local start end
+    start=$(now)
+    for _ in $(seq "$count"); do
+        "$@" > /dev/null
+    done
+    end=$(now)
+
+    awk -v label="$label" -v count="$count" -v start="$start" -v end="$end" \
+        'BEGIN { printf "%-32s %8.1f calls/s\n", label, count / (end - start) }'
+}
+
+if ! run size &>/dev/null; then
+    echo "Server is not running!" 1>&2
+    exit 1
+fi
+
+run removetab "$tab" &>/dev/null || true
+run tab "$tab" add "item" > /dev/null
+
+benchmark "size (fast)" run tab "$tab" size
+benchmark "size (script)" run eval -- "tab('$tab'); size()"
+
+benchmark "read (fast)" run tab "$tab" read 0
+benchmark "read (script)" run eval -- "tab('$tab'); read(0)"
+
+benchmark "add (fast)" run tab "$tab" add "item"
+benchmark "add (script)" run eval -- "tab('$tab'); add('item')"
+
+run removetab "$tab"
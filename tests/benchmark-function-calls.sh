@@ -0,0 +1,54 @@
+#!/bin/bash
+# Measure overhead of calling server functions from client script.
+# Compares typed function calls with QVariant-based function calls
+# (used with servers which don't support the typed ones).
+# Server must be already running.
+# usage: [count=2000] [tab=benchmark] ./benchmark-function-calls.sh [copyq]
+copyq=${1:-copyq}
+count=${count:-2000}
+tab=${tab:-benchmark}
+
+set -e
+
+run() {
+    "$copyq" "$@"
+}
+
+now() {
+    date +%s.%N
+}
+
+# usage: benchmark {label} {script}
+benchmark() {
+    local label=$1
+    local script=$2
+
+    local start end
+    for legacy in 0 1; do
+        start=$(now)
+        COPYQ_LEGACY_FUNCTION_CALLS=$legacy \
+            run eval -- "tab('$tab'); for (var i = 0; i < $count; ++i) { $script }" > /dev/null
+        end=$(now)
+
+        awk -v label="$label" -v legacy="$legacy" -v count="$count" -v start="$start" -v end="$end" \
+            'BEGIN {
+                printf "%-24s %-8s %8.1f us/call\n",
+                    label, (legacy == "1" ? "variant" : "typed"), (end - start) * 1000000 / count
+            }'
+    done
+}
+
+if ! run size &>/dev/null; then
+    echo "Server is not running!" 1>&2
+    exit 1
+fi
+
+run removetab "$tab" &>/dev/null || true
+run tab "$tab" add "item" > /dev/null
+
+benchmark "size()" "size()"
+benchmark "read(0)" "read(0)"
+benchmark "tab()" "tab()"
+benchmark "config()" "config('maxitems')"
+
+run removetab "$tab"
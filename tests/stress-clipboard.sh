@@ -0,0 +1,251 @@
+#!/bin/bash
+# Stress test clipboard monitoring with automatic commands and clients.
+# Starts new server session which receives bursts of synthetic clipboard
+# changes while multiple clients read and add items and run scripts.
+# Prints throughput, latency from clipboard change to stored item, missing
+# items and memory usage of the server over time.
+# Requires CopyQ built with dummy platform (CMake flag -DWITH_DUMMY_PLATFORM=ON
+# or QMake flag CONFIG+=dummy_platform) which generates the clipboard changes.
+# usage: [count=500] [interval=100] [size=1024] [formats=text/plain,text/html,...]
+#        [clients=4] [commands=3] [session=stress] [out=DIR] ./stress-clipboard.sh [copyq]
+copyq=${1:-copyq}
+count=${count:-500}
+interval=${interval:-100}
+size=${size:-1024}
+formats=${formats:-text/plain,text/html,application/x-copyq-load}
+clients=${clients:-4}
+commands=${commands:-3}
+session=${session:-stress}
+out=${out:-$(mktemp -d)}
+
+tab=load
+clients_tab=load-clients
+stored_format=application/x-copyq-load-stored
+load_delay=1000
+
+export QT_QPA_PLATFORM=${QT_QPA_PLATFORM:-offscreen}
+
+set -e
+
+run() {
+    "$copyq" -s "$session" "$@"
+}
+
+now() {
+    date +%s%3N
+}
+
+is_server_running() {
+    run size &>/dev/null
+}
+
+start_server() {
+    "$copyq" -s "$session" &>> "$out/server.log" &
+    server_pid=$!
+
+    for _ in $(seq 50); do
+        is_server_running && return 0
+        sleep 0.1
+    done
+
+    echo "Failed to start server!" 1>&2
+    exit 1
+}
+
+stop_server() {
+    run exit &>/dev/null || true
+    wait "$server_pid" 2>/dev/null || true
+}
+
+# usage: sample_memory > {file}
+# Prints "{elapsed ms} {resident memory KiB}" every second.
+sample_memory() {
+    while kill -0 "$server_pid" 2>/dev/null; do
+        rss=$(awk '/^VmRSS:/ {print $2}' "/proc/$server_pid/status" 2>/dev/null || true)
+        echo "$(( $(now) - start )) ${rss:-0}"
+        sleep 1
+    done
+}
+
+# usage: run_client {id} > {file}
+# Prints "{call duration ms} {exit code}" for each call.
+run_client() {
+    local id=$1
+    local i=0
+    local call_start exit_code
+    while [ ! -e "$out/done" ]; do
+        call_start=$(now)
+        exit_code=0
+        case $((i % 4)) in
+            0) run tab "$clients_tab" add "client $id item $i" ;;
+            1) run tab "$clients_tab" read 0 ;;
+            2) run tab "$tab" size ;;
+            3) run eval -- "tab('$tab'); var n = size(); for (var j = 0; j < n && j < 10; ++j) str(read(j)); n" ;;
+        esac > /dev/null 2>&1 || exit_code=$?
+        echo "$(( $(now) - call_start )) $exit_code"
+        i=$((i + 1))
+    done
+}
+
+# usage: percentile {percent} {sorted file}
+percentile() {
+    awk -v p="$1" '
+        { a[NR] = $1 }
+        END {
+            if (NR == 0) { print "-"; exit }
+            i = int(NR * p / 100 + 0.5)
+            if (i < 1) i = 1
+            print a[i]
+        }' "$2"
+}
+
+# usage: report {label} {format} {value}
+report() {
+    printf "%-32s $2\n" "$1" "$3"
+}
+
+if is_server_running; then
+    echo "Session \"$session\" is already running!" 1>&2
+    exit 1
+fi
+
+if [ "$count" -gt 10000 ]; then
+    echo "Maximum number of clipboard changes is 10000!" 1>&2
+    exit 1
+fi
+
+mkdir -p "$out"
+rm -f "$out/done"
+
+# Prepare session (automatic commands, tabs) before generating load.
+start_server
+run config clipboard_tab "$tab" > /dev/null
+run config maxitems 10000 > /dev/null
+run removetab "$tab" &>/dev/null || true
+run removetab "$clients_tab" &>/dev/null || true
+run eval -- "
+    var commands = [];
+    for (var i = 0; i < $commands; ++i)
+        commands.push({name: 'load ' + i, automatic: true, cmd: 'copyq: str(data(mimeText)).length'});
+    // Last command stamps the time just before item is stored.
+    commands.push({name: 'stamp', automatic: true,
+        cmd: 'copyq: setData(\"$stored_format\", String(Date.now()))'});
+    setCommands(commands);
+    " > /dev/null
+stop_server
+
+export COPYQ_DUMMY_CLIPBOARD_LOAD=$count
+export COPYQ_DUMMY_CLIPBOARD_LOAD_INTERVAL=$interval
+export COPYQ_DUMMY_CLIPBOARD_LOAD_DELAY=$load_delay
+export COPYQ_DUMMY_CLIPBOARD_LOAD_SIZE=$size
+export COPYQ_DUMMY_CLIPBOARD_LOAD_FORMATS=$formats
+start_server
+unset COPYQ_DUMMY_CLIPBOARD_LOAD
+trap stop_server EXIT
+
+start=$(now)
+sample_memory > "$out/memory.txt" &
+
+client_pids=()
+for id in $(seq "$clients"); do
+    run_client "$id" > "$out/client-$id.txt" &
+    client_pids+=($!)
+done
+
+# Wait for all changes to be stored or until no new items arrive for a while.
+expected_end=$(( start + load_delay + count * interval ))
+stored=0
+idle=0
+while [ "$stored" -lt "$count" ] && [ "$idle" -lt 10 ]; do
+    sleep 1
+    previous=$stored
+    stored=$(run tab "$tab" size 2>/dev/null || echo "$previous")
+    if [ "$stored" = "$previous" ] && [ "$(now)" -gt "$expected_end" ]; then
+        idle=$((idle + 1))
+    else
+        idle=0
+    fi
+done
+end=$(now)
+
+touch "$out/done"
+wait "${client_pids[@]}" 2>/dev/null || true
+
+# Prints "{sequence} {change time} {store time}" for each stored change.
+run eval -- "
+    tab('$tab');
+    for (var i = size() - 1; i >= 0; --i) {
+        var item = getItem(i);
+        var m = str(item[mimeText]).match(/^copyq-load (\\d+) (\\d+)/);
+        if (m)
+            print(m[1] + ' ' + m[2] + ' ' + str(item['$stored_format']) + '\\n');
+    }
+    " > "$out/items.txt"
+
+run eval -- "
+    var t = tabMemoryUsage();
+    for (var i in t)
+        if (t[i].name == '$tab') print(t[i].bytes);
+    " > "$out/tab-memory.txt" || true
+
+stop_server
+trap - EXIT
+
+awk '$3 > 0 {print $3 - $2}' "$out/items.txt" | sort -n > "$out/latency.txt"
+cat "$out"/client-*.txt | awk '{print $1}' | sort -n > "$out/client-latency.txt"
+
+read -r stored unique duplicates last_sequence first_change last_store < <(
+    awk '
+        NR == 1 || $2 < first { first = $2 }
+        NR == 1 || $3 > last { last = $3 }
+        {
+            if ($1 in seen) ++duplicates
+            else ++unique
+            seen[$1] = 1
+            if ($1 > max) max = $1
+        }
+        END { printf "%d %d %d %d %.0f %.0f\n", NR, unique, duplicates, (NR ? max : -1), first, last }
+    ' "$out/items.txt")
+
+# Missing changes followed by stored one were replaced by later change before
+# the clipboard was read; missing changes at the end were never stored.
+merged=$(( last_sequence + 1 - unique ))
+dropped=$(( count - 1 - last_sequence ))
+store_seconds=$(awk -v a="$first_change" -v b="$last_store" 'BEGIN { s = (b - a) / 1000; print (s > 0 ? s : 1) }')
+
+client_calls=$(wc -l < "$out/client-latency.txt")
+client_failures=$(cat "$out"/client-*.txt | awk '$2 != 0' | wc -l)
+client_seconds=$(awk -v a="$start" -v b="$end" 'BEGIN { print (b - a) / 1000 }')
+
+read -r memory_first memory_max memory_last < <(
+    awk '
+        NR == 1 { first = $2 }
+        $2 > max { max = $2 }
+        { last = $2 }
+        END { printf "%d %d %d\n", first, max, last }
+    ' "$out/memory.txt")
+
+report "clipboard changes" "%8d" "$count"
+report "stored items" "%8d" "$unique"
+report "merged changes" "%8d" "$merged"
+report "dropped changes" "%8d" "$dropped"
+report "duplicate items" "%8d" "$duplicates"
+report "throughput" "%8.1f items/s" "$(awk -v n="$unique" -v s="$store_seconds" 'BEGIN { print n / s }')"
+for p in 50 90 99 100; do
+    report "store latency p$p" "%8s ms" "$(percentile "$p" "$out/latency.txt")"
+done
+
+report "client calls" "%8d" "$client_calls"
+report "client failures" "%8d" "$client_failures"
+report "client throughput" "%8.1f calls/s" "$(awk -v n="$client_calls" -v s="$client_seconds" 'BEGIN { print n / s }')"
+for p in 50 90 99 100; do
+    report "client latency p$p" "%8s ms" "$(percentile "$p" "$out/client-latency.txt")"
+done
+
+report "server memory at start" "%8d KiB" "$memory_first"
+report "server memory peak" "%8d KiB" "$memory_max"
+report "server memory at end" "%8d KiB" "$memory_last"
+report "server memory growth" "%8d KiB" "$(( memory_last - memory_first ))"
+report "tab memory usage" "%8s bytes" "$(cat "$out/tab-memory.txt")"
+
+echo "Logs and samples: $out"